@@ -81,76 +81,133 @@ su_agc_finalize(su_agc_t *agc)
  *  7. Output sample
  */
 
-SUCOMPLEX
-su_agc_feed(su_agc_t *agc, SUCOMPLEX x)
-{
-  unsigned int i;
+/*
+ * Magnitudes are computed for a whole chunk first, as they do not depend
+ * on the AGC state. The rest of the loop works on local copies of the
+ * state, which is written back at the end.
+ */
+#define SU_AGC_BULK_CHUNK 256
 
+void
+su_agc_feed_bulk(
+    su_agc_t *agc,
+    const SUCOMPLEX *x,
+    SUCOMPLEX *y,
+    SUSCOUNT len)
+{
+  SUFLOAT mag[SU_AGC_BULK_CHUNK];
+  SUCOMPLEX *delay_line = agc->delay_line;
+  SUFLOAT *mag_history = agc->mag_history;
+  unsigned int delay_line_size = agc->delay_line_size;
+  unsigned int delay_line_ptr = agc->delay_line_ptr;
+  unsigned int mag_history_size = agc->mag_history_size;
+  unsigned int mag_history_ptr = agc->mag_history_ptr;
+  unsigned int hang_n = agc->hang_n;
+  SUFLOAT peak = agc->peak;
+  SUFLOAT fast_level = agc->fast_level;
+  SUFLOAT slow_level = agc->slow_level;
   SUCOMPLEX x_delayed;
-  SUFLOAT x_dBFS;
   SUFLOAT x_dBFS_delayed;
   SUFLOAT peak_delta;
+  SUSCOUNT chunk;
+  SUSCOUNT i;
+  unsigned int j;
+
+  if (!agc->enabled) {
+    for (i = 0; i < len; ++i) {
+      x_delayed = delay_line[delay_line_ptr];
+      delay_line[delay_line_ptr++] = x[i];
+      if (delay_line_ptr >= delay_line_size)
+        delay_line_ptr = 0;
+
+      y[i] = x_delayed;
+    }
 
-  /* Push sample */
-  x_delayed = agc->delay_line[agc->delay_line_ptr];
-
-  agc->delay_line[agc->delay_line_ptr++] = x;
-  if (agc->delay_line_ptr >= agc->delay_line_size)
-    agc->delay_line_ptr = 0;
+    agc->delay_line_ptr = delay_line_ptr;
+    return;
+  }
 
-  if (agc->enabled) {
-    x_dBFS = .5 * SU_DB(x * SU_C_CONJ(x)) - SUFLOAT_MAX_REF_DB;
+  while (len > 0) {
+    chunk = SU_MIN(len, SU_AGC_BULK_CHUNK);
+
+    for (i = 0; i < chunk; ++i)
+      mag[i] = .5 * SU_DB(x[i] * SU_C_CONJ(x[i])) - SUFLOAT_MAX_REF_DB;
+
+    for (i = 0; i < chunk; ++i) {
+      /* Push sample */
+      x_delayed = delay_line[delay_line_ptr];
+      delay_line[delay_line_ptr++] = x[i];
+      if (delay_line_ptr >= delay_line_size)
+        delay_line_ptr = 0;
+
+      /* Push mag */
+      x_dBFS_delayed = mag_history[mag_history_ptr];
+      mag_history[mag_history_ptr++] = mag[i];
+      if (mag_history_ptr >= mag_history_size)
+        mag_history_ptr = 0;
+
+      if (mag[i] > peak)
+        peak = mag[i];
+      else if (peak == x_dBFS_delayed) {
+        /*
+         * We've just removed the peak value from the magnitude history, we
+         * need to recalculate the current peak value.
+         */
+        peak = SUFLOAT_MIN_REF_DB;
+
+        for (j = 0; j < mag_history_size; ++j)
+          if (peak < mag_history[j])
+            peak = mag_history[j];
+      }
 
-    /* Push mag */
-    x_dBFS_delayed = agc->mag_history[agc->mag_history_ptr];
+      /* Update levels for fast averager */
+      peak_delta = peak - fast_level;
+      if (peak_delta > 0)
+        fast_level += agc->fast_alpha_rise * peak_delta;
+      else
+        fast_level += agc->fast_alpha_fall * peak_delta;
+
+      /* Update levels for slow averager */
+      peak_delta = peak - slow_level;
+      if (peak_delta > 0) {
+        slow_level += agc->slow_alpha_rise * peak_delta;
+        hang_n = 0;
+      } else if (hang_n >= agc->hang_max)
+        slow_level += agc->slow_alpha_fall * peak_delta;
+      else
+        ++hang_n;
+
+      /* Keep biggest magnitude */
+      x_dBFS_delayed = SU_MAX(fast_level, slow_level);
+
+      /* Is AGC on? */
+      if (x_dBFS_delayed < agc->knee)
+        x_delayed *= agc->fixed_gain;
+      else
+        x_delayed *= SU_MAG_RAW(x_dBFS_delayed * (agc->gain_slope - 1));
+
+      y[i] = x_delayed * SU_AGC_RESCALE;
+    }
 
-    agc->mag_history[agc->mag_history_ptr++] = x_dBFS;
-    if (agc->mag_history_ptr >= agc->mag_history_size)
-      agc->mag_history_ptr = 0;
+    x   += chunk;
+    y   += chunk;
+    len -= chunk;
+  }
 
-    if (x_dBFS > agc->peak)
-      agc->peak = x_dBFS;
-    else if (agc->peak == x_dBFS_delayed) {
-      /*
-       * We've just removed the peak value from the magnitude history, we
-       * need to recalculate the current peak value.
-       */
-      agc->peak = SUFLOAT_MIN_REF_DB;
+  agc->delay_line_ptr  = delay_line_ptr;
+  agc->mag_history_ptr = mag_history_ptr;
+  agc->hang_n          = hang_n;
+  agc->peak            = peak;
+  agc->fast_level      = fast_level;
+  agc->slow_level      = slow_level;
+}
 
-      for (i = 0; i < agc->mag_history_size; ++i) {
-        if (agc->peak < agc->mag_history[i])
-          agc->peak = agc->mag_history[i];
-      }
-    }
+SUCOMPLEX
+su_agc_feed(su_agc_t *agc, SUCOMPLEX x)
+{
+  SUCOMPLEX y;
 
-    /* Update levels for fast averager */
-    peak_delta = agc->peak - agc->fast_level;
-    if (peak_delta > 0)
-      agc->fast_level += agc->fast_alpha_rise * peak_delta;
-    else
-      agc->fast_level += agc->fast_alpha_fall * peak_delta;
-
-    /* Update levels for slow averager */
-    peak_delta = agc->peak - agc->slow_level;
-    if (peak_delta > 0) {
-      agc->slow_level += agc->slow_alpha_rise * peak_delta;
-      agc->hang_n = 0;
-    } else if (agc->hang_n >= agc->hang_max)
-      agc->slow_level += agc->slow_alpha_fall * peak_delta;
-    else
-      ++agc->hang_n;
-
-    /* Keep biggest magnitude */
-    x_dBFS_delayed = SU_MAX(agc->fast_level, agc->slow_level);
-
-    /* Is AGC on? */
-    if (x_dBFS_delayed < agc->knee)
-      x_delayed *= agc->fixed_gain;
-    else
-      x_delayed *= SU_MAG_RAW(x_dBFS_delayed * (agc->gain_slope - 1));
-
-    x_delayed *= SU_AGC_RESCALE;
-  }
+  su_agc_feed_bulk(agc, &x, &y, 1);
 
-  return x_delayed;
+  return y;
 }
@@ -91,6 +91,13 @@ SUBOOL su_agc_init(su_agc_t *agc, const struct su_agc_params *params);
 
 SUCOMPLEX su_agc_feed(su_agc_t *agc, SUCOMPLEX x);
 
+/* Feed a bunch of samples. x and y may point to the same buffer */
+void su_agc_feed_bulk(
+    su_agc_t *agc,
+    const SUCOMPLEX *x,
+    SUCOMPLEX *y,
+    SUSCOUNT len);
+
 void su_agc_finalize(su_agc_t *agc);
 
 #endif /* _SIGUTILS_AGC_H */
@@ -19,11 +19,24 @@
 
 #include <util.h>
 #include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+#  include <sys/mman.h>
+#  include <sys/syscall.h>
+#  ifdef SYS_memfd_create
+#    define SU_STREAM_HAVE_MIRRORED_BUFFERS
+#    ifndef MFD_CLOEXEC
+#      define MFD_CLOEXEC 1U
+#    endif /* MFD_CLOEXEC */
+#  endif /* SYS_memfd_create */
+#endif /* __linux__ */
 
 #define SU_LOG_LEVEL "block"
 
 #include "log.h"
 #include "block.h"
+#include "executor.h"
 
 static su_block_class_t *class_list;
 static unsigned int      class_storage;
@@ -50,15 +63,142 @@ su_stream_init(su_stream_t *stream, SUSCOUNT size)
   stream->ptr = 0;
   stream->avail = 0;
   stream->pos   = 0ull;
+  stream->mirrored = SU_FALSE;
+  stream->tail  = NULL;
 
   return SU_TRUE;
 }
 
+SUBOOL
+su_stream_init_mirrored(su_stream_t *stream, SUSCOUNT size)
+{
+#ifdef SU_STREAM_HAVE_MIRRORED_BUFFERS
+  SUCOMPLEX *buffer = NULL;
+  void *addr = MAP_FAILED;
+  size_t page_size = sysconf(_SC_PAGESIZE);
+  size_t alloc_size;
+  int fd = -1;
+  int i = 0;
+  SUBOOL ok = SU_FALSE;
+
+  /* Both mappings must start at a page boundary */
+  alloc_size = size * sizeof (SUCOMPLEX);
+  alloc_size = page_size * ((alloc_size + page_size - 1) / page_size);
+
+  if (alloc_size % sizeof (SUCOMPLEX) != 0)
+    goto done;
+
+  if ((fd = syscall(SYS_memfd_create, "su_stream", MFD_CLOEXEC)) == -1)
+    goto done;
+
+  if (ftruncate(fd, alloc_size) == -1)
+    goto done;
+
+  /* Reserve address space for both copies */
+  if ((addr = mmap(
+      NULL,
+      2 * alloc_size,
+      PROT_NONE,
+      MAP_PRIVATE | MAP_ANONYMOUS,
+      -1,
+      0)) == MAP_FAILED)
+    goto done;
+
+  /* And map the same pages on each half */
+  if (mmap(
+      addr,
+      alloc_size,
+      PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_FIXED,
+      fd,
+      0) == MAP_FAILED)
+    goto done;
+
+  if (mmap(
+      (char *) addr + alloc_size,
+      alloc_size,
+      PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_FIXED,
+      fd,
+      0) == MAP_FAILED)
+    goto done;
+
+  buffer = (SUCOMPLEX *) addr;
+  size = alloc_size / sizeof (SUCOMPLEX);
+
+  /* Populate uninitialized buffer with NaNs */
+  for (i = 0; i < size; ++i)
+    buffer[i] = nan("uninitialized");
+
+  stream->buffer = buffer;
+  stream->size  = size;
+  stream->ptr = 0;
+  stream->avail = 0;
+  stream->pos   = 0ull;
+  stream->mirrored = SU_TRUE;
+  stream->tail  = NULL;
+
+  ok = SU_TRUE;
+
+done:
+  if (fd != -1)
+    close(fd);
+
+  if (!ok && addr != MAP_FAILED)
+    munmap(addr, 2 * alloc_size);
+
+  return ok;
+#else
+  return SU_FALSE;
+#endif /* SU_STREAM_HAVE_MIRRORED_BUFFERS */
+}
+
 void
 su_stream_finalize(su_stream_t *stream)
 {
-  if (stream->buffer != NULL)
-    free(stream->buffer);
+  if (stream->buffer != NULL) {
+#ifdef SU_STREAM_HAVE_MIRRORED_BUFFERS
+    if (stream->mirrored)
+      munmap(stream->buffer, 2 * stream->size * sizeof (SUCOMPLEX));
+    else
+#endif /* SU_STREAM_HAVE_MIRRORED_BUFFERS */
+      free(stream->buffer);
+  }
+}
+
+SUBOOL
+su_stream_resize(su_stream_t *stream, SUSCOUNT size)
+{
+  su_stream_t new;
+  su_off_t pos = stream->pos;
+  su_off_t off;
+  SUSCOUNT keep;
+
+  if (size == 0)
+    return SU_FALSE;
+
+  /* Keep the buffer kind, but fall back to plain buffers if needed */
+  if (!stream->mirrored || !su_stream_init_mirrored(&new, size))
+    if (!su_stream_init(&new, size))
+      return SU_FALSE;
+
+  /* Preserve the most recent samples that fit in the new buffer */
+  keep = SU_MIN(stream->avail, new.size);
+
+  for (off = pos - keep; off < pos; ++off)
+    new.buffer[off % new.size] = stream->buffer[off % stream->size];
+
+  /* Only the samples copied above are valid */
+  new.ptr   = pos % new.size;
+  new.avail = keep;
+  new.pos   = pos;
+  new.tail  = stream->tail;
+
+  su_stream_finalize(stream);
+
+  *stream = new;
+
+  return SU_TRUE;
 }
 
 void
@@ -68,10 +208,10 @@ su_stream_write(su_stream_t *stream, const SUCOMPLEX *data, SUSCOUNT size)
   SUSCOUNT chunksz;
 
   /*
-   * We increment this always. Current reading position is
-   *  stream->pos - stream->avail
+   * Current reading position is stream->pos - stream->avail. Position is
+   * published after the samples have been written.
    */
-  stream->pos += size;
+  su_off_t pos = stream->pos + size;
 
   if (size > stream->size) {
     SU_WARNING("write will overflow stream, keeping latest samples\n");
@@ -79,6 +219,23 @@ su_stream_write(su_stream_t *stream, const SUCOMPLEX *data, SUSCOUNT size)
     skip = size - stream->size;
     data += skip;
     size -= skip;
+
+    /* Keep the buffer pointer in sync with the stream position */
+    stream->ptr = (stream->ptr + skip) % stream->size;
+  }
+
+  if (stream->mirrored) {
+    /* No need to split the write */
+    memcpy(stream->buffer + stream->ptr, data, size * sizeof (SUCOMPLEX));
+
+    stream->ptr = (stream->ptr + size) % stream->size;
+    SU_ATOMIC_STORE(
+        &stream->avail,
+        SU_MIN(stream->avail + size, stream->size));
+
+    SU_ATOMIC_STORE(&stream->pos, pos);
+
+    return;
   }
 
   if ((chunksz = stream->size - stream->ptr) > size)
@@ -86,7 +243,9 @@ su_stream_write(su_stream_t *stream, const SUCOMPLEX *data, SUSCOUNT size)
 
   /* This needs to be updated only once */
   if (stream->avail < stream->size)
-    stream->avail += chunksz;
+    SU_ATOMIC_STORE(
+        &stream->avail,
+        SU_MIN(stream->avail + size, stream->size));
 
   memcpy(stream->buffer + stream->ptr, data, chunksz * sizeof (SUCOMPLEX));
   stream->ptr += chunksz;
@@ -104,22 +263,57 @@ su_stream_write(su_stream_t *stream, const SUCOMPLEX *data, SUSCOUNT size)
       stream->ptr += size;
     }
   }
+
+  SU_ATOMIC_STORE(&stream->pos, pos);
+}
+
+/*
+ * Oldest readable position given a position loaded by the reader. Writers
+ * update avail before publishing pos, and avail only shrinks in resizes,
+ * which never run concurrently with readers.
+ */
+SUINLINE su_off_t
+su_stream_get_readpos(const su_stream_t *stream, su_off_t pos)
+{
+  SUSCOUNT avail = SU_ATOMIC_LOAD(&stream->avail);
+
+  return pos - SU_MIN(pos, avail);
 }
 
 su_off_t
 su_stream_tell(const su_stream_t *stream)
 {
-  return stream->pos - stream->avail;
+  /* Equivalent to stream->pos - stream->avail */
+  return su_stream_get_readpos(stream, SU_ATOMIC_LOAD(&stream->pos));
 }
 
 
+/* Number of samples that can be written contiguously */
+SUPRIVATE SUSCOUNT
+su_stream_get_writable(const su_stream_t *stream)
+{
+  SUSCOUNT avail = stream->mirrored
+      ? stream->size
+      : stream->size - stream->ptr;
+  SUSCOUNT room;
+
+  /* Do not overrun the slowest reader */
+  if (stream->tail != NULL) {
+    room = stream->size - (stream->pos - SU_ATOMIC_LOAD(stream->tail));
+    if (avail > room)
+      avail = room;
+  }
+
+  return avail;
+}
+
 SUSCOUNT
 su_stream_get_contiguous(
     const su_stream_t *stream,
     SUCOMPLEX **start,
     SUSCOUNT size)
 {
-  SUSCOUNT avail = stream->size - stream->ptr;
+  SUSCOUNT avail = su_stream_get_writable(stream);
 
   if (size > avail) {
     size = avail;
@@ -135,60 +329,63 @@ su_stream_advance_contiguous(
     su_stream_t *stream,
     SUSCOUNT size)
 {
-  SUSCOUNT avail = stream->size - stream->ptr;
+  SUSCOUNT avail = su_stream_get_writable(stream);
 
   if (size > avail) {
     size = avail;
   }
 
-  stream->pos += size;
   stream->ptr += size;
   if (stream->avail < stream->size) {
-    stream->avail += size;
+    SU_ATOMIC_STORE(
+        &stream->avail,
+        SU_MIN(stream->avail + size, stream->size));
   }
 
   /* Rollover */
-  if (stream->ptr == stream->size) {
-    stream->ptr = 0;
+  if (stream->ptr >= stream->size) {
+    stream->ptr -= stream->size;
   }
 
+  SU_ATOMIC_STORE(&stream->pos, stream->pos + size);
+
   return size;
 }
 
+/*
+ * Readers only rely on a snapshot of the stream position: since the buffer
+ * pointer always equals the stream position modulo the stream size, the
+ * location of any sample in the buffer can be derived from it. This makes
+ * su_stream_read safe against a concurrent writer as long as it does not
+ * overwrite the samples being read.
+ */
 SUSDIFF
 su_stream_read(const su_stream_t *stream, su_off_t off, SUCOMPLEX *data, SUSCOUNT size)
 {
+  su_off_t pos = SU_ATOMIC_LOAD(&stream->pos);
+  su_off_t readpos = su_stream_get_readpos(stream, pos);
   SUSCOUNT avail;
-  su_off_t readpos = su_stream_tell(stream);
-  SUSCOUNT reloff;
   SUSCOUNT chunksz;
-  SUSDIFF ptr;
+  SUSCOUNT ptr;
 
   /* Slow reader */
   if (off < readpos)
     return -1;
 
   /* Greedy reader */
-  if (off >= stream->pos)
+  if (off >= pos)
     return 0;
 
-  reloff = off - readpos;
-
   /* Compute how many samples are available from here */
-  avail = stream->avail - reloff;
+  avail = pos - off;
   if (avail < size) {
     size = avail;
   }
 
   /* Compute position in the stream buffer to read from */
-  if ((ptr = stream->ptr - avail) < 0)
-    ptr += stream->size;
+  ptr = off % stream->size;
 
-  /* Adjust in case reloff causes ptr to rollover */
-  if (ptr > stream->size)
-    ptr = ptr - stream->size;
-
-  if (ptr + size > stream->size)
+  if (ptr + size > stream->size && !stream->mirrored)
     chunksz = stream->size - ptr;
   else
     chunksz = size;
@@ -203,11 +400,64 @@ su_stream_read(const su_stream_t *stream, su_off_t off, SUCOMPLEX *data, SUSCOUN
   return chunksz + size;
 }
 
+SUSDIFF
+su_stream_peek(
+    const su_stream_t *stream,
+    su_off_t off,
+    const SUCOMPLEX **start,
+    SUSCOUNT size)
+{
+  su_off_t pos = SU_ATOMIC_LOAD(&stream->pos);
+  su_off_t readpos = su_stream_get_readpos(stream, pos);
+  SUSCOUNT ptr;
+
+  /* Slow reader */
+  if (off < readpos)
+    return -1;
+
+  /* Greedy reader */
+  if (off >= pos)
+    return 0;
+
+  if (size > pos - off)
+    size = pos - off;
+
+  /* Stop at the end of the buffer (only if not mirrored) */
+  ptr = off % stream->size;
+  if (ptr + size > stream->size && !stream->mirrored)
+    size = stream->size - ptr;
+
+  *start = stream->buffer + ptr;
+
+  return size;
+}
+
+/*
+ * Copy samples to data, or just point to them if data is NULL.
+ */
+SUPRIVATE SUSDIFF
+su_stream_access(
+    const su_stream_t *stream,
+    su_off_t off,
+    SUCOMPLEX *data,
+    const SUCOMPLEX **start,
+    SUSCOUNT size)
+{
+  if (data != NULL)
+    return su_stream_read(stream, off, data, size);
+  else
+    return su_stream_peek(stream, off, start, size);
+}
+
 /************************* su_flow_controller API ****************************/
 void
 su_flow_controller_finalize(su_flow_controller_t *fc)
 {
   su_stream_finalize(&fc->output);
+
+  if (fc->reader_list != NULL)
+    free(fc->reader_list);
+
   pthread_mutex_destroy(&fc->acquire_lock);
   pthread_cond_destroy(&fc->acquire_cond);
 }
@@ -228,8 +478,10 @@ su_flow_controller_init(
   if (pthread_cond_init(&fc->acquire_cond, NULL) == -1)
     goto done;
 
-  if (!su_stream_init(&fc->output, size))
-    goto done;
+  /* Use mirrored buffers if available */
+  if (!su_stream_init_mirrored(&fc->output, size))
+    if (!su_stream_init(&fc->output, size))
+      goto done;
 
   fc->kind = kind;
   fc->consumers = 0;
@@ -268,12 +520,77 @@ su_flow_controller_notify(su_flow_controller_t *fc)
   su_flow_controller_notify_force(fc);
 }
 
+/*
+ * Wake up threads waiting on an asynchronous flow controller. Waiters
+ * register themselves with the lock held before checking their wait
+ * condition, so the lock is only taken if someone is actually waiting.
+ */
+SUPRIVATE void
+su_flow_controller_wake_up(su_flow_controller_t *fc)
+{
+  SU_ATOMIC_FENCE();
+
+  if (SU_ATOMIC_LOAD(&fc->waiters) > 0) {
+    su_flow_controller_enter(fc);
+    su_flow_controller_notify(fc);
+    su_flow_controller_leave(fc);
+  }
+}
+
+/* Must be called with the lock held */
+SUPRIVATE void
+su_flow_controller_wait_begin(su_flow_controller_t *fc)
+{
+  SU_ATOMIC_STORE(&fc->waiters, fc->waiters + 1);
+  SU_ATOMIC_FENCE();
+}
+
+SUPRIVATE void
+su_flow_controller_wait_end(su_flow_controller_t *fc)
+{
+  SU_ATOMIC_STORE(&fc->waiters, fc->waiters - 1);
+}
+
+SUPRIVATE SUSCOUNT
+su_flow_controller_get_room(const su_flow_controller_t *fc)
+{
+  return fc->output.size - (fc->output.pos - SU_ATOMIC_LOAD(&fc->tail));
+}
+
+/*
+ * Executor tasks of the blocks reading from an asynchronous output go idle
+ * when it runs out of samples. Queue them again after writing to it.
+ */
+SUPRIVATE void
+su_flow_controller_notify_consumers(su_flow_controller_t *fc)
+{
+  const su_block_t *owner;
+  su_executor_task_t *task;
+  unsigned int i, j;
+
+  su_flow_controller_enter(fc);
+
+  for (i = 0; i < fc->reader_count; ++i)
+    if (fc->reader_list[i] != NULL
+        && (owner = fc->reader_list[i]->owner) != NULL)
+      for (j = 0; j < owner->classname->out_size; ++j)
+        if ((task = SU_ATOMIC_LOAD(&owner->out[j].producer)) != NULL)
+          su_executor_task_notify(task);
+
+  su_flow_controller_leave(fc);
+}
+
 SUPRIVATE void
 su_flow_controller_force_eos(su_flow_controller_t *fc)
 {
-  fc->eos = SU_TRUE;
+  SU_ATOMIC_STORE(&fc->eos, SU_TRUE);
 
-  su_flow_controller_notify(fc);
+  if (fc->async) {
+    su_flow_controller_wake_up(fc);
+    su_flow_controller_notify_consumers(fc);
+  } else {
+    su_flow_controller_notify(fc);
+  }
 }
 
 SUPRIVATE su_off_t
@@ -288,18 +605,88 @@ su_flow_controller_get_stream(su_flow_controller_t *fc)
   return &fc->output;
 }
 
-/* TODO: make these functions thread safe */
+/*
+ * Broadcast flow controllers: the producer may overwrite samples up to the
+ * position of the slowest port. Must be called with the lock held.
+ */
 SUPRIVATE void
-su_flow_controller_add_consumer(su_flow_controller_t *fc)
+su_flow_controller_update_tail(su_flow_controller_t *fc)
+{
+  su_off_t tail = fc->output.pos;
+  unsigned int i;
+
+  for (i = 0; i < fc->reader_count; ++i)
+    if (fc->reader_list[i] != NULL && fc->reader_list[i]->pos < tail)
+      tail = fc->reader_list[i]->pos;
+
+  if (tail != fc->tail) {
+    SU_ATOMIC_STORE(&fc->tail, tail);
+    su_flow_controller_notify(fc);
+  }
+}
+
+/*
+ * Consumers are registered and unregistered with the lock held, so readers
+ * and writers always see the reader list, the consumer count and the tail
+ * in a consistent state.
+ */
+SUPRIVATE SUBOOL
+su_flow_controller_add_consumer(
+    su_flow_controller_t *fc,
+    struct sigutils_block_port *port)
 {
+  SUBOOL ok = SU_FALSE;
+
+  su_flow_controller_enter(fc);
+
+  if (fc->kind == SU_FLOW_CONTROL_KIND_SPSC && fc->consumers > 0) {
+    SU_ERROR("SPSC flow controllers accept one consumer only\n");
+    goto done;
+  }
+
+  if (fc->async
+      && fc->consumers > 0
+      && fc->kind != SU_FLOW_CONTROL_KIND_BROADCAST) {
+    SU_ERROR("Asynchronous flow controllers accept one consumer only\n");
+    goto done;
+  }
+
+  port->pos = su_flow_controller_tell(fc);
+
+  if (PTR_LIST_APPEND_CHECK(fc->reader, port) == -1) {
+    SU_ERROR("Cannot register consumer\n");
+    goto done;
+  }
+
   ++fc->consumers;
+
+  /* The new port may be the slowest one */
+  if (fc->kind == SU_FLOW_CONTROL_KIND_BROADCAST)
+    su_flow_controller_update_tail(fc);
+
+  ok = SU_TRUE;
+
+done:
+  su_flow_controller_leave(fc);
+
+  return ok;
 }
 
 SUPRIVATE void
-su_flow_controller_remove_consumer(su_flow_controller_t *fc, SUBOOL pend)
+su_flow_controller_remove_consumer(
+    su_flow_controller_t *fc,
+    struct sigutils_block_port *port,
+    SUBOOL pend)
 {
+  su_flow_controller_enter(fc);
+
+  PTR_LIST_REMOVE(fc->reader, port);
   --fc->consumers;
 
+  /* This may have been the slowest port */
+  if (fc->kind == SU_FLOW_CONTROL_KIND_BROADCAST)
+    su_flow_controller_update_tail(fc);
+
   if (fc->kind == SU_FLOW_CONTROL_KIND_BARRIER) {
     if (pend)
       --fc->pending;
@@ -311,6 +698,8 @@ su_flow_controller_remove_consumer(su_flow_controller_t *fc, SUBOOL pend)
   } else if (fc->kind == SU_FLOW_CONTROL_KIND_MASTER_SLAVE) {
     /* TODO: mark flow control as EOF if master is being unplugged */
   }
+
+  su_flow_controller_leave(fc);
 }
 
 SUPRIVATE SUBOOL
@@ -322,22 +711,84 @@ su_flow_controller_set_kind(
   if (fc->kind != SU_FLOW_CONTROL_KIND_NONE)
     return SU_FALSE;
 
+  /* Too late for SPSC */
+  if (kind == SU_FLOW_CONTROL_KIND_SPSC && fc->consumers > 1)
+    return SU_FALSE;
+
+  /* Asynchronous flow controllers only support one consumer */
+  if (fc->async && kind != SU_FLOW_CONTROL_KIND_SPSC)
+    return SU_FALSE;
+
   fc->kind = kind;
 
+  /* From now on, writes are limited by the slowest port */
+  if (kind == SU_FLOW_CONTROL_KIND_BROADCAST) {
+    su_flow_controller_enter(fc);
+    su_flow_controller_update_tail(fc);
+    su_flow_controller_leave(fc);
+
+    fc->output.tail = &fc->tail;
+  }
+
   return SU_TRUE;
 }
 
+/***************************** Block statistics ******************************/
+SUPRIVATE uint64_t
+su_block_stats_get_time_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+SUPRIVATE void
+su_block_stats_add_acquire(su_block_stats_t *stats, SUSDIFF got, uint64_t ns)
+{
+  if (got > 0)
+    SU_ATOMIC_ADD(&stats->samples, got);
+
+  SU_ATOMIC_ADD(&stats->acquires, 1);
+  SU_ATOMIC_ADD(&stats->acquire_ns, ns);
+}
+
+/* Waits and desyncs are accounted to the block owning the flow controller */
+SUPRIVATE void
+su_block_stats_add_desync(su_block_t *block, su_flow_controller_t *fc)
+{
+  SU_ATOMIC_ADD(&block->stats.desyncs, 1);
+  SU_ATOMIC_ADD(&fc->stats.desyncs, 1);
+}
+
+/* Must be called with the lock held */
+SUPRIVATE void
+su_flow_controller_wait(su_flow_controller_t *fc, su_block_t *block)
+{
+  uint64_t start = su_block_stats_get_time_ns();
+  uint64_t ns;
+
+  pthread_cond_wait(&fc->acquire_cond, &fc->acquire_lock);
+
+  ns = su_block_stats_get_time_ns() - start;
+
+  SU_ATOMIC_ADD(&block->stats.wait_ns, ns);
+  SU_ATOMIC_ADD(&fc->stats.wait_ns, ns);
+}
+
 SUPRIVATE SUSDIFF
 su_flow_controller_read_unsafe(
     su_flow_controller_t *fc,
     struct sigutils_block_port *reader,
     su_off_t off,
     SUCOMPLEX *data,
+    const SUCOMPLEX **start,
     SUSCOUNT size)
 {
   SUSDIFF result;
 
-  while ((result = su_stream_read(&fc->output, off, data, size)) == 0
+  while ((result = su_stream_access(&fc->output, off, data, start, size)) == 0
       && fc->consumers > 1) {
     /*
      * We have reached the end of the stream. In the concurrent case,
@@ -351,7 +802,7 @@ su_flow_controller_read_unsafe(
       case SU_FLOW_CONTROL_KIND_BARRIER:
         if (++fc->pending < fc->consumers)
           /* Greedy reader. Wait for the last one */
-          pthread_cond_wait(&fc->acquire_cond, &fc->acquire_lock);
+          su_flow_controller_wait(fc, reader->block);
         else {
           /* Slow reader. Let caller perform acquire() */
           fc->pending = 0; /* Reset pending counter */
@@ -363,11 +814,19 @@ su_flow_controller_read_unsafe(
       case SU_FLOW_CONTROL_KIND_MASTER_SLAVE:
         if (fc->master != reader)
           /* Slave must wait for master to read */
-          pthread_cond_wait(&fc->acquire_cond, &fc->acquire_lock);
+          su_flow_controller_wait(fc, reader->block);
         else
           return SU_FLOW_CONTROLLER_ACQUIRE_ALLOWED;
         break;
 
+      case SU_FLOW_CONTROL_KIND_BROADCAST:
+        if (su_flow_controller_get_room(fc) > 0)
+          return SU_FLOW_CONTROLLER_ACQUIRE_ALLOWED;
+        else
+          /* Stream full. Wait for the slowest reader to consume samples */
+          su_flow_controller_wait(fc, reader->block);
+        break;
+
       default:
         SU_ERROR("Invalid flow controller kind\n");
         return SU_FLOW_CONTROLLER_INTERNAL_ERROR;
@@ -438,8 +897,13 @@ su_block_destroy(su_block_t *block)
   if (block->privdata != NULL)
     block->classname->dtor(block->privdata);
 
-  if (block->in != NULL)
+  if (block->in != NULL) {
+    for (i = 0; i < block->classname->in_size; ++i)
+      if (block->in[i].peek_buf != NULL)
+        free(block->in[i].peek_buf);
+
     free(block->in);
+  }
 
   if (block->out != NULL) {
     for (i = 0; i < block->classname->out_size; ++i) {
@@ -496,17 +960,73 @@ su_block_set_property_ref(
   return SU_TRUE;
 }
 
-su_block_t *
-su_block_new(const char *class_name, ...)
+SUPRIVATE SUBOOL
+su_block_expose_stats(
+    su_block_t *block,
+    su_block_stats_t *stats,
+    const char *prefix)
+{
+  char name[64];
+
+#define SU_BLOCK_EXPOSE_STAT(field)                          \
+  snprintf(name, sizeof (name), "%s." #field, prefix);       \
+  SU_TRYCATCH(                                               \
+      su_block_set_property_ref(                             \
+          block,                                             \
+          SU_PROPERTY_TYPE_INTEGER,                          \
+          name,                                              \
+          &stats->field),                                    \
+      return SU_FALSE)
+
+  SU_BLOCK_EXPOSE_STAT(samples);
+  SU_BLOCK_EXPOSE_STAT(acquires);
+  SU_BLOCK_EXPOSE_STAT(acquire_ns);
+  SU_BLOCK_EXPOSE_STAT(wait_ns);
+  SU_BLOCK_EXPOSE_STAT(desyncs);
+
+#undef SU_BLOCK_EXPOSE_STAT
+
+  return SU_TRUE;
+}
+
+SUPRIVATE SUBOOL
+su_block_expose_port_stats(
+    su_block_t *block,
+    su_block_port_t *port,
+    unsigned int id)
+{
+  char name[64];
+
+  snprintf(name, sizeof (name), "stats.in%d.max_lag", id);
+  SU_TRYCATCH(
+      su_block_set_property_ref(
+          block,
+          SU_PROPERTY_TYPE_INTEGER,
+          name,
+          &port->max_lag),
+      return SU_FALSE);
+
+  snprintf(name, sizeof (name), "stats.in%d.dropped", id);
+  SU_TRYCATCH(
+      su_block_set_property_ref(
+          block,
+          SU_PROPERTY_TYPE_INTEGER,
+          name,
+          &port->dropped),
+      return SU_FALSE);
+
+  return SU_TRUE;
+}
+
+SUPRIVATE su_block_t *
+su_block_new_va(SUSCOUNT stream_size, const char *class_name, va_list ap)
 {
-  va_list ap;
   su_block_t *new = NULL;
   su_block_t *result = NULL;
   su_block_class_t *class;
+  char prefix[32];
   unsigned int i;
 
-  va_start(ap, class_name);
-
   if ((class = su_block_class_lookup(class_name)) == NULL) {
     SU_ERROR("No block class `%s' found\n", class_name);
     goto done;
@@ -526,6 +1046,9 @@ su_block_new(const char *class_name, ...)
     }
   }
 
+  for (i = 0; i < class->in_size; ++i)
+    new->in[i].owner = new;
+
   if (class->out_size > 0) {
     if ((new->out = calloc(class->out_size, sizeof(su_flow_controller_t)))
         == NULL) {
@@ -536,6 +1059,7 @@ su_block_new(const char *class_name, ...)
 
   /* Set decimation to 1, this may be changed by block constructor */
   new->decimation = 1;
+  new->stream_size = stream_size;
 
   /* Initialize object */
   if (!class->ctor(new, &new->privdata, ap)) {
@@ -548,16 +1072,33 @@ su_block_new(const char *class_name, ...)
     goto done;
   }
 
+  if (new->stream_size == 0)
+    new->stream_size = SU_BLOCK_STREAM_BUFFER_SIZE / new->decimation;
+
   /* Initialize all outputs */
   for (i = 0; i < class->out_size; ++i)
     if (!su_flow_controller_init(
         &new->out[i],
         SU_FLOW_CONTROL_KIND_NONE,
-        SU_BLOCK_STREAM_BUFFER_SIZE / new->decimation)) {
+        new->stream_size)) {
       SU_ERROR("Cannot allocate memory for block output #%d\n", i + 1);
       goto done;
     }
 
+  /* Expose runtime counters */
+  if (!su_block_expose_stats(new, &new->stats, "stats"))
+    goto done;
+
+  for (i = 0; i < class->out_size; ++i) {
+    snprintf(prefix, sizeof (prefix), "stats.out%d", i);
+    if (!su_block_expose_stats(new, &new->out[i].stats, prefix))
+      goto done;
+  }
+
+  for (i = 0; i < class->in_size; ++i)
+    if (!su_block_expose_port_stats(new, &new->in[i], i))
+      goto done;
+
   /* Initialize flow control */
   result = new;
 
@@ -565,6 +1106,34 @@ done:
   if (result == NULL && new != NULL)
     su_block_destroy(new);
 
+  return result;
+}
+
+su_block_t *
+su_block_new(const char *class_name, ...)
+{
+  va_list ap;
+  su_block_t *result;
+
+  va_start(ap, class_name);
+
+  result = su_block_new_va(0, class_name, ap);
+
+  va_end(ap);
+
+  return result;
+}
+
+su_block_t *
+su_block_new_ex(SUSCOUNT stream_size, const char *class_name, ...)
+{
+  va_list ap;
+  su_block_t *result;
+
+  va_start(ap, class_name);
+
+  result = su_block_new_va(stream_size, class_name, ap);
+
   va_end(ap);
 
   return result;
@@ -590,11 +1159,91 @@ su_block_get_flow_controller(const su_block_t *block, unsigned int id)
   return block->out + id;
 }
 
-SUBOOL
-su_block_force_eos(const su_block_t *block, unsigned int id)
+su_stream_t *
+su_block_get_stream(const su_block_t *block, unsigned int id)
 {
-  su_flow_controller_t *fc;
-
+  if (id >= block->classname->out_size) {
+    return NULL;
+  }
+
+  return &block->out[id].output;
+}
+
+/*
+ * Measure the rate at which samples are requested, and resize the stream
+ * so it holds SU_BLOCK_AUTOTUNE_LATENCY_NS worth of samples. Sizes are
+ * powers of two, and the stream is left alone unless the desired size is
+ * off by a factor of 4 or more, so rates near a boundary do not make it
+ * bounce between sizes.
+ */
+SUPRIVATE void
+su_flow_controller_autotune(su_flow_controller_t *fc, uint64_t now)
+{
+  uint64_t elapsed;
+  uint64_t samples;
+  SUSCOUNT size;
+  SUSCOUNT current = fc->output.size;
+
+  if (fc->autotune_ns == 0) {
+    fc->autotune_ns = now;
+    fc->autotune_samples = fc->stats.samples;
+    return;
+  }
+
+  if ((elapsed = now - fc->autotune_ns) < SU_BLOCK_AUTOTUNE_INTERVAL_NS)
+    return;
+
+  samples = fc->stats.samples - fc->autotune_samples;
+
+  fc->autotune_ns = now;
+  fc->autotune_samples = fc->stats.samples;
+
+  size = SU_BLOCK_AUTOTUNE_MIN_SIZE;
+  while (size < SU_BLOCK_AUTOTUNE_MAX_SIZE
+      && size * elapsed < samples * SU_BLOCK_AUTOTUNE_LATENCY_NS)
+    size <<= 1;
+
+  if (size >= 4 * current || 4 * size <= current)
+    if (!su_stream_resize(&fc->output, size))
+      SU_WARNING("Failed to resize stream to %lu samples\n", size);
+}
+
+/* Every call to acquire() goes through here */
+SUPRIVATE SUSDIFF
+su_block_acquire(su_block_t *block, unsigned int port_id)
+{
+  su_flow_controller_t *fc = block->out + port_id;
+  uint64_t start = su_block_stats_get_time_ns();
+  uint64_t ns;
+  SUSDIFF got;
+
+  /*
+   * The only consumer is the one asking for samples, so nobody is peeking
+   * from the stream at this point. With more consumers, other ports may
+   * still hold pointers to it: leave it alone.
+   */
+  if (fc->autotune && fc->consumers == 1)
+    su_flow_controller_autotune(fc, start);
+
+  got = block->classname->acquire(
+      block->privdata,
+      su_flow_controller_get_stream(fc),
+      port_id,
+      block->in);
+
+  ns = su_block_stats_get_time_ns() - start;
+
+  su_block_stats_add_acquire(&block->stats, got, ns);
+  su_block_stats_add_acquire(&fc->stats, got, ns);
+
+  return got;
+}
+
+SUBOOL
+su_block_force_eos(const su_block_t *block, unsigned int id)
+{
+  su_flow_controller_t *fc;
+
   if ((fc = su_block_get_flow_controller(block, id)) == NULL)
     return SU_FALSE;
 
@@ -617,6 +1266,71 @@ su_block_set_flow_controller(
   return su_flow_controller_set_kind(fc, kind);
 }
 
+SUBOOL
+su_block_set_stream_size(
+    su_block_t *block,
+    unsigned int port_id,
+    SUSCOUNT size)
+{
+  su_flow_controller_t *fc;
+
+  if ((fc = su_block_get_flow_controller(block, port_id)) == NULL)
+    return SU_FALSE;
+
+  if (fc->async) {
+    SU_ERROR(
+        "%s: cannot resize output #%d (asynchronous)\n",
+        block->classname->name,
+        port_id);
+    return SU_FALSE;
+  }
+
+  if (fc->consumers > 1) {
+    SU_ERROR(
+        "%s: cannot resize output #%d (%d consumers)\n",
+        block->classname->name,
+        port_id,
+        fc->consumers);
+    return SU_FALSE;
+  }
+
+  return su_stream_resize(&fc->output, size);
+}
+
+SUBOOL
+su_block_set_autotune(
+    su_block_t *block,
+    unsigned int port_id,
+    SUBOOL autotune)
+{
+  su_flow_controller_t *fc;
+
+  if ((fc = su_block_get_flow_controller(block, port_id)) == NULL)
+    return SU_FALSE;
+
+  if (autotune && fc->async) {
+    SU_ERROR(
+        "%s: cannot autotune output #%d (asynchronous)\n",
+        block->classname->name,
+        port_id);
+    return SU_FALSE;
+  }
+
+  if (autotune && fc->consumers > 1) {
+    SU_ERROR(
+        "%s: cannot autotune output #%d (%d consumers)\n",
+        block->classname->name,
+        port_id,
+        fc->consumers);
+    return SU_FALSE;
+  }
+
+  fc->autotune = autotune;
+  fc->autotune_ns = 0;
+
+  return SU_TRUE;
+}
+
 SUBOOL
 su_block_set_master_port(
     su_block_t *block,
@@ -636,6 +1350,124 @@ su_block_set_master_port(
   return SU_TRUE;
 }
 
+SUBOOL
+su_block_set_async(
+    su_block_t *block,
+    unsigned int port_id,
+    SUBOOL async)
+{
+  su_flow_controller_t *fc;
+
+  if ((fc = su_block_get_flow_controller(block, port_id)) == NULL)
+    return SU_FALSE;
+
+  /* Nothing to do, and enabling twice would lose the original kind */
+  if (async == fc->async)
+    return SU_TRUE;
+
+  if (async) {
+    if (fc->autotune) {
+      SU_ERROR(
+          "%s: cannot make output #%d asynchronous (stream size autotuned)\n",
+          block->classname->name,
+          port_id);
+      return SU_FALSE;
+    }
+
+    if (fc->consumers > 1 && fc->kind != SU_FLOW_CONTROL_KIND_BROADCAST) {
+      SU_ERROR(
+          "%s: cannot make output #%d asynchronous (too many consumers)\n",
+          block->classname->name,
+          port_id);
+      return SU_FALSE;
+    }
+
+    if (fc->kind != SU_FLOW_CONTROL_KIND_NONE
+        && fc->kind != SU_FLOW_CONTROL_KIND_SPSC
+        && fc->kind != SU_FLOW_CONTROL_KIND_BROADCAST) {
+      SU_ERROR(
+          "%s: cannot make output #%d asynchronous (incompatible flow control)\n",
+          block->classname->name,
+          port_id);
+      return SU_FALSE;
+    }
+
+    fc->sync_kind = fc->kind;
+
+    /* Broadcast flow controllers already keep track of their tail */
+    if (fc->kind != SU_FLOW_CONTROL_KIND_BROADCAST) {
+      fc->kind = SU_FLOW_CONTROL_KIND_SPSC;
+      fc->tail = su_flow_controller_tell(fc);
+      fc->output.tail = &fc->tail;
+    }
+  } else {
+    if (fc->kind != SU_FLOW_CONTROL_KIND_BROADCAST)
+      fc->output.tail = NULL;
+
+    fc->kind = fc->sync_kind;
+  }
+
+  fc->async = async;
+
+  return SU_TRUE;
+}
+
+SUSDIFF
+su_block_produce(su_block_t *block, unsigned int port_id)
+{
+  su_flow_controller_t *fc;
+  SUSDIFF got;
+
+  if ((fc = su_block_get_flow_controller(block, port_id)) == NULL)
+    return -1;
+
+  if (!fc->async) {
+    SU_ERROR("%s: output #%d is not asynchronous\n",
+        block->classname->name,
+        port_id);
+    return -1;
+  }
+
+  /* Wait for the consumer to make room */
+  if (su_flow_controller_get_room(fc) == 0) {
+    su_flow_controller_enter(fc);
+    su_flow_controller_wait_begin(fc);
+
+    while (su_flow_controller_get_room(fc) == 0
+        && !SU_ATOMIC_LOAD(&fc->eos))
+      su_flow_controller_wait(fc, block);
+
+    su_flow_controller_wait_end(fc);
+    su_flow_controller_leave(fc);
+  }
+
+  if (SU_ATOMIC_LOAD(&fc->eos))
+    return 0;
+
+  if ((got = su_block_acquire(block, port_id)) == -1)
+    SU_ERROR("%s: acquire failed\n", block->classname->name);
+
+  if (got > 0) {
+    su_flow_controller_wake_up(fc);
+    su_flow_controller_notify_consumers(fc);
+  } else {
+    su_flow_controller_force_eos(fc);
+  }
+
+  return got;
+}
+
+SUSCOUNT
+su_block_get_room(const su_block_t *block, unsigned int port_id)
+{
+  su_flow_controller_t *fc;
+
+  if ((fc = su_block_get_flow_controller(block, port_id)) == NULL)
+    return 0;
+
+  return su_flow_controller_get_room(fc);
+}
+
 SUBOOL
 su_block_plug(
     su_block_t *source,
@@ -656,6 +1488,69 @@ su_block_plug(
   return su_block_port_plug(input, source, out_id);
 }
 
+su_block_t *
+su_block_chain_fuse(su_block_t **blocks, unsigned int count)
+{
+  su_block_t *fused = NULL;
+  su_block_t *source = NULL;
+  unsigned int source_port = 0;
+  unsigned int i;
+
+  if (count == 0) {
+    SU_ERROR("Cannot fuse an empty chain\n");
+    return NULL;
+  }
+
+  for (i = 0; i < count; ++i) {
+    if (blocks[i]->classname->in_size != 1
+        || blocks[i]->classname->out_size != 1
+        || blocks[i]->classname->process == NULL) {
+      SU_ERROR(
+          "Block `%s' cannot be fused\n",
+          blocks[i]->classname->name);
+      return NULL;
+    }
+
+    if (i + 1 < count) {
+      if (blocks[i + 1]->in[0].block != blocks[i]
+          || blocks[i]->out[0].consumers != 1) {
+        SU_ERROR(
+            "Output of block `%s' must be plugged only to `%s'\n",
+            blocks[i]->classname->name,
+            blocks[i + 1]->classname->name);
+        return NULL;
+      }
+    } else if (blocks[i]->out[0].consumers != 0) {
+      SU_ERROR(
+          "Output of block `%s' is already plugged\n",
+          blocks[i]->classname->name);
+      return NULL;
+    }
+  }
+
+  SU_TRYCATCH(fused = su_block_new("fused", blocks, count), return NULL);
+
+  /* Take the input of the first block */
+  if (su_block_port_is_plugged(blocks[0]->in)) {
+    source      = blocks[0]->in[0].block;
+    source_port = blocks[0]->in[0].port_id;
+
+    su_block_port_unplug(blocks[0]->in);
+
+    if (!su_block_plug(source, source_port, 0, fused)) {
+      su_block_plug(source, source_port, 0, blocks[0]);
+      su_block_destroy(fused);
+      return NULL;
+    }
+  }
+
+  /* Intermediate streams are no longer used */
+  for (i = 1; i < count; ++i)
+    su_block_port_unplug(blocks[i]->in);
+
+  return fused;
+}
+
 /************************** su_block_port API ********************************/
 SUBOOL
 su_block_port_is_plugged(const su_block_port_t *port)
@@ -680,18 +1575,158 @@ su_block_port_plug(su_block_port_t *port,
     return SU_FALSE;
   }
 
+  /* Sets port->pos */
+  if (!su_flow_controller_add_consumer(block->out + portid, port))
+    return SU_FALSE;
+
   port->port_id = portid;
   port->fc      = block->out + portid;
   port->block   = block;
 
-  su_flow_controller_add_consumer(port->fc);
-  port->pos     = su_flow_controller_tell(port->fc);
-
   return SU_TRUE;
 }
 
-SUSDIFF
-su_block_port_read(su_block_port_t *port, SUCOMPLEX *obuf, SUSCOUNT size)
+/* Skip to the oldest sample in the stream, after losing some of them */
+SUPRIVATE void
+su_block_port_desync(su_block_port_t *port)
+{
+  su_off_t pos = su_flow_controller_tell(port->fc);
+
+  if (pos > port->pos)
+    port->dropped += pos - port->pos;
+
+  port->pos = pos;
+
+  su_block_stats_add_desync(port->block, port->fc);
+}
+
+/*
+ * Lock-free read. Since this port is the only consumer of the flow
+ * controller, acquire() can only be called from here, and there is nobody
+ * else to wait for.
+ */
+SUPRIVATE SUSDIFF
+su_block_port_read_spsc(
+    su_block_port_t *port,
+    SUCOMPLEX *obuf,
+    const SUCOMPLEX **start,
+    SUSCOUNT size)
+{
+  SUSDIFF got = 0;
+  SUSDIFF acquired = 0;
+
+  do {
+    if (SU_ATOMIC_LOAD(&port->fc->eos))
+      return SU_BLOCK_PORT_READ_END_OF_STREAM;
+
+    got = su_stream_access(&port->fc->output, port->pos, obuf, start, size);
+
+    if (got < 0) {
+      su_block_port_desync(port);
+      return SU_BLOCK_PORT_READ_ERROR_PORT_DESYNC;
+    } else if (got == 0) {
+      if ((acquired = su_block_acquire(port->block, port->port_id)) == -1) {
+        SU_ERROR("%s: acquire failed\n", port->block->classname->name);
+        return SU_BLOCK_PORT_READ_ERROR_ACQUIRE;
+      } else if (acquired == 0) {
+        /* Stream closed */
+        return SU_BLOCK_PORT_READ_END_OF_STREAM;
+      }
+    }
+  } while (got == 0);
+
+  return got;
+}
+
+/*
+ * Asynchronous read. acquire() is called by some other thread: all we
+ * can do is to wait for new samples, unless the producer belongs to an
+ * executor and is not running. In that case we run it ourselves.
+ */
+SUPRIVATE SUSDIFF
+su_block_port_read_async(
+    su_block_port_t *port,
+    SUCOMPLEX *obuf,
+    const SUCOMPLEX **start,
+    SUSCOUNT size)
+{
+  su_flow_controller_t *fc = port->fc;
+  SUSDIFF got = 0;
+
+  while ((got = su_stream_access(&fc->output, port->pos, obuf, start, size))
+      == 0) {
+    if (SU_ATOMIC_LOAD(&fc->eos)) {
+      /* Samples written before EOS are still valid */
+      if ((got = su_stream_access(&fc->output, port->pos, obuf, start, size))
+          == 0)
+        return SU_BLOCK_PORT_READ_END_OF_STREAM;
+      break;
+    }
+
+    if (fc->producer != NULL && su_executor_task_help(fc->producer))
+      continue;
+
+    su_flow_controller_enter(fc);
+    su_flow_controller_wait_begin(fc);
+
+    while (SU_ATOMIC_LOAD(&fc->output.pos) <= port->pos
+        && !SU_ATOMIC_LOAD(&fc->eos)
+        && (fc->producer == NULL
+            || su_executor_task_is_running(fc->producer)))
+      su_flow_controller_wait(fc, port->block);
+
+    su_flow_controller_wait_end(fc);
+    su_flow_controller_leave(fc);
+  }
+
+  if (got < 0) {
+    su_block_port_desync(port);
+    return SU_BLOCK_PORT_READ_ERROR_PORT_DESYNC;
+  }
+
+  return got;
+}
+
+/* Advance port position, releasing samples to the producer if needed */
+SUPRIVATE void
+su_block_port_advance(su_block_port_t *port, SUSCOUNT size)
+{
+  su_flow_controller_t *fc = port->fc;
+  SUSCOUNT lag;
+
+  if (fc->kind == SU_FLOW_CONTROL_KIND_BROADCAST) {
+    /* Positions of the other ports are needed to find the tail */
+    su_flow_controller_enter(fc);
+    port->pos += size;
+    su_flow_controller_update_tail(fc);
+    su_flow_controller_leave(fc);
+  } else {
+    port->pos += size;
+
+    if (fc->async) {
+      SU_ATOMIC_STORE(&fc->tail, port->pos);
+      su_flow_controller_wake_up(fc);
+    }
+  }
+
+  if (fc->async && fc->producer != NULL)
+    su_executor_task_notify(fc->producer);
+
+  if ((lag = su_block_port_get_lag(port)) > port->max_lag)
+    port->max_lag = lag;
+}
+
+/*
+ * Common implementation of su_block_port_read and su_block_port_peek. If
+ * obuf is NULL, samples are not copied and start is set to point to them
+ * instead. The port position is left untouched.
+ */
+SUPRIVATE SUSDIFF
+su_block_port_read_internal(
+    su_block_port_t *port,
+    SUCOMPLEX *obuf,
+    const SUCOMPLEX **start,
+    SUSCOUNT size)
 {
   SUSDIFF got = 0;
   SUSDIFF acquired = 0;
@@ -701,6 +1736,12 @@ su_block_port_read(su_block_port_t *port, SUCOMPLEX *obuf, SUSCOUNT size)
     return SU_BLOCK_PORT_READ_ERROR_NOT_INITIALIZED;
   }
 
+  if (port->fc->async)
+    return su_block_port_read_async(port, obuf, start, size);
+
+  if (port->fc->kind == SU_FLOW_CONTROL_KIND_SPSC)
+    return su_block_port_read_spsc(port, obuf, start, size);
+
   do {
     su_flow_controller_enter(port->fc);
 
@@ -712,12 +1753,18 @@ su_block_port_read(su_block_port_t *port, SUCOMPLEX *obuf, SUSCOUNT size)
 
     /* ------8<----- ENTER CONCURRENT FLOW CONTROLLER ACCESS -----8<------ */
     port->reading = SU_TRUE;
-    got = su_flow_controller_read_unsafe(port->fc, port, port->pos, obuf, size);
+    got = su_flow_controller_read_unsafe(
+        port->fc,
+        port,
+        port->pos,
+        obuf,
+        start,
+        size);
     port->reading = SU_FALSE;
 
     switch (got) {
       case SU_FLOW_CONTROLLER_DESYNC:
-        port->pos = su_flow_controller_tell(port->fc);
+        su_block_port_desync(port);
         su_flow_controller_leave(port->fc);
         return SU_BLOCK_PORT_READ_ERROR_PORT_DESYNC;
 
@@ -732,11 +1779,7 @@ su_block_port_read(su_block_port_t *port, SUCOMPLEX *obuf, SUSCOUNT size)
          * to call acquire. Since this call is protected, the block
          * implementation doesn't have to worry about threads.
          */
-        if ((acquired = port->block->classname->acquire(
-            port->block->privdata,
-            su_flow_controller_get_stream(port->block->out),
-            port->port_id,
-            port->block->in)) == -1) {
+        if ((acquired = su_block_acquire(port->block, port->port_id)) == -1) {
           /* Acquire error */
           SU_ERROR("%s: acquire failed\n", port->block->classname->name);
           /* TODO: set error condition in flow control */
@@ -766,11 +1809,123 @@ su_block_port_read(su_block_port_t *port, SUCOMPLEX *obuf, SUSCOUNT size)
 
   } while (got == 0);
 
-  port->pos += got;
+  return got;
+}
+
+SUSDIFF
+su_block_port_read(su_block_port_t *port, SUCOMPLEX *obuf, SUSCOUNT size)
+{
+  SUSDIFF got;
+
+  if ((got = su_block_port_read_internal(port, obuf, NULL, size)) > 0)
+    su_block_port_advance(port, got);
 
   return got;
 }
 
+/*
+ * Whether other consumers may call acquire() while this port holds
+ * pointers to the stream. See su_block_port_peek.
+ */
+SUPRIVATE SUBOOL
+su_block_port_is_shared(const su_block_port_t *port)
+{
+  const su_flow_controller_t *fc = port->fc;
+
+  return !fc->async
+      && (fc->kind == SU_FLOW_CONTROL_KIND_NONE
+          || fc->kind == SU_FLOW_CONTROL_KIND_MASTER_SLAVE)
+      && fc->consumers > 1;
+}
+
+SUSDIFF
+su_block_port_peek(
+    su_block_port_t *port,
+    const SUCOMPLEX **start,
+    SUSCOUNT size)
+{
+  SUCOMPLEX *tmp;
+  SUSDIFF got;
+
+  if (!su_block_port_is_plugged(port) || !su_block_port_is_shared(port))
+    return su_block_port_read_internal(port, NULL, start, size);
+
+  /* Samples may be overwritten before being consumed: copy them */
+  if (size > port->fc->output.size)
+    size = port->fc->output.size;
+
+  if (size > port->peek_alloc) {
+    if ((tmp = realloc(port->peek_buf, size * sizeof (SUCOMPLEX))) == NULL) {
+      SU_ERROR("Cannot allocate peek buffer\n");
+      return SU_BLOCK_PORT_READ_ERROR_ACQUIRE;
+    }
+
+    port->peek_buf = tmp;
+    port->peek_alloc = size;
+  }
+
+  if ((got = su_block_port_read_internal(port, port->peek_buf, NULL, size)) > 0)
+    *start = port->peek_buf;
+
+  return got;
+}
+
+SUBOOL
+su_block_port_relocate_stream(su_block_port_t *port)
+{
+  if (!su_block_port_is_plugged(port)) {
+    SU_ERROR("Port not plugged\n");
+    return SU_FALSE;
+  }
+
+  if (port->fc->consumers != 1) {
+    SU_ERROR("Cannot relocate streams read by other ports\n");
+    return SU_FALSE;
+  }
+
+  return su_stream_resize(&port->fc->output, port->fc->output.size);
+}
+
+SUSCOUNT
+su_block_port_get_lag(const su_block_port_t *port)
+{
+  if (!su_block_port_is_plugged(port))
+    return 0;
+
+  return SU_ATOMIC_LOAD(&port->fc->output.pos) - port->pos;
+}
+
+SUBOOL
+su_block_port_is_ready(const su_block_port_t *port)
+{
+  const su_flow_controller_t *fc = port->fc;
+
+  /* Synchronous outputs call acquire() from the reading thread */
+  if (!su_block_port_is_plugged(port) || !fc->async)
+    return SU_TRUE;
+
+  return SU_ATOMIC_LOAD(&fc->output.pos) > port->pos
+      || SU_ATOMIC_LOAD(&fc->eos);
+}
+
+SUBOOL
+su_block_port_consume(su_block_port_t *port, SUSCOUNT size)
+{
+  if (!su_block_port_is_plugged(port)) {
+    SU_ERROR("Port not plugged\n");
+    return SU_FALSE;
+  }
+
+  if (port->pos + size > SU_ATOMIC_LOAD(&port->fc->output.pos)) {
+    SU_ERROR("Cannot consume more samples than available\n");
+    return SU_FALSE;
+  }
+
+  su_block_port_advance(port, size);
+
+  return SU_TRUE;
+}
+
 SUBOOL
 su_block_port_resync(su_block_port_t *port)
 {
@@ -779,11 +1934,25 @@ su_block_port_resync(su_block_port_t *port)
     return SU_FALSE;
   }
 
-  su_flow_controller_enter(port->fc);
+  if (port->fc->kind == SU_FLOW_CONTROL_KIND_BROADCAST) {
+    su_flow_controller_enter(port->fc);
+
+    port->pos = su_flow_controller_tell(port->fc);
+    su_flow_controller_update_tail(port->fc);
 
-  port->pos = su_flow_controller_tell(port->fc);
+    su_flow_controller_leave(port->fc);
+  } else if (port->fc->async) {
+    port->pos = su_flow_controller_tell(port->fc);
+    su_block_port_advance(port, 0);
+  } else if (port->fc->kind == SU_FLOW_CONTROL_KIND_SPSC) {
+    port->pos = su_flow_controller_tell(port->fc);
+  } else {
+    su_flow_controller_enter(port->fc);
 
-  su_flow_controller_leave(port->fc);
+    port->pos = su_flow_controller_tell(port->fc);
+
+    su_flow_controller_leave(port->fc);
+  }
 
   return SU_TRUE;
 }
@@ -792,12 +1961,131 @@ void
 su_block_port_unplug(su_block_port_t *port)
 {
   if (su_block_port_is_plugged(port)) {
-    su_flow_controller_remove_consumer(port->fc, port->reading);
+    su_flow_controller_remove_consumer(port->fc, port, port->reading);
     port->block = NULL;
     port->fc = NULL;
     port->pos = 0;
     port->port_id = 0;
     port->reading = SU_FALSE;
   }
+
+  if (port->peek_buf != NULL) {
+    free(port->peek_buf);
+    port->peek_buf = NULL;
+    port->peek_alloc = 0;
+  }
 }
 
+
+/****************************** Push mode API ********************************/
+/*
+ * Feed the samples available to the readers of a block output to the
+ * process() method of the blocks owning them, and push their output
+ * further downstream. Readers with no such block are left alone.
+ */
+SUPRIVATE SUBOOL
+su_block_propagate(su_block_t *block, unsigned int port_id)
+{
+  su_flow_controller_t *fc = block->out + port_id;
+  su_flow_controller_t *next;
+  su_block_port_t *port;
+  su_block_t *owner;
+  const SUCOMPLEX *x;
+  SUCOMPLEX *y;
+  SUSDIFF got;
+  SUSDIFF len;
+  SUSDIFF produced;
+  uint64_t start;
+  uint64_t ns;
+  unsigned int i;
+
+  for (i = 0; i < fc->reader_count; ++i) {
+    if ((port = fc->reader_list[i]) == NULL
+        || (owner = port->owner) == NULL
+        || owner->classname->process == NULL)
+      continue;
+
+    next = owner->out;
+
+    while ((got = su_stream_peek(
+        &fc->output,
+        port->pos,
+        &x,
+        fc->output.size)) != 0) {
+      if (got < 0) {
+        su_block_port_desync(port);
+        continue;
+      }
+
+      /* Consumer of the next block fell behind, keep samples for later */
+      if ((len = su_stream_get_contiguous(&next->output, &y, got)) == 0)
+        break;
+
+      start = su_block_stats_get_time_ns();
+
+      if ((produced = owner->classname->process(owner->privdata, x, y, len))
+          < 0) {
+        SU_ERROR("%s: process failed\n", owner->classname->name);
+        return SU_FALSE;
+      }
+
+      ns = su_block_stats_get_time_ns() - start;
+
+      su_block_stats_add_acquire(&owner->stats, produced, ns);
+      su_block_stats_add_acquire(&next->stats, produced, ns);
+
+      su_block_port_advance(port, len);
+
+      if (produced > 0) {
+        su_stream_advance_contiguous(&next->output, produced);
+
+        if (next->async)
+          su_flow_controller_wake_up(next);
+
+        if (!su_block_propagate(owner, 0))
+          return SU_FALSE;
+      }
+    }
+  }
+
+  return SU_TRUE;
+}
+
+SUSDIFF
+su_block_push(
+    su_block_t *block,
+    unsigned int port_id,
+    const SUCOMPLEX *data,
+    SUSCOUNT size)
+{
+  su_flow_controller_t *fc;
+  SUCOMPLEX *start;
+  SUSCOUNT chunk;
+  SUSCOUNT pushed = 0;
+
+  if ((fc = su_block_get_flow_controller(block, port_id)) == NULL)
+    return -1;
+
+  while (pushed < size) {
+    if ((chunk = su_stream_get_contiguous(
+        &fc->output,
+        &start,
+        size - pushed)) == 0)
+      break;
+
+    memcpy(start, data + pushed, chunk * sizeof (SUCOMPLEX));
+    su_stream_advance_contiguous(&fc->output, chunk);
+    pushed += chunk;
+
+    su_block_stats_add_acquire(&block->stats, chunk, 0);
+    su_block_stats_add_acquire(&fc->stats, chunk, 0);
+
+    if (fc->async)
+      su_flow_controller_wake_up(fc);
+
+    if (!su_block_propagate(block, port_id))
+      return -1;
+  }
+
+  return pushed;
+}
@@ -33,6 +33,12 @@ extern "C" {
 
 #define SU_BLOCK_STREAM_BUFFER_SIZE 4096
 
+/* Stream size auto-tuning */
+#define SU_BLOCK_AUTOTUNE_INTERVAL_NS 100000000ull /* 100 ms */
+#define SU_BLOCK_AUTOTUNE_LATENCY_NS   10000000ull /* 10 ms */
+#define SU_BLOCK_AUTOTUNE_MIN_SIZE     256
+#define SU_BLOCK_AUTOTUNE_MAX_SIZE     (1 << 20)
+
 #define SU_BLOCK_PORT_READ_END_OF_STREAM          0
 #define SU_BLOCK_PORT_READ_ERROR_NOT_INITIALIZED -1
 #define SU_BLOCK_PORT_READ_ERROR_ACQUIRE         -2
@@ -51,7 +57,26 @@ struct sigutils_stream {
   unsigned int ptr;   /* Buffer pointer */
   unsigned int avail; /* Samples available for reading */
 
-  su_off_t pos;       /* Stream position */
+  /*
+   * Stream position. It is always updated last (and atomically) by the
+   * writer, and together with avail it is all readers rely on. This
+   * enables a single reader to access the stream concurrently without
+   * locking.
+   */
+  su_off_t pos;
+
+  /*
+   * Mirrored streams map the same buffer twice, back to back. This way,
+   * buffer[i] and buffer[i + size] refer to the same sample, and regions
+   * of up to size samples starting anywhere in the buffer are contiguous.
+   */
+  SUBOOL mirrored;
+
+  /*
+   * Bounded streams: if not NULL, points to the read position of the
+   * slowest reader. Contiguous writes will not overwrite samples past it.
+   */
+  const su_off_t *tail;
 };
 
 typedef struct sigutils_stream su_stream_t;
@@ -62,7 +87,9 @@ typedef struct sigutils_stream su_stream_t;
   0,    /* size */              \
   0,    /* ptr */               \
   0,    /* avail */             \
-  0     /* post */              \
+  0,    /* post */              \
+  SU_FALSE, /* mirrored */      \
+  NULL  /* tail */              \
 }
 
 struct sigutils_block;
@@ -87,19 +114,57 @@ enum sigutils_flow_controller_kind {
    * it's not critical that the slaves lose samples.
    */
   SU_FLOW_CONTROL_KIND_MASTER_SLAVE,
+
+  /*
+   * Single producer, single consumer flow control: only one port can be
+   * plugged to the flow controller. Since there is no other reader to
+   * synchronize with, reads are performed without taking the acquire lock.
+   */
+  SU_FLOW_CONTROL_KIND_SPSC,
+
+  /*
+   * Broadcast flow control: every port reads at its own pace, and no port
+   * loses samples. acquire() may be called by any port reaching the end of
+   * the stream, but it will not write more samples than those already read
+   * by the slowest port. Faster ports wait for the slowest one, so as with
+   * BARRIER, each port must read from its own thread. Also works with
+   * asynchronous flow controllers.
+   */
+  SU_FLOW_CONTROL_KIND_BROADCAST,
 };
 
 struct sigutils_block_port;
 
+/*
+ * Runtime counters, kept for every block and for each of its outputs. They
+ * are exposed as read-only INTEGER properties named "stats.<counter>" for
+ * the whole block, and "stats.out<n>.<counter>" for output #n.
+ */
+struct sigutils_block_stats {
+  uint64_t samples;    /* Samples produced by acquire() */
+  uint64_t acquires;   /* Calls to acquire() */
+  uint64_t acquire_ns; /* Time in acquire(), including reads from inputs */
+  uint64_t wait_ns;    /* Time readers and writers slept on flow controllers */
+  uint64_t desyncs;    /* Readers that lost samples and had to resync */
+};
+
+typedef struct sigutils_block_stats su_block_stats_t;
+
 /*
  * Flow controllers ensure safe concurrent access to block output streams.
  * However, this model imposes a restriction: if non-null flow controller is
- * being used, read operation on the flow controller must be performed from
- * one and only one thread, otherwise deadlocks will occur. This happens
- * because after the end of the output stream is reached, the read operation
- * from the first port will sleep until the next port completes. However, since
- * the next port is in the same thread, the next read operation will never
- * take place.
+ * being used, each port reading from the flow controller must do so from
+ * its own thread, otherwise deadlocks will occur. This happens because after
+ * the end of the output stream is reached, the read operation from the first
+ * port will sleep until the next port completes. However, if the next port
+ * is in the same thread, the next read operation will never take place.
+ *
+ * Blocks driven by a su_pipeline_t (see pipeline.h) satisfy this naturally,
+ * as every block reads its inputs from its own worker thread. In that case,
+ * the flow controller is asynchronous: acquire() is called by the worker
+ * thread of the producer, and the output stream becomes a bounded queue
+ * between the producer and its consumer. The same applies to blocks driven
+ * by a su_executor_t (see executor.h), whose worker threads are shared.
  */
 struct sigutils_flow_controller {
   enum sigutils_flow_controller_kind kind;
@@ -110,6 +175,21 @@ struct sigutils_flow_controller {
   unsigned int consumers; /* Number of ports plugged to this flow controller */
   unsigned int pending;   /* Number of ports waiting for new data */
   const struct sigutils_block_port *master; /* Master port */
+  PTR_LIST(struct sigutils_block_port, reader); /* Plugged ports */
+
+  /* Asynchronous flow controllers */
+  SUBOOL async;           /* acquire() is called from a worker thread */
+  enum sigutils_flow_controller_kind sync_kind; /* Kind to restore */
+  su_off_t tail;          /* Read position of the (slowest) consumer */
+  unsigned int waiters;   /* Threads sleeping on acquire_cond */
+  struct sigutils_executor_task *producer; /* Executor task, see executor.h */
+
+  /* Stream size auto-tuning, see su_block_set_autotune */
+  SUBOOL autotune;
+  uint64_t autotune_ns;      /* Start of the current measurement window */
+  uint64_t autotune_samples; /* Samples produced before that */
+
+  su_block_stats_t stats;
 };
 
 typedef struct sigutils_flow_controller su_flow_controller_t;
@@ -124,6 +204,15 @@ struct sigutils_block_port {
   struct sigutils_block *block; /* Input block */
   unsigned int port_id;
   SUBOOL reading;
+  struct sigutils_block *owner; /* Block this port is an input of, if any */
+
+  /* Exposed as "stats.in<n>.<counter>" properties of the reading block */
+  uint64_t max_lag; /* Max. samples between this port and the producer */
+  uint64_t dropped; /* Samples lost in desyncs */
+
+  /* Copies of samples peeked from shared streams, see su_block_port_peek */
+  SUCOMPLEX *peek_buf;
+  SUSCOUNT peek_alloc;
 };
 
 typedef struct sigutils_block_port su_block_port_t;
@@ -141,6 +230,14 @@ struct sigutils_block_class {
 
   /* This function gets called when more data is required */
   SUSDIFF (*acquire) (void *, su_stream_t *, unsigned int, su_block_port_t *);
+
+  /*
+   * Optional, for blocks with one input and one output: process len samples
+   * from x into y, without streams. y may be the same buffer as x, and no
+   * more than len samples may be produced. Returns the number of samples
+   * written to y, or -1 on error. Required by su_block_chain_fuse.
+   */
+  SUSDIFF (*process) (void *, const SUCOMPLEX *x, SUCOMPLEX *y, SUSCOUNT len);
 };
 
 typedef struct sigutils_block_class su_block_class_t;
@@ -155,6 +252,9 @@ struct sigutils_block {
   su_block_port_t      *in; /* Input ports */
   su_flow_controller_t *out; /* Output streams */
   SUSCOUNT              decimation; /* Block decimation */
+  SUSCOUNT              stream_size; /* Output stream size, 0 for default */
+
+  su_block_stats_t      stats; /* All outputs */
 };
 
 typedef struct sigutils_block su_block_t;
@@ -162,8 +262,21 @@ typedef struct sigutils_block su_block_t;
 /* su_stream operations */
 SUBOOL su_stream_init(su_stream_t *stream, SUSCOUNT size);
 
+/*
+ * Initialize a mirrored stream. Size is rounded up to a whole number of
+ * pages. Returns SU_FALSE if mirrored buffers are not supported.
+ */
+SUBOOL su_stream_init_mirrored(su_stream_t *stream, SUSCOUNT size);
+
 void su_stream_finalize(su_stream_t *stream);
 
+/*
+ * Replace the stream buffer by one of a different size. The stream position
+ * is kept, along with the most recent samples that fit in the new buffer.
+ * Zero-copy pointers to the old buffer become invalid.
+ */
+SUBOOL su_stream_resize(su_stream_t *stream, SUSCOUNT size);
+
 void su_stream_write(su_stream_t *stream, const SUCOMPLEX *data, SUSCOUNT size);
 
 SUSCOUNT su_stream_get_contiguous(
@@ -181,9 +294,24 @@ SUSDIFF su_stream_read(
     SUCOMPLEX *data,
     SUSCOUNT size);
 
+/* Zero-copy version of su_stream_read. Stops at the end of the buffer */
+SUSDIFF su_stream_peek(
+    const su_stream_t *stream,
+    su_off_t off,
+    const SUCOMPLEX **start,
+    SUSCOUNT size);
+
 /* su_block operations */
 su_block_t *su_block_new(const char *, ...);
 
+/*
+ * Same as su_block_new, but output streams are stream_size samples long
+ * instead of SU_BLOCK_STREAM_BUFFER_SIZE / decimation. Fast sources may need
+ * bigger streams to absorb scheduling jitter, while small streams keep
+ * slow graphs within the cache.
+ */
+su_block_t *su_block_new_ex(SUSCOUNT stream_size, const char *, ...);
+
 su_block_port_t *su_block_get_port(const su_block_t *, unsigned int);
 
 su_stream_t *su_block_get_stream(const su_block_t *, unsigned int);
@@ -219,13 +347,78 @@ SUBOOL su_block_port_plug(
 
 SUSDIFF su_block_port_read(su_block_port_t *port, SUCOMPLEX *obuf, SUSCOUNT size);
 
+/*
+ * Zero-copy read: instead of copying samples, start is set to point to them
+ * inside the flow controller's stream. Return values are the same as in
+ * su_block_port_read, but unless the stream is mirrored, the number of
+ * samples may be smaller as the region does not wrap around the end of the
+ * stream buffer. The port position is not changed until
+ * su_block_port_consume is called.
+ *
+ * The pointed samples remain valid until this port is read, peeked or
+ * consumed again. In SPSC, BARRIER, BROADCAST and asynchronous outputs the
+ * producer never overwrites samples before this port consumes them, and
+ * neither does a NONE or MASTER_SLAVE output with this port as its only
+ * consumer. When other consumers may trigger acquire() in NONE and
+ * MASTER_SLAVE outputs, samples are copied to a buffer owned by the port.
+ */
+SUSDIFF su_block_port_peek(
+    su_block_port_t *port,
+    const SUCOMPLEX **start,
+    SUSCOUNT size);
+
+SUBOOL su_block_port_consume(su_block_port_t *port, SUSCOUNT size);
+
 /* Sometimes, a port connection may go out of sync. This fixes it */
 SUBOOL su_block_port_resync(su_block_port_t *port);
 
 SUBOOL su_block_port_is_plugged(const su_block_port_t *port);
 
+/*
+ * Reallocate the stream this port reads from in the calling thread, which
+ * under first-touch memory policies places it in the NUMA node of that
+ * thread. This port must be the only consumer, and the producer must not
+ * be writing to the stream meanwhile.
+ */
+SUBOOL su_block_port_relocate_stream(su_block_port_t *port);
+
+/* Samples written to the stream but not read by this port yet */
+SUSCOUNT su_block_port_get_lag(const su_block_port_t *port);
+
+/*
+ * Whether reading from this port returns immediately instead of waiting
+ * for an asynchronous producer: the output is synchronous, or it has
+ * unread samples or reached EOS.
+ */
+SUBOOL su_block_port_is_ready(const su_block_port_t *port);
+
 void su_block_port_unplug(su_block_port_t *port);
 
+su_flow_controller_t *su_block_get_flow_controller(
+    const su_block_t *block,
+    unsigned int id);
+
+/*
+ * Resize an output stream. Must be called from the thread reading from it,
+ * and never on asynchronous outputs or outputs with more than one consumer.
+ */
+SUBOOL su_block_set_stream_size(
+    su_block_t *block,
+    unsigned int port_id,
+    SUSCOUNT size);
+
+/*
+ * Let the output stream size follow the rate at which samples are being
+ * requested: every SU_BLOCK_AUTOTUNE_INTERVAL_NS, the stream is resized to
+ * hold around SU_BLOCK_AUTOTUNE_LATENCY_NS worth of samples. Not available
+ * for asynchronous outputs or outputs with more than one consumer. If more
+ * consumers are plugged later, the stream keeps its current size.
+ */
+SUBOOL su_block_set_autotune(
+    su_block_t *block,
+    unsigned int port_id,
+    SUBOOL autotune);
+
 SUBOOL su_block_force_eos(const su_block_t *block, unsigned int id);
 
 SUBOOL su_block_set_flow_controller(
@@ -238,6 +431,65 @@ SUBOOL su_block_set_master_port(
     unsigned int port_id,
     const su_block_port_t *port);
 
+/*
+ * Asynchronous outputs: consumers no longer call acquire(), which must be
+ * called by some other thread through su_block_produce instead. Only
+ * available for outputs with one consumer at most, unless they use
+ * broadcast flow control. Making the output synchronous again restores
+ * the flow control it had before.
+ */
+SUBOOL su_block_set_async(
+    su_block_t *block,
+    unsigned int port_id,
+    SUBOOL async);
+
+/*
+ * Wait for the consumer of an asynchronous output to make room in the
+ * stream and call acquire() once. EOS is forced on the output if acquire()
+ * fails or returns 0. Returns 0 if the output reached EOS.
+ */
+SUSDIFF su_block_produce(su_block_t *block, unsigned int port_id);
+
+/*
+ * Samples an asynchronous output can take before its consumer must
+ * catch up.
+ */
+SUSCOUNT su_block_get_room(const su_block_t *block, unsigned int port_id);
+
+/*
+ * Fuse a linear chain of blocks into a single block, which runs the
+ * process() method of every stage over small tiles of samples, directly on
+ * its output stream. Every block of the chain must be plugged to the next
+ * one, and nothing else may be plugged to their outputs.
+ *
+ * The input of the first block is moved to the fused block, and consumers
+ * must be plugged to the fused block instead of the last one. Blocks of
+ * the chain keep their state and properties, and must not be destroyed
+ * before the fused block.
+ */
+su_block_t *su_block_chain_fuse(su_block_t **blocks, unsigned int count);
+
+/*
+ * Push mode: write samples to an output of a block (usually a "push"
+ * source block) instead of waiting for them to be pulled by acquire(),
+ * and run them through the blocks reading from it.
+ *
+ * Samples are fed to every block plugged to the output that has a
+ * process() method, whose output is then pushed the same way, and so on.
+ * Other consumers find the samples in the output stream as usual. Graphs
+ * must not be pulled from other threads while pushing, but asynchronous
+ * outputs are safe to read from any thread: their readers wait for pushed
+ * samples instead of calling acquire().
+ *
+ * Returns the number of samples pushed, which may be less than size if
+ * some consumer of a flow controlled output fell behind, or -1 on error.
+ */
+SUSDIFF su_block_push(
+    su_block_t *block,
+    unsigned int port_id,
+    const SUCOMPLEX *data,
+    SUSCOUNT size);
+
 /* su_block_class operations */
 SUBOOL su_block_class_register(struct sigutils_block_class *classname);
 
@@ -93,19 +93,23 @@ su_block_agc_acquire(
   su_agc_t *agc;
   SUSDIFF size;
   SUSDIFF got;
-  int i = 0;
 
   SUCOMPLEX *start;
+  const SUCOMPLEX *input;
 
   agc = (su_agc_t *) priv;
 
   size = su_stream_get_contiguous(out, &start, out->size);
 
   do {
-    if ((got = su_block_port_read(in, start, size)) > 0) {
-      /* Got data, process in place */
-      for (i = 0; i < got; ++i)
-        start[i] = su_agc_feed(agc, start[i]);
+    if ((got = su_block_port_peek(in, &input, size)) > 0) {
+      /* Got data, process into the output stream */
+      su_agc_feed_bulk(agc, input, start, got);
+
+      if (!su_block_port_consume(in, got)) {
+        SU_ERROR("Failed to consume input samples\n");
+        return -1;
+      }
 
       /* Increment position */
       if (su_stream_advance_contiguous(out, got) != got) {
@@ -119,7 +123,7 @@ su_block_agc_acquire(
         return -1;
       }
     } else if (got < 0) {
-      SU_ERROR("su_block_port_read: error %d\n", got);
+      SU_ERROR("su_block_port_peek: error %d\n", got);
       return -1;
     }
   } while (got == SU_BLOCK_PORT_READ_ERROR_PORT_DESYNC);
@@ -127,11 +131,26 @@ su_block_agc_acquire(
   return got;
 }
 
+SUPRIVATE SUSDIFF
+su_block_agc_process(
+    void *priv,
+    const SUCOMPLEX *x,
+    SUCOMPLEX *y,
+    SUSCOUNT len)
+{
+  su_agc_t *agc = (su_agc_t *) priv;
+
+  su_agc_feed_bulk(agc, x, y, len);
+
+  return len;
+}
+
 struct sigutils_block_class su_block_class_AGC = {
     "agc", /* name */
     1,     /* in_size */
     1,     /* out_size */
     su_block_agc_ctor,    /* constructor */
     su_block_agc_dtor,    /* destructor */
-    su_block_agc_acquire  /* acquire */
+    su_block_agc_acquire, /* acquire */
+    su_block_agc_process  /* process */
 };
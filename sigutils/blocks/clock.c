@@ -124,21 +124,22 @@ su_block_cdr_acquire(
   su_clock_detector_t *clock_detector;
   SUSDIFF size;
   SUSDIFF got;
-  int i = 0;
   int p = 0;
   SUCOMPLEX *start;
+  const SUCOMPLEX *input;
 
   clock_detector = (su_clock_detector_t *) priv;
 
   size = su_stream_get_contiguous(out, &start, out->size);
 
   do {
-    if ((got = su_block_port_read(in, start, size)) > 0) {
-      /* Got data, process in place */
-      p = 0;
-      for (i = 0; i < got; ++i) {
-        su_clock_detector_feed(clock_detector, start[i]);
-        p += su_clock_detector_read(clock_detector, start + p, 1);
+    if ((got = su_block_port_peek(in, &input, size)) > 0) {
+      /* Got data, process into the output stream */
+      p = su_clock_detector_feed_bulk(clock_detector, input, start, got);
+
+      if (!su_block_port_consume(in, got)) {
+        SU_ERROR("Failed to consume input samples\n");
+        return -1;
       }
 
       /* Increment position */
@@ -153,7 +154,7 @@ su_block_cdr_acquire(
         return -1;
       }
     } else if (got < 0) {
-      SU_ERROR("su_block_port_read: error %d\n", got);
+      SU_ERROR("su_block_port_peek: error %d\n", got);
       return -1;
     }
   } while (got == SU_BLOCK_PORT_READ_ERROR_PORT_DESYNC
@@ -162,11 +163,24 @@ su_block_cdr_acquire(
   return p;
 }
 
+SUPRIVATE SUSDIFF
+su_block_cdr_process(
+    void *priv,
+    const SUCOMPLEX *x,
+    SUCOMPLEX *y,
+    SUSCOUNT len)
+{
+  su_clock_detector_t *clock_detector = (su_clock_detector_t *) priv;
+
+  return su_clock_detector_feed_bulk(clock_detector, x, y, len);
+}
+
 struct sigutils_block_class su_block_class_CDR = {
     "cdr",      /* name */
     1,          /* in_size */
     1,          /* out_size */
     su_block_cdr_ctor,    /* constructor */
     su_block_cdr_dtor,    /* destructor */
-    su_block_cdr_acquire  /* acquire */
+    su_block_cdr_acquire, /* acquire */
+    su_block_cdr_process  /* process */
 };
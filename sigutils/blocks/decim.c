@@ -0,0 +1,276 @@
+/*
+
+  Copyright (C) 2016 Gonzalo José Carracedo Carballal
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, version 3.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this program.  If not, see
+  <http://www.gnu.org/licenses/>
+
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#define SU_LOG_LEVEL "decim-block"
+
+#include "log.h"
+#include "block.h"
+#include "decim.h"
+
+/*
+ * Both decimators share the same acquire logic, only the way to compute
+ * how many samples to read and how to process them changes.
+ */
+typedef SUSCOUNT (*su_block_decim_max_input_func_t) (const void *, SUSCOUNT);
+typedef SUSCOUNT (*su_block_decim_feed_func_t) (
+    void *,
+    const SUCOMPLEX *,
+    SUSCOUNT,
+    SUCOMPLEX *);
+
+SUPRIVATE SUSDIFF
+su_block_decim_acquire(
+    void *priv,
+    su_stream_t *out,
+    su_block_port_t *in,
+    su_block_decim_max_input_func_t max_input,
+    su_block_decim_feed_func_t feed)
+{
+  SUSCOUNT room;
+  SUSDIFF size;
+  SUSDIFF got;
+  SUSDIFF p = 0;
+
+  SUCOMPLEX *start;
+  const SUCOMPLEX *input;
+
+  room = su_stream_get_contiguous(out, &start, out->size);
+
+  /* Read just what fits in the output stream after decimation */
+  size = (max_input) (priv, room);
+
+  do {
+    if ((got = su_block_port_peek(in, &input, size)) > 0) {
+      /* Got data, process into the output stream */
+      p = (feed) (priv, input, got, start);
+
+      if (!su_block_port_consume(in, got)) {
+        SU_ERROR("Failed to consume input samples\n");
+        return -1;
+      }
+
+      /* Increment position */
+      if ((SUSDIFF) su_stream_advance_contiguous(out, p) != p) {
+        SU_ERROR("Unexpected size after su_stream_advance_contiguous\n");
+        return -1;
+      }
+
+      /* Leftover samples may complete an output now */
+      size = (max_input) (priv, room);
+    } else if (got == SU_BLOCK_PORT_READ_ERROR_PORT_DESYNC) {
+      SU_WARNING("Decimator slow, samples lost\n");
+      if (!su_block_port_resync(in)) {
+        SU_ERROR("Failed to resync\n");
+        return -1;
+      }
+    } else if (got < 0) {
+      SU_ERROR("su_block_port_peek: error %d\n", got);
+      return -1;
+    }
+  } while (got == SU_BLOCK_PORT_READ_ERROR_PORT_DESYNC
+      || (p == 0 && got > 0));
+
+  return got > 0 ? p : got;
+}
+
+/****************************** CIC decimator ********************************/
+SUPRIVATE void
+su_block_cic_dtor(void *private)
+{
+  su_cic_decim_t *cic = (su_cic_decim_t *) private;
+
+  if (cic != NULL) {
+    su_cic_decim_finalize(cic);
+    free(cic);
+  }
+}
+
+SUPRIVATE SUBOOL
+su_block_cic_ctor(struct sigutils_block *block, void **private, va_list ap)
+{
+  su_cic_decim_t *cic = NULL;
+  unsigned int stages;
+  unsigned int decimation;
+
+  (void) block;
+
+  stages     = va_arg(ap, unsigned int);
+  decimation = va_arg(ap, unsigned int);
+
+  SU_TRYCATCH(cic = calloc(1, sizeof (su_cic_decim_t)), goto fail);
+  SU_TRYCATCH(su_cic_decim_init(cic, stages, decimation), goto fail);
+
+  *private = cic;
+
+  return SU_TRUE;
+
+fail:
+  su_block_cic_dtor(cic);
+
+  return SU_FALSE;
+}
+
+SUPRIVATE SUSCOUNT
+su_block_cic_max_input(const void *priv, SUSCOUNT outputs)
+{
+  return su_cic_decim_get_max_input((const su_cic_decim_t *) priv, outputs);
+}
+
+SUPRIVATE SUSCOUNT
+su_block_cic_feed(
+    void *priv,
+    const SUCOMPLEX *x,
+    SUSCOUNT len,
+    SUCOMPLEX *y)
+{
+  return su_cic_decim_feed_bulk((su_cic_decim_t *) priv, x, len, y);
+}
+
+SUPRIVATE SUSDIFF
+su_block_cic_acquire(
+    void *priv,
+    su_stream_t *out,
+    unsigned int port_id,
+    su_block_port_t *in)
+{
+  (void) port_id;
+
+  return su_block_decim_acquire(
+      priv,
+      out,
+      in,
+      su_block_cic_max_input,
+      su_block_cic_feed);
+}
+
+SUPRIVATE SUSDIFF
+su_block_cic_process(
+    void *priv,
+    const SUCOMPLEX *x,
+    SUCOMPLEX *y,
+    SUSCOUNT len)
+{
+  return su_cic_decim_feed_bulk((su_cic_decim_t *) priv, x, len, y);
+}
+
+struct sigutils_block_class su_block_class_CIC = {
+    "cic", /* name */
+    1,     /* in_size */
+    1,     /* out_size */
+    su_block_cic_ctor,    /* constructor */
+    su_block_cic_dtor,    /* destructor */
+    su_block_cic_acquire, /* acquire */
+    su_block_cic_process  /* process */
+};
+
+/*************************** Half-band decimator *****************************/
+SUPRIVATE void
+su_block_halfband_dtor(void *private)
+{
+  su_halfband_decim_t *hb = (su_halfband_decim_t *) private;
+
+  if (hb != NULL) {
+    su_halfband_decim_finalize(hb);
+    free(hb);
+  }
+}
+
+SUPRIVATE SUBOOL
+su_block_halfband_ctor(
+    struct sigutils_block *block,
+    void **private,
+    va_list ap)
+{
+  su_halfband_decim_t *hb = NULL;
+  unsigned int size;
+
+  (void) block;
+
+  size = va_arg(ap, unsigned int);
+
+  SU_TRYCATCH(hb = calloc(1, sizeof (su_halfband_decim_t)), goto fail);
+  SU_TRYCATCH(su_halfband_decim_init(hb, size), goto fail);
+
+  *private = hb;
+
+  return SU_TRUE;
+
+fail:
+  su_block_halfband_dtor(hb);
+
+  return SU_FALSE;
+}
+
+SUPRIVATE SUSCOUNT
+su_block_halfband_max_input(const void *priv, SUSCOUNT outputs)
+{
+  return su_halfband_decim_get_max_input(
+      (const su_halfband_decim_t *) priv,
+      outputs);
+}
+
+SUPRIVATE SUSCOUNT
+su_block_halfband_feed(
+    void *priv,
+    const SUCOMPLEX *x,
+    SUSCOUNT len,
+    SUCOMPLEX *y)
+{
+  return su_halfband_decim_feed_bulk((su_halfband_decim_t *) priv, x, len, y);
+}
+
+SUPRIVATE SUSDIFF
+su_block_halfband_acquire(
+    void *priv,
+    su_stream_t *out,
+    unsigned int port_id,
+    su_block_port_t *in)
+{
+  (void) port_id;
+
+  return su_block_decim_acquire(
+      priv,
+      out,
+      in,
+      su_block_halfband_max_input,
+      su_block_halfband_feed);
+}
+
+SUPRIVATE SUSDIFF
+su_block_halfband_process(
+    void *priv,
+    const SUCOMPLEX *x,
+    SUCOMPLEX *y,
+    SUSCOUNT len)
+{
+  return su_halfband_decim_feed_bulk((su_halfband_decim_t *) priv, x, len, y);
+}
+
+struct sigutils_block_class su_block_class_HALFBAND = {
+    "halfband", /* name */
+    1,          /* in_size */
+    1,          /* out_size */
+    su_block_halfband_ctor,    /* constructor */
+    su_block_halfband_dtor,    /* destructor */
+    su_block_halfband_acquire, /* acquire */
+    su_block_halfband_process  /* process */
+};
@@ -91,19 +91,23 @@ su_block_rrc_acquire(
   su_iir_filt_t *filt;
   SUSDIFF size;
   SUSDIFF got;
-  int i = 0;
 
   SUCOMPLEX *start;
+  const SUCOMPLEX *input;
 
   filt = (su_iir_filt_t *) priv;
 
   size = su_stream_get_contiguous(out, &start, out->size);
 
   do {
-    if ((got = su_block_port_read(in, start, size)) > 0) {
-      /* Got data, process in place */
-      for (i = 0; i < got; ++i)
-        start[i] = su_iir_filt_feed(filt, start[i]);
+    if ((got = su_block_port_peek(in, &input, size)) > 0) {
+      /* Got data, process into the output stream */
+      su_iir_filt_feed_bulk(filt, input, start, got);
+
+      if (!su_block_port_consume(in, got)) {
+        SU_ERROR("Failed to consume input samples\n");
+        return -1;
+      }
 
       /* Increment position */
       if (su_stream_advance_contiguous(out, got) != got) {
@@ -117,7 +121,7 @@ su_block_rrc_acquire(
         return -1;
       }
     } else if (got < 0) {
-      SU_ERROR("su_block_port_read: error %d\n", got);
+      SU_ERROR("su_block_port_peek: error %d\n", got);
       return -1;
     }
   } while (got == SU_BLOCK_PORT_READ_ERROR_PORT_DESYNC);
@@ -125,11 +129,26 @@ su_block_rrc_acquire(
   return got;
 }
 
+SUPRIVATE SUSDIFF
+su_block_rrc_process(
+    void *priv,
+    const SUCOMPLEX *x,
+    SUCOMPLEX *y,
+    SUSCOUNT len)
+{
+  su_iir_filt_t *filt = (su_iir_filt_t *) priv;
+
+  su_iir_filt_feed_bulk(filt, x, y, len);
+
+  return len;
+}
+
 struct sigutils_block_class su_block_class_RRC = {
     "rrc", /* name */
     1,     /* in_size */
     1,     /* out_size */
     su_block_rrc_ctor,    /* constructor */
     su_block_rrc_dtor,    /* destructor */
-    su_block_rrc_acquire  /* acquire */
+    su_block_rrc_acquire, /* acquire */
+    su_block_rrc_process  /* process */
 };
@@ -0,0 +1,171 @@
+/*
+
+  Copyright (C) 2016 Gonzalo José Carracedo Carballal
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, version 3.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this program.  If not, see
+  <http://www.gnu.org/licenses/>
+
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#define SU_LOG_LEVEL "fused-block"
+
+#include "log.h"
+#include "block.h"
+
+/* Small enough for a tile to stay in L1 while all stages go through it */
+#define SU_BLOCK_FUSED_TILE_SIZE 2048
+
+/* Created by su_block_chain_fuse */
+struct sigutils_fused_block {
+  su_block_t **stage_list;
+  unsigned int stage_count;
+};
+
+typedef struct sigutils_fused_block su_fused_block_t;
+
+SUPRIVATE void
+su_block_fused_dtor(void *private)
+{
+  su_fused_block_t *fused = (su_fused_block_t *) private;
+
+  if (fused != NULL) {
+    if (fused->stage_list != NULL)
+      free(fused->stage_list);
+
+    free(fused);
+  }
+}
+
+SUPRIVATE SUBOOL
+su_block_fused_ctor(struct sigutils_block *block, void **private, va_list ap)
+{
+  su_fused_block_t *fused = NULL;
+  su_block_t **stage_list;
+  unsigned int stage_count;
+
+  stage_list  = va_arg(ap, su_block_t **);
+  stage_count = va_arg(ap, unsigned int);
+
+  SU_TRYCATCH(fused = calloc(1, sizeof (su_fused_block_t)), goto fail);
+
+  SU_TRYCATCH(
+      fused->stage_list = malloc(stage_count * sizeof (su_block_t *)),
+      goto fail);
+
+  memcpy(fused->stage_list, stage_list, stage_count * sizeof (su_block_t *));
+  fused->stage_count = stage_count;
+
+  *private = fused;
+
+  return SU_TRUE;
+
+fail:
+  su_block_fused_dtor(fused);
+
+  return SU_FALSE;
+}
+
+/*
+ * Run every stage over the same tile of the output stream before moving
+ * on to the next one.
+ */
+SUPRIVATE SUSDIFF
+su_block_fused_process(
+    void *priv,
+    const SUCOMPLEX *x,
+    SUCOMPLEX *y,
+    SUSCOUNT len)
+{
+  su_fused_block_t *fused = (su_fused_block_t *) priv;
+  su_block_t *stage;
+  SUSDIFF got = len;
+  unsigned int i;
+
+  for (i = 0; i < fused->stage_count && got > 0; ++i) {
+    stage = fused->stage_list[i];
+
+    if ((got = stage->classname->process(stage->privdata, x, y, got)) < 0) {
+      SU_ERROR("%s: process failed\n", stage->classname->name);
+      return -1;
+    }
+
+    x = y;
+  }
+
+  return got;
+}
+
+SUPRIVATE SUSDIFF
+su_block_fused_acquire(
+    void *priv,
+    su_stream_t *out,
+    unsigned int port_id,
+    su_block_port_t *in)
+{
+  su_fused_block_t *fused;
+  SUSDIFF size;
+  SUSDIFF got;
+  SUSDIFF p = 0;
+
+  SUCOMPLEX *start;
+  const SUCOMPLEX *input;
+
+  fused = (su_fused_block_t *) priv;
+
+  size = su_stream_get_contiguous(out, &start, out->size);
+  size = SU_MIN(size, SU_BLOCK_FUSED_TILE_SIZE);
+
+  do {
+    if ((got = su_block_port_peek(in, &input, size)) > 0) {
+      /* Got data, process into the output stream */
+      if ((p = su_block_fused_process(fused, input, start, got)) < 0)
+        return -1;
+
+      if (!su_block_port_consume(in, got)) {
+        SU_ERROR("Failed to consume input samples\n");
+        return -1;
+      }
+
+      /* Increment position */
+      if (su_stream_advance_contiguous(out, p) != p) {
+        SU_ERROR("Unexpected size after su_stream_advance_contiguous\n");
+        return -1;
+      }
+    } else if (got == SU_BLOCK_PORT_READ_ERROR_PORT_DESYNC) {
+      SU_WARNING("Fused block slow, samples lost\n");
+      if (!su_block_port_resync(in)) {
+        SU_ERROR("Failed to resync\n");
+        return -1;
+      }
+    } else if (got < 0) {
+      SU_ERROR("su_block_port_peek: error %d\n", got);
+      return -1;
+    }
+  } while (got == SU_BLOCK_PORT_READ_ERROR_PORT_DESYNC
+      || (p == 0 && got > 0));
+
+  return p;
+}
+
+struct sigutils_block_class su_block_class_FUSED = {
+    "fused", /* name */
+    1,       /* in_size */
+    1,       /* out_size */
+    su_block_fused_ctor,    /* constructor */
+    su_block_fused_dtor,    /* destructor */
+    su_block_fused_acquire, /* acquire */
+    su_block_fused_process  /* process */
+};
@@ -109,20 +109,22 @@ su_block_costas_acquire(
   su_costas_t *costas;
   SUSDIFF size;
   SUSDIFF got;
-  int i = 0;
 
   SUCOMPLEX *start;
+  const SUCOMPLEX *input;
 
   costas = (su_costas_t *) priv;
 
   size = su_stream_get_contiguous(out, &start, out->size);
 
   do {
-    if ((got = su_block_port_read(in, start, size)) > 0) {
-      /* Got data, process in place */
-      for (i = 0; i < got; ++i) {
-        su_costas_feed(costas, start[i]);
-        start[i] = costas->y;
+    if ((got = su_block_port_peek(in, &input, size)) > 0) {
+      /* Got data, process into the output stream */
+      su_costas_feed_bulk(costas, input, start, got);
+
+      if (!su_block_port_consume(in, got)) {
+        SU_ERROR("Failed to consume input samples\n");
+        return -1;
       }
 
       /* Increment position */
@@ -137,7 +139,7 @@ su_block_costas_acquire(
         return -1;
       }
     } else if (got < 0) {
-      SU_ERROR("su_block_port_read: error %d\n", got);
+      SU_ERROR("su_block_port_peek: error %d\n", got);
       return -1;
     }
   } while (got == SU_BLOCK_PORT_READ_ERROR_PORT_DESYNC);
@@ -145,11 +147,26 @@ su_block_costas_acquire(
   return got;
 }
 
+SUPRIVATE SUSDIFF
+su_block_costas_process(
+    void *priv,
+    const SUCOMPLEX *x,
+    SUCOMPLEX *y,
+    SUSCOUNT len)
+{
+  su_costas_t *costas = (su_costas_t *) priv;
+
+  su_costas_feed_bulk(costas, x, y, len);
+
+  return len;
+}
+
 struct sigutils_block_class su_block_class_COSTAS = {
     "costas",   /* name */
     1,          /* in_size */
     1,          /* out_size */
     su_block_costas_ctor,    /* constructor */
     su_block_costas_dtor,    /* destructor */
-    su_block_costas_acquire  /* acquire */
+    su_block_costas_acquire, /* acquire */
+    su_block_costas_process  /* process */
 };
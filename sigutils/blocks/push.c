@@ -0,0 +1,61 @@
+/*
+
+  Copyright (C) 2016 Gonzalo José Carracedo Carballal
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, version 3.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this program.  If not, see
+  <http://www.gnu.org/licenses/>
+
+*/
+
+#define SU_LOG_LEVEL "push-block"
+
+#include "log.h"
+#include "block.h"
+
+/*
+ * Source block for push-driven graphs: it has no samples of its own, they
+ * are written to its output with su_block_push.
+ */
+SUPRIVATE SUBOOL
+su_block_push_ctor(struct sigutils_block *block, void **private, va_list ap)
+{
+  *private = NULL;
+
+  return SU_TRUE;
+}
+
+SUPRIVATE void
+su_block_push_dtor(void *private)
+{
+}
+
+/* Nothing to pull: readers only get what has been pushed */
+SUPRIVATE SUSDIFF
+su_block_push_acquire(
+    void *priv,
+    su_stream_t *out,
+    unsigned int port_id,
+    su_block_port_t *in)
+{
+  return 0;
+}
+
+struct sigutils_block_class su_block_class_PUSH = {
+    "push", /* name */
+    0,      /* in_size */
+    1,      /* out_size */
+    su_block_push_ctor,    /* constructor */
+    su_block_push_dtor,    /* destructor */
+    su_block_push_acquire, /* acquire */
+    NULL                   /* process */
+};
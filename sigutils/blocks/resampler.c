@@ -0,0 +1,200 @@
+/*
+
+  Copyright (C) 2016 Gonzalo José Carracedo Carballal
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, version 3.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this program.  If not, see
+  <http://www.gnu.org/licenses/>
+
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#define SU_LOG_LEVEL "resampler-block"
+
+#include "log.h"
+#include "block.h"
+#include "resampler.h"
+
+struct su_resampler_state {
+  su_resampler_t resampler;
+
+  /* Outputs of one input sample that did not fit in the output stream */
+  SUCOMPLEX *pending;
+  SUSCOUNT pending_len;
+  SUSCOUNT pending_ptr;
+};
+
+SUPRIVATE void
+su_block_resampler_dtor(void *private)
+{
+  struct su_resampler_state *state = (struct su_resampler_state *) private;
+
+  if (state != NULL) {
+    su_resampler_finalize(&state->resampler);
+
+    if (state->pending != NULL)
+      free(state->pending);
+
+    free(state);
+  }
+}
+
+SUPRIVATE SUBOOL
+su_block_resampler_ctor(
+    struct sigutils_block *block,
+    void **private,
+    va_list ap)
+{
+  struct su_resampler_state *state = NULL;
+  unsigned int interp;
+  unsigned int decim;
+
+  (void) block;
+
+  interp = va_arg(ap, unsigned int);
+  decim  = va_arg(ap, unsigned int);
+
+  SU_TRYCATCH(state = calloc(1, sizeof (struct su_resampler_state)), goto fail);
+
+  SU_TRYCATCH(
+      su_resampler_init(&state->resampler, interp, decim, 0),
+      goto fail);
+
+  SU_TRYCATCH(
+      state->pending = malloc(
+          su_resampler_get_max_output(&state->resampler, 1)
+          * sizeof (SUCOMPLEX)),
+      goto fail);
+
+  *private = state;
+
+  return SU_TRUE;
+
+fail:
+  su_block_resampler_dtor(state);
+
+  return SU_FALSE;
+}
+
+SUPRIVATE SUSDIFF
+su_block_resampler_flush(struct su_resampler_state *state, su_stream_t *out)
+{
+  SUCOMPLEX *start;
+  SUSDIFF size;
+
+  size = su_stream_get_contiguous(
+      out,
+      &start,
+      state->pending_len - state->pending_ptr);
+
+  memcpy(start, state->pending + state->pending_ptr, size * sizeof (SUCOMPLEX));
+
+  if ((SUSDIFF) su_stream_advance_contiguous(out, size) != size) {
+    SU_ERROR("Unexpected size after su_stream_advance_contiguous\n");
+    return -1;
+  }
+
+  if ((state->pending_ptr += size) == state->pending_len)
+    state->pending_ptr = state->pending_len = 0;
+
+  return size;
+}
+
+SUPRIVATE SUSDIFF
+su_block_resampler_acquire(
+    void *priv,
+    su_stream_t *out,
+    unsigned int port_id,
+    su_block_port_t *in)
+{
+  struct su_resampler_state *state;
+  SUSCOUNT room;
+  SUSDIFF size;
+  SUSDIFF got;
+  SUSDIFF p = 0;
+
+  SUCOMPLEX *start;
+  const SUCOMPLEX *input;
+
+  (void) port_id;
+
+  state = (struct su_resampler_state *) priv;
+
+  if (state->pending_len > 0)
+    return su_block_resampler_flush(state, out);
+
+  room = su_stream_get_contiguous(out, &start, out->size);
+
+  do {
+    /* Read just what fits in the output stream after resampling */
+    size = su_resampler_get_max_input(&state->resampler, room);
+
+    /*
+     * If not even one input sample fits, resample it apart and write
+     * what we can. The rest is written in the next call.
+     */
+    if ((got = su_block_port_peek(in, &input, SU_MAX(size, 1))) > 0) {
+      if (size == 0) {
+        state->pending_len = su_resampler_feed_bulk(
+            &state->resampler,
+            input,
+            1,
+            state->pending);
+        got = 1;
+      } else {
+        p = su_resampler_feed_bulk(&state->resampler, input, got, start);
+      }
+
+      if (!su_block_port_consume(in, got)) {
+        SU_ERROR("Failed to consume input samples\n");
+        return -1;
+      }
+
+      if (size == 0)
+        return su_block_resampler_flush(state, out);
+
+      /* Increment position */
+      if ((SUSDIFF) su_stream_advance_contiguous(out, p) != p) {
+        SU_ERROR("Unexpected size after su_stream_advance_contiguous\n");
+        return -1;
+      }
+    } else if (got == SU_BLOCK_PORT_READ_ERROR_PORT_DESYNC) {
+      SU_WARNING("Resampler slow, samples lost\n");
+      if (!su_block_port_resync(in)) {
+        SU_ERROR("Failed to resync\n");
+        return -1;
+      }
+    } else if (got < 0) {
+      SU_ERROR("su_block_port_peek: error %d\n", got);
+      return -1;
+    }
+  } while (got == SU_BLOCK_PORT_READ_ERROR_PORT_DESYNC
+      || (p == 0 && got > 0));
+
+  return got > 0 ? p : got;
+}
+
+/*
+ * No process() method: when interpolating, more samples than those read
+ * are produced, and this block cannot be fused.
+ */
+struct sigutils_block_class su_block_class_RESAMPLER = {
+    "resampler", /* name */
+    1,           /* in_size */
+    1,           /* out_size */
+    su_block_resampler_ctor,    /* constructor */
+    su_block_resampler_dtor,    /* destructor */
+    su_block_resampler_acquire, /* acquire */
+    NULL                        /* process */
+};
@@ -197,4 +197,5 @@ struct sigutils_block_class su_block_class_SIGGEN = {
     su_block_siggen_ctor,     /* constructor */
     su_block_siggen_dtor,     /* destructor */
     su_block_siggen_acquire, /* acquire */
+    NULL                     /* process */
 };
@@ -26,6 +26,10 @@
 #include "ncqo.h"
 #include "iir.h"
 #include "taps.h"
+#include "decim.h"
+
+/* Mixing buffer size when decimating */
+#define SU_TUNER_DECIM_STRIDE 256
 
 /* A tuner is just a NCQO + Low pass filter */
 struct sigutils_tuner {
@@ -36,12 +40,19 @@ struct sigutils_tuner {
   /* Filter params */
   SUFLOAT bw;          /* Bandwidth */
   unsigned int h_size; /* Filter size */
+  SUFLOAT *taps;       /* Private copy of bpf taps, exposed as "taps" */
+
+  /* Decimation: bpf taps are evaluated for the kept outputs only */
+  su_fir_decim_t decim;
+  uint64_t decimation;
 
   /* Configurable params */
   SUFLOAT      rq_bw;
   unsigned int rq_h_size;
   SUFLOAT      rq_if_off;
   SUFLOAT      rq_fc; /* Center frequency (1 ~ fs/2), hcps */
+  SUBOOL       rq_phasor; /* Phasor-rotation local oscillator */
+  uint64_t     rq_decimation;
 };
 
 typedef struct sigutils_tuner su_tuner_t;
@@ -58,13 +69,85 @@ su_tuner_filter_has_changed(su_tuner_t *tu)
 SUPRIVATE SUBOOL
 su_tuner_lo_has_changed(su_tuner_t *tu)
 {
-  return su_ncqo_get_freq(&tu->lo) != tu->if_off - tu->rq_fc;
+  return su_ncqo_get_freq(&tu->lo) != tu->if_off - tu->rq_fc
+      || tu->lo.phasor != tu->rq_phasor;
 }
 
-SUPRIVATE SUCOMPLEX
-su_tuner_feed(su_tuner_t *tu, SUCOMPLEX samp)
+SUPRIVATE void
+su_tuner_update_lo(su_tuner_t *tu)
+{
+  if (tu->lo.phasor != tu->rq_phasor)
+    su_ncqo_set_phasor(&tu->lo, tu->rq_phasor);
+
+  su_ncqo_set_freq(&tu->lo, tu->if_off - tu->rq_fc);
+}
+
+SUPRIVATE SUBOOL
+su_tuner_update_decim(su_tuner_t *tu)
+{
+  su_fir_decim_finalize(&tu->decim);
+  tu->decimation = 1;
+
+  if (tu->rq_decimation > 1) {
+    SU_TRYCATCH(
+        su_fir_decim_init(
+            &tu->decim,
+            tu->rq_decimation,
+            tu->bpf.b,
+            tu->h_size),
+        return SU_FALSE);
+
+    tu->decimation = tu->rq_decimation;
+  }
+
+  return SU_TRUE;
+}
+
+/* LO and decimation changes take effect at chunk boundaries */
+SUPRIVATE SUBOOL
+su_tuner_apply_changes(su_tuner_t *tu)
+{
+  if (su_tuner_lo_has_changed(tu))
+    su_tuner_update_lo(tu);
+
+  if (tu->rq_decimation != tu->decimation)
+    SU_TRYCATCH(su_tuner_update_decim(tu), return SU_FALSE);
+
+  return SU_TRUE;
+}
+
+/*
+ * Mix the whole chunk first, then filter it in place. When decimating, y
+ * only needs room for the output samples, so input is mixed in strides.
+ * Returns the number of output samples.
+ */
+SUPRIVATE SUSCOUNT
+su_tuner_feed_bulk(
+    su_tuner_t *tu,
+    const SUCOMPLEX *x,
+    SUCOMPLEX *y,
+    SUSCOUNT len)
 {
-  return su_iir_filt_feed(&tu->bpf, samp * su_ncqo_read(&tu->lo));
+  SUCOMPLEX mix[SU_TUNER_DECIM_STRIDE];
+  SUSCOUNT i, chunk;
+  SUSCOUNT n = 0;
+
+  if (tu->decimation > 1) {
+    for (i = 0; i < len; i += chunk) {
+      chunk = SU_MIN(len - i, SU_TUNER_DECIM_STRIDE);
+
+      su_ncqo_mix_bulk(&tu->lo, x + i, mix, chunk);
+      n += su_fir_decim_feed_bulk(&tu->decim, mix, chunk, y + n);
+    }
+
+    return n;
+  }
+
+  su_ncqo_mix_bulk(&tu->lo, x, y, len);
+
+  su_iir_filt_feed_bulk(&tu->bpf, y, y, len);
+
+  return len;
 }
 
 SUPRIVATE SUCOMPLEX
@@ -77,6 +160,7 @@ SUPRIVATE SUBOOL
 su_tuner_update_filter(su_tuner_t *tu)
 {
   su_iir_filt_t bpf_new = su_iir_filt_INITIALIZER;
+  SUFLOAT *taps;
 
   /* If baudrate has changed, we must change the LPF */
   if (!su_iir_brickwall_bp_init(
@@ -86,6 +170,13 @@ su_tuner_update_filter(su_tuner_t *tu)
       tu->rq_if_off))
     goto fail;
 
+  /* bpf_new.b is shared with other filters: never expose it directly */
+  if ((taps = realloc(tu->taps, tu->rq_h_size * sizeof (SUFLOAT))) == NULL)
+    goto fail;
+
+  memcpy(taps, bpf_new.b, tu->rq_h_size * sizeof (SUFLOAT));
+  tu->taps = taps;
+
   tu->bw     = tu->rq_bw;
   tu->h_size = tu->rq_h_size;
   tu->if_off = tu->rq_if_off;
@@ -101,16 +192,15 @@ fail:
   return SU_FALSE;
 }
 
-SUPRIVATE void
-su_tuner_update_lo(su_tuner_t *tu)
-{
-  su_ncqo_set_freq(&tu->lo, tu->if_off - tu->rq_fc);
-}
-
 void
 su_tuner_destroy(su_tuner_t *tu)
 {
   su_iir_filt_finalize(&tu->bpf);
+  su_fir_decim_finalize(&tu->decim);
+
+  if (tu->taps != NULL)
+    free(tu->taps);
+
   free(tu);
 }
 
@@ -127,6 +217,9 @@ su_tuner_new(SUFLOAT fc, SUFLOAT bw, SUFLOAT if_off, SUSCOUNT size)
   new->rq_if_off = if_off;
   new->rq_h_size = size;
 
+  new->decimation    = 1;
+  new->rq_decimation = 1;
+
   if (!su_tuner_update_filter(new))
     goto fail;
 
@@ -188,11 +281,23 @@ su_block_tuner_ctor(struct sigutils_block *block, void **private, va_list ap)
       "size",
       &tu->rq_h_size);
 
+  ok = ok && su_block_set_property_ref(
+      block,
+      SU_PROPERTY_TYPE_BOOL,
+      "phasor",
+      &tu->rq_phasor);
+
+  ok = ok && su_block_set_property_ref(
+      block,
+      SU_PROPERTY_TYPE_INTEGER,
+      "decimation",
+      &tu->rq_decimation);
+
   ok = ok && su_block_set_property_ref(
       block,
       SU_PROPERTY_TYPE_FLOAT,
       "taps",
-      tu->bpf.b);
+      tu->taps);
 
 done:
   if (!ok) {
@@ -227,22 +332,34 @@ su_block_tuner_acquire(
   su_tuner_t *tu;
   SUSDIFF size;
   SUSDIFF got;
-  int i = 0;
+  SUSDIFF p = 0;
 
   SUCOMPLEX *start;
+  const SUCOMPLEX *input;
 
   tu  = (su_tuner_t *) priv;
 
+  if (!su_tuner_apply_changes(tu))
+    return -1;
+
   size = su_stream_get_contiguous(out, &start, out->size);
 
+  /* Read just what fits in the output stream after decimation */
+  if (tu->decimation > 1)
+    size = su_fir_decim_get_max_input(&tu->decim, size);
+
   do {
-    if ((got = su_block_port_read(in, start, size)) > 0) {
-      /* Got data, process in place */
-      for (i = 0; i < got; ++i)
-        start[i] = su_tuner_feed(tu, start[i]);
+    if ((got = su_block_port_peek(in, &input, size)) > 0) {
+      /* Got data, process into the output stream */
+      p = su_tuner_feed_bulk(tu, input, start, got);
+
+      if (!su_block_port_consume(in, got)) {
+        SU_ERROR("Failed to consume input samples\n");
+        return -1;
+      }
 
       /* Increment position */
-      if (su_stream_advance_contiguous(out, got) != got) {
+      if (su_stream_advance_contiguous(out, p) != p) {
         SU_ERROR("Unexpected size after su_stream_advance_contiguous\n");
         return -1;
       }
@@ -253,12 +370,28 @@ su_block_tuner_acquire(
         return -1;
       }
     } else if (got < 0) {
-      SU_ERROR("su_block_port_read: error %d\n", got);
+      SU_ERROR("su_block_port_peek: error %d\n", got);
       return -1;
     }
-  } while (got == SU_BLOCK_PORT_READ_ERROR_PORT_DESYNC);
+  } while (got == SU_BLOCK_PORT_READ_ERROR_PORT_DESYNC
+      || (p == 0 && got > 0));
+
+  return got > 0 ? p : got;
+}
+
+SUPRIVATE SUSDIFF
+su_block_tuner_process(
+    void *priv,
+    const SUCOMPLEX *x,
+    SUCOMPLEX *y,
+    SUSCOUNT len)
+{
+  su_tuner_t *tu = (su_tuner_t *) priv;
+
+  if (!su_tuner_apply_changes(tu))
+    return -1;
 
-  return got;
+  return su_tuner_feed_bulk(tu, x, y, len);
 }
 
 struct sigutils_block_class su_block_class_TUNER = {
@@ -267,6 +400,7 @@ struct sigutils_block_class su_block_class_TUNER = {
     1,       /* out_size */
     su_block_tuner_ctor,    /* constructor */
     su_block_tuner_dtor,    /* destructor */
-    su_block_tuner_acquire  /* acquire */
+    su_block_tuner_acquire, /* acquire */
+    su_block_tuner_process  /* process */
 };
 
@@ -192,4 +192,5 @@ struct sigutils_block_class su_block_class_WAVFILE = {
     su_block_wavfile_ctor,     /* constructor */
     su_block_wavfile_dtor,     /* destructor */
     su_block_wavfile_acquire, /* acquire */
+    NULL                      /* process */
 };
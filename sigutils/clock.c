@@ -25,6 +25,45 @@
 #include "clock.h"
 
 
+/*
+ * Farrow interpolator
+ */
+
+SUSCOUNT
+su_farrow_feed_bulk(
+    su_farrow_t *self,
+    SUFLOAT *phase,
+    SUFLOAT period,
+    const SUCOMPLEX *x,
+    SUSCOUNT len,
+    SUCOMPLEX *y)
+{
+  su_farrow_t hist = *self;
+  SUFLOAT ph = *phase;
+  SUSCOUNT i;
+  SUSCOUNT p = 0;
+
+  /*
+   * Work on a local copy of the history: every input sample is read into
+   * it before any output is written, and outputs never get ahead of the
+   * inputs. This allows y to be x.
+   */
+  for (i = 0; i < len; ++i) {
+    su_farrow_push(&hist, x[i]);
+    ph += 1;
+    if (ph >= period) {
+      ph -= period;
+      if (ph < 1)
+        y[p++] = su_farrow_get(&hist, 1 - ph);
+    }
+  }
+
+  *self = hist;
+  *phase = ph;
+
+  return p;
+}
+
 /*
  * Fixed sampler
  */
@@ -41,8 +80,8 @@ su_sampler_init(su_sampler_t *self, SUFLOAT bnor)
     self->period = 0;
 
   self->phase = 0;
-  self->prev = 0;
   self->phase0_rel = 0;
+  su_farrow_reset(&self->interp);
 
   return SU_TRUE;
 }
@@ -76,6 +115,31 @@ su_sampler_set_phase(su_sampler_t *self, SUFLOAT phase)
   self->phase = self->period * phase;
 }
 
+SUSCOUNT
+su_sampler_feed_bulk(
+    su_sampler_t *self,
+    const SUCOMPLEX *x,
+    SUCOMPLEX *y,
+    SUSCOUNT len)
+{
+  SUSCOUNT i;
+
+  if (self->period >= 1.)
+    return su_farrow_feed_bulk(
+        &self->interp,
+        &self->phase,
+        self->period,
+        x,
+        len,
+        y);
+
+  /* Sampler disabled: just keep the history up to date */
+  for (i = 0; i < len; ++i)
+    su_farrow_push(&self->interp, x[i]);
+
+  return 0;
+}
+
 void
 su_sampler_finalize(su_sampler_t *self)
 {
@@ -151,17 +215,19 @@ su_clock_detector_set_bnor_limits(
   return SU_TRUE;
 }
 
-void
-su_clock_detector_feed(su_clock_detector_t *cd, SUCOMPLEX val)
+/* Returns SU_TRUE if a new symbol was stored in sym */
+SUINLINE SUBOOL
+__su_clock_detector_feed(
+    su_clock_detector_t *cd,
+    SUCOMPLEX val,
+    SUCOMPLEX *sym)
 {
-  SUFLOAT alpha;
+  SUFLOAT delta;
   SUFLOAT e;
   SUCOMPLEX p;
+  SUBOOL have_sym = SU_FALSE;
 
-  if (cd->algo == SU_CLOCK_DETECTOR_ALGORITHM_NONE) {
-    SU_ERROR("Invalid clock detector\n");
-    return;
-  }
+  su_farrow_push(&cd->interp, val);
 
   /* Increment phase */
   cd->phi += cd->bnor;
@@ -172,10 +238,17 @@ su_clock_detector_feed(su_clock_detector_t *cd, SUCOMPLEX val)
         /* Toggle halfcycle flag */
         cd->halfcycle = !cd->halfcycle;
 
-        /* Interpolate between this and previous sample */
-        alpha = cd->bnor * (cd->phi - .5);
+        /*
+         * The half symbol boundary was crossed delta samples ago. Loop
+         * corrections may move phi by more than a sample: in that case,
+         * take the oldest point we can interpolate.
+         */
+        if (cd->phi - .5 < cd->bnor)
+          delta = (cd->phi - .5) / cd->bnor;
+        else
+          delta = 1;
 
-        p = (1 - alpha) * val + alpha * cd->prev;
+        p = su_farrow_get(&cd->interp, 1 - delta);
 
         cd->phi -= .5;
         if (!cd->halfcycle) {
@@ -195,7 +268,8 @@ su_clock_detector_feed(su_clock_detector_t *cd, SUCOMPLEX val)
           if (cd->bnor < cd->bmin)
             cd->bnor = cd->bmin;
 
-          su_stream_write(&cd->sym_stream, &p, 1);
+          *sym = p;
+          have_sym = SU_TRUE;
         } else {
           cd->x[1] = p;
         }
@@ -206,7 +280,42 @@ su_clock_detector_feed(su_clock_detector_t *cd, SUCOMPLEX val)
       SU_ERROR("Unsupported clock detection algorithm\n");
   }
 
-  cd->prev = val;
+  return have_sym;
+}
+
+void
+su_clock_detector_feed(su_clock_detector_t *cd, SUCOMPLEX val)
+{
+  SUCOMPLEX sym;
+
+  if (cd->algo == SU_CLOCK_DETECTOR_ALGORITHM_NONE) {
+    SU_ERROR("Invalid clock detector\n");
+    return;
+  }
+
+  if (__su_clock_detector_feed(cd, val, &sym))
+    su_stream_write(&cd->sym_stream, &sym, 1);
+}
+
+SUSCOUNT
+su_clock_detector_feed_bulk(
+    su_clock_detector_t *cd,
+    const SUCOMPLEX *x,
+    SUCOMPLEX *y,
+    SUSCOUNT len)
+{
+  SUSCOUNT i;
+  SUSCOUNT p = 0;
+
+  if (cd->algo == SU_CLOCK_DETECTOR_ALGORITHM_NONE) {
+    SU_ERROR("Invalid clock detector\n");
+    return 0;
+  }
+
+  for (i = 0; i < len; ++i)
+    p += __su_clock_detector_feed(cd, x[i], y + p);
+
+  return p;
 }
 
 SUSDIFF
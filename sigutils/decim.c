@@ -0,0 +1,413 @@
+/*
+
+  Copyright (C) 2016 Gonzalo José Carracedo Carballal
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, version 3.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this program.  If not, see
+  <http://www.gnu.org/licenses/>
+
+*/
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#define SU_LOG_DOMAIN "decim"
+
+#include "log.h"
+#include "decim.h"
+#include "taps.h"
+
+SUINLINE void
+__su_fir_decim_push(su_fir_decim_t *decim, SUCOMPLEX x)
+{
+  decim->x[decim->x_ptr] = x;
+  decim->x[decim->x_ptr + decim->size] = x;
+
+  if (++decim->x_ptr == decim->size)
+    decim->x_ptr = 0;
+}
+
+/* Last size samples are in x[x_ptr ... x_ptr + size - 1], oldest first */
+SUINLINE SUCOMPLEX
+__su_fir_decim_eval(const su_fir_decim_t *decim)
+{
+  const SUCOMPLEX *x = decim->x + decim->x_ptr;
+  SUCOMPLEX y = 0;
+  unsigned int i;
+
+  for (i = 0; i < decim->size; ++i)
+    y += decim->h[i] * x[i];
+
+  return y;
+}
+
+void
+su_fir_decim_finalize(su_fir_decim_t *decim)
+{
+  if (decim->h != NULL)
+    free(decim->h);
+
+  if (decim->x != NULL)
+    free(decim->x);
+
+  decim->h = NULL;
+  decim->x = NULL;
+}
+
+SUBOOL
+su_fir_decim_init(
+    su_fir_decim_t *decim,
+    unsigned int decimation,
+    const SUFLOAT *h,
+    SUSCOUNT size)
+{
+  unsigned int i;
+
+  SU_TRYCATCH(decimation > 0, return SU_FALSE);
+  SU_TRYCATCH(size > 0, return SU_FALSE);
+
+  memset(decim, 0, sizeof (su_fir_decim_t));
+
+  decim->decimation = decimation;
+  decim->size = size;
+
+  SU_TRYCATCH(decim->h = malloc(size * sizeof (SUFLOAT)), goto fail);
+  SU_TRYCATCH(decim->x = calloc(2 * size, sizeof (SUCOMPLEX)), goto fail);
+
+  for (i = 0; i < size; ++i)
+    decim->h[i] = h[size - i - 1];
+
+  return SU_TRUE;
+
+fail:
+  su_fir_decim_finalize(decim);
+
+  return SU_FALSE;
+}
+
+SUBOOL
+su_fir_decim_init_lpf(
+    su_fir_decim_t *decim,
+    unsigned int decimation,
+    SUFLOAT fc,
+    SUSCOUNT size)
+{
+  SUFLOAT *h = NULL;
+  SUBOOL ok = SU_FALSE;
+
+  SU_TRYCATCH(decimation > 0, goto done);
+
+  if (fc <= 0)
+    fc = 1. / decimation;
+
+  if (size == 0)
+    size = SU_FIR_DECIM_DEFAULT_TAPS_PER_PHASE * decimation;
+
+  SU_TRYCATCH(h = malloc(size * sizeof (SUFLOAT)), goto done);
+
+  su_taps_brickwall_lp_init(h, fc, size);
+
+  SU_TRYCATCH(su_fir_decim_init(decim, decimation, h, size), goto done);
+
+  ok = SU_TRUE;
+
+done:
+  if (h != NULL)
+    free(h);
+
+  return ok;
+}
+
+void
+su_fir_decim_reset(su_fir_decim_t *decim)
+{
+  memset(decim->x, 0, 2 * decim->size * sizeof (SUCOMPLEX));
+
+  decim->ptr   = 0;
+  decim->x_ptr = 0;
+}
+
+SUBOOL
+su_fir_decim_feed(su_fir_decim_t *decim, SUCOMPLEX x, SUCOMPLEX *y)
+{
+  __su_fir_decim_push(decim, x);
+
+  if (++decim->ptr < decim->decimation)
+    return SU_FALSE;
+
+  decim->ptr = 0;
+  *y = __su_fir_decim_eval(decim);
+
+  return SU_TRUE;
+}
+
+SUSCOUNT
+su_fir_decim_feed_bulk(
+    su_fir_decim_t *decim,
+    const SUCOMPLEX *x,
+    SUSCOUNT len,
+    SUCOMPLEX *y)
+{
+  SUSCOUNT i;
+  SUSCOUNT n = 0;
+
+  /* Outputs are never written ahead of the inputs, so x and y may alias */
+  for (i = 0; i < len; ++i) {
+    __su_fir_decim_push(decim, x[i]);
+
+    if (++decim->ptr == decim->decimation) {
+      decim->ptr = 0;
+      y[n++] = __su_fir_decim_eval(decim);
+    }
+  }
+
+  return n;
+}
+
+/****************************** CIC decimator ********************************/
+void
+su_cic_decim_finalize(su_cic_decim_t *cic)
+{
+  if (cic->integ != NULL)
+    free(cic->integ);
+
+  if (cic->comb != NULL)
+    free(cic->comb);
+
+  cic->integ = NULL;
+  cic->comb = NULL;
+}
+
+SUBOOL
+su_cic_decim_init(
+    su_cic_decim_t *cic,
+    unsigned int stages,
+    unsigned int decimation)
+{
+  SUFLOAT gain = 1;
+  unsigned int growth = 0;
+  unsigned int i;
+
+  SU_TRYCATCH(stages > 0, return SU_FALSE);
+  SU_TRYCATCH(decimation > 0, return SU_FALSE);
+
+  /* Bits needed by decimation, rounded up */
+  while ((1ull << growth) < decimation)
+    ++growth;
+
+  if (stages * growth > SU_CIC_DECIM_MAX_GROWTH) {
+    SU_ERROR(
+        "CIC decimator of %d stages cannot decimate by %d\n",
+        stages,
+        decimation);
+    return SU_FALSE;
+  }
+
+  memset(cic, 0, sizeof (su_cic_decim_t));
+
+  cic->stages = stages;
+  cic->decimation = decimation;
+
+  SU_TRYCATCH(cic->integ = calloc(2 * stages, sizeof (uint64_t)), goto fail);
+  SU_TRYCATCH(cic->comb = calloc(2 * stages, sizeof (uint64_t)), goto fail);
+
+  for (i = 0; i < stages; ++i)
+    gain *= decimation;
+
+  cic->in_scale  = 1 << SU_CIC_DECIM_FRAC_BITS;
+  cic->out_scale = 1. / (gain * cic->in_scale);
+
+  return SU_TRUE;
+
+fail:
+  su_cic_decim_finalize(cic);
+
+  return SU_FALSE;
+}
+
+void
+su_cic_decim_reset(su_cic_decim_t *cic)
+{
+  memset(cic->integ, 0, 2 * cic->stages * sizeof (uint64_t));
+  memset(cic->comb, 0, 2 * cic->stages * sizeof (uint64_t));
+
+  cic->ptr = 0;
+}
+
+SUSCOUNT
+su_cic_decim_feed_bulk(
+    su_cic_decim_t *cic,
+    const SUCOMPLEX *x,
+    SUSCOUNT len,
+    SUCOMPLEX *y)
+{
+  uint64_t *integ = cic->integ;
+  uint64_t *comb = cic->comb;
+  uint64_t re, im, tmp;
+  unsigned int stages = cic->stages;
+  unsigned int ptr = cic->ptr;
+  unsigned int j;
+  SUSCOUNT i;
+  SUSCOUNT n = 0;
+
+  /* Unsigned arithmetic, as the integrators are expected to wrap around */
+  for (i = 0; i < len; ++i) {
+    re = (uint64_t) (int64_t) (SU_C_REAL(x[i]) * cic->in_scale);
+    im = (uint64_t) (int64_t) (SU_C_IMAG(x[i]) * cic->in_scale);
+
+    for (j = 0; j < stages; ++j) {
+      re = integ[2 * j]     += re;
+      im = integ[2 * j + 1] += im;
+    }
+
+    if (++ptr == cic->decimation) {
+      ptr = 0;
+
+      for (j = 0; j < stages; ++j) {
+        tmp = re - comb[2 * j];
+        comb[2 * j] = re;
+        re = tmp;
+
+        tmp = im - comb[2 * j + 1];
+        comb[2 * j + 1] = im;
+        im = tmp;
+      }
+
+      y[n++] = cic->out_scale * ((SUFLOAT) (int64_t) re
+          + I * (SUFLOAT) (int64_t) im);
+    }
+  }
+
+  cic->ptr = ptr;
+
+  return n;
+}
+
+/*************************** Half-band decimator *****************************/
+void
+su_halfband_decim_finalize(su_halfband_decim_t *hb)
+{
+  if (hb->g != NULL)
+    free(hb->g);
+
+  if (hb->even != NULL)
+    free(hb->even);
+
+  if (hb->odd != NULL)
+    free(hb->odd);
+
+  hb->g = NULL;
+  hb->even = NULL;
+  hb->odd = NULL;
+}
+
+SUBOOL
+su_halfband_decim_init(su_halfband_decim_t *hb, unsigned int size)
+{
+  SUFLOAT sum = 0;
+  SUFLOAT t;
+  unsigned int i;
+
+  if (size == 0)
+    size = SU_HALFBAND_DECIM_DEFAULT_SIZE;
+
+  memset(hb, 0, sizeof (su_halfband_decim_t));
+
+  hb->size = size;
+
+  SU_TRYCATCH(hb->g = malloc(size * sizeof (SUFLOAT)), goto fail);
+  SU_TRYCATCH(hb->even = calloc(2 * size, sizeof (SUCOMPLEX)), goto fail);
+  SU_TRYCATCH(hb->odd = calloc(4 * size, sizeof (SUCOMPLEX)), goto fail);
+
+  /* Hamming-windowed sinc with cutoff at half the Nyquist frequency */
+  for (i = 0; i < size; ++i) {
+    t = 2 * i + 1;
+    hb->g[i] = .5 * su_sinc(.5 * t)
+        * (SU_HAMMING_ALPHA + SU_MAMMING_BETA * SU_COS(M_PI * t / (2 * size)));
+    sum += hb->g[i];
+  }
+
+  /* Center tap is 1 / 2: make both sides add up to 1 / 2 */
+  for (i = 0; i < size; ++i)
+    hb->g[i] *= .25 / sum;
+
+  return SU_TRUE;
+
+fail:
+  su_halfband_decim_finalize(hb);
+
+  return SU_FALSE;
+}
+
+void
+su_halfband_decim_reset(su_halfband_decim_t *hb)
+{
+  memset(hb->even, 0, 2 * hb->size * sizeof (SUCOMPLEX));
+  memset(hb->odd, 0, 4 * hb->size * sizeof (SUCOMPLEX));
+
+  hb->phase = 0;
+  hb->e_ptr = 0;
+  hb->o_ptr = 0;
+}
+
+/*
+ * Last 2 * size odd samples are in odd[o_ptr ... o_ptr + 2 * size - 1],
+ * oldest first, and the center sample is the oldest of the last size
+ * even samples.
+ */
+SUINLINE SUCOMPLEX
+__su_halfband_decim_eval(const su_halfband_decim_t *hb)
+{
+  const SUCOMPLEX *odd = hb->odd + hb->o_ptr;
+  const SUCOMPLEX *mid = odd + hb->size;
+  SUCOMPLEX y = 0;
+  unsigned int i;
+
+  for (i = 0; i < hb->size; ++i)
+    y += hb->g[i] * (mid[-1 - (int) i] + mid[i]);
+
+  return y + .5 * hb->even[hb->e_ptr];
+}
+
+SUSCOUNT
+su_halfband_decim_feed_bulk(
+    su_halfband_decim_t *hb,
+    const SUCOMPLEX *x,
+    SUSCOUNT len,
+    SUCOMPLEX *y)
+{
+  unsigned int size = hb->size;
+  SUSCOUNT i;
+  SUSCOUNT n = 0;
+
+  for (i = 0; i < len; ++i) {
+    if (!hb->phase) {
+      hb->even[hb->e_ptr] = x[i];
+      hb->even[hb->e_ptr + size] = x[i];
+      if (++hb->e_ptr == size)
+        hb->e_ptr = 0;
+
+      hb->phase = 1;
+    } else {
+      hb->odd[hb->o_ptr] = x[i];
+      hb->odd[hb->o_ptr + 2 * size] = x[i];
+      if (++hb->o_ptr == 2 * size)
+        hb->o_ptr = 0;
+
+      hb->phase = 0;
+      y[n++] = __su_halfband_decim_eval(hb);
+    }
+  }
+
+  return n;
+}
@@ -0,0 +1,204 @@
+/*
+
+  Copyright (C) 2016 Gonzalo José Carracedo Carballal
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, version 3.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this program.  If not, see
+  <http://www.gnu.org/licenses/>
+
+*/
+
+#ifndef _SIGUTILS_DECIM_H
+#define _SIGUTILS_DECIM_H
+
+#include "types.h"
+
+#ifdef __cplusplus
+#  ifdef __clang__
+#    pragma clang diagnostic push
+#    pragma clang diagnostic ignored "-Wreturn-type-c-linkage"
+#  endif // __clang__
+extern "C" {
+#endif /* __cplusplus */
+
+/* Taps per output sample in su_fir_decim_init_lpf */
+#define SU_FIR_DECIM_DEFAULT_TAPS_PER_PHASE 8
+
+/*
+ * Decimating FIR filter. Only the outputs that are kept are computed, so
+ * filtering and decimating by D costs 1 / D of filtering at the input
+ * rate. The delay line is stored twice in a row, so that the last taps
+ * samples are always contiguous.
+ */
+struct sigutils_fir_decim {
+  unsigned int decimation;
+  unsigned int size;  /* Number of taps */
+  unsigned int ptr;   /* Input samples since last output */
+  unsigned int x_ptr; /* Delay line position */
+
+  SUFLOAT   *h;       /* Taps, in reverse order */
+  SUCOMPLEX *x;       /* Delay line (2 * size) */
+};
+
+typedef struct sigutils_fir_decim su_fir_decim_t;
+
+#define su_fir_decim_INITIALIZER {1, 0, 0, 0, NULL, NULL}
+
+SUBOOL su_fir_decim_init(
+    su_fir_decim_t *decim,
+    unsigned int decimation,
+    const SUFLOAT *h,
+    SUSCOUNT size);
+
+/*
+ * Decimator with a windowed-sinc low pass filter of cutoff frequency fc
+ * (normalized). If fc is 0, the output Nyquist frequency is used. If size
+ * is 0, SU_FIR_DECIM_DEFAULT_TAPS_PER_PHASE taps per phase are used.
+ */
+SUBOOL su_fir_decim_init_lpf(
+    su_fir_decim_t *decim,
+    unsigned int decimation,
+    SUFLOAT fc,
+    SUSCOUNT size);
+
+void su_fir_decim_finalize(su_fir_decim_t *decim);
+
+void su_fir_decim_reset(su_fir_decim_t *decim);
+
+/* Number of input samples that produce exactly `outputs' output samples */
+SUINLINE SUSCOUNT
+su_fir_decim_get_max_input(const su_fir_decim_t *decim, SUSCOUNT outputs)
+{
+  return outputs > 0 ? outputs * decim->decimation - decim->ptr : 0;
+}
+
+/* Push one sample. Returns SU_TRUE and sets *y if an output was produced */
+SUBOOL su_fir_decim_feed(su_fir_decim_t *decim, SUCOMPLEX x, SUCOMPLEX *y);
+
+/*
+ * Push len samples, returns the number of outputs written to y. x and y
+ * may be the same buffer.
+ */
+SUSCOUNT su_fir_decim_feed_bulk(
+    su_fir_decim_t *decim,
+    const SUCOMPLEX *x,
+    SUSCOUNT len,
+    SUCOMPLEX *y);
+
+/*
+ * Cascaded integrator-comb decimator: stages integrators at the input
+ * rate, followed by stages combs at the output rate. No multiplications
+ * are needed, so it is the cheapest way to perform large decimations,
+ * at the cost of a sinc^stages response (usually followed by a half-band
+ * or FIR decimator to flatten the passband).
+ *
+ * Registers are fixed point, with SU_CIC_DECIM_FRAC_BITS fractional bits,
+ * and wrap around: only the output needs to fit in them. Gain grows by
+ * stages * log2(decimation) bits, which cannot exceed
+ * SU_CIC_DECIM_MAX_GROWTH. The output is normalized to unity DC gain.
+ */
+#define SU_CIC_DECIM_FRAC_BITS  20
+#define SU_CIC_DECIM_MAX_GROWTH 40
+
+struct sigutils_cic_decim {
+  unsigned int stages;
+  unsigned int decimation;
+  unsigned int ptr;   /* Input samples since last output */
+
+  uint64_t *integ;    /* Integrators, I and Q (2 * stages) */
+  uint64_t *comb;     /* Comb delays, I and Q (2 * stages) */
+
+  SUFLOAT in_scale;
+  SUFLOAT out_scale;
+};
+
+typedef struct sigutils_cic_decim su_cic_decim_t;
+
+#define su_cic_decim_INITIALIZER {0, 1, 0, NULL, NULL, 0, 0}
+
+SUBOOL su_cic_decim_init(
+    su_cic_decim_t *cic,
+    unsigned int stages,
+    unsigned int decimation);
+
+void su_cic_decim_finalize(su_cic_decim_t *cic);
+
+void su_cic_decim_reset(su_cic_decim_t *cic);
+
+SUINLINE SUSCOUNT
+su_cic_decim_get_max_input(const su_cic_decim_t *cic, SUSCOUNT outputs)
+{
+  return outputs > 0 ? outputs * cic->decimation - cic->ptr : 0;
+}
+
+/* Same semantics as su_fir_decim_feed_bulk */
+SUSCOUNT su_cic_decim_feed_bulk(
+    su_cic_decim_t *cic,
+    const SUCOMPLEX *x,
+    SUSCOUNT len,
+    SUCOMPLEX *y);
+
+/*
+ * Half-band decimator by 2. All even taps of a half-band filter except the
+ * center one are zero, and the filter is symmetric: inputs are split in
+ * an even and an odd delay line, the even one only contributes the center
+ * tap, and each pair of odd samples around the center shares a single
+ * multiplication. This takes size + 1 multiplications per output, for a
+ * filter of 4 * size - 1 taps.
+ */
+#define SU_HALFBAND_DECIM_DEFAULT_SIZE 8
+
+struct sigutils_halfband_decim {
+  unsigned int size;  /* Non-zero taps at each side of the center */
+  unsigned int phase; /* 1 if an even sample is waiting for its pair */
+  unsigned int e_ptr;
+  unsigned int o_ptr;
+
+  SUFLOAT   *g;       /* size taps, from the center outwards */
+  SUCOMPLEX *even;    /* Even delay line (2 * size) */
+  SUCOMPLEX *odd;     /* Odd delay line (4 * size) */
+};
+
+typedef struct sigutils_halfband_decim su_halfband_decim_t;
+
+#define su_halfband_decim_INITIALIZER {0, 0, 0, 0, NULL, NULL, NULL}
+
+/* If size is 0, SU_HALFBAND_DECIM_DEFAULT_SIZE is used */
+SUBOOL su_halfband_decim_init(su_halfband_decim_t *hb, unsigned int size);
+
+void su_halfband_decim_finalize(su_halfband_decim_t *hb);
+
+void su_halfband_decim_reset(su_halfband_decim_t *hb);
+
+SUINLINE SUSCOUNT
+su_halfband_decim_get_max_input(
+    const su_halfband_decim_t *hb,
+    SUSCOUNT outputs)
+{
+  return outputs > 0 ? 2 * outputs - hb->phase : 0;
+}
+
+/* Same semantics as su_fir_decim_feed_bulk */
+SUSCOUNT su_halfband_decim_feed_bulk(
+    su_halfband_decim_t *hb,
+    const SUCOMPLEX *x,
+    SUSCOUNT len,
+    SUCOMPLEX *y);
+
+#ifdef __cplusplus
+#  ifdef __clang__
+#    pragma clang diagnostic pop
+#  endif // __clang__
+}
+#endif /* __cplusplus */
+
+#endif /* _SIGUTILS_DECIM_H */
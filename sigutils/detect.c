@@ -266,10 +266,10 @@ void
 su_channel_detector_destroy(su_channel_detector_t *detector)
 {
   if (detector->fft_plan != NULL)
-    SU_FFTW(_destroy_plan)(detector->fft_plan);
+    su_lib_destroy_plan(detector->fft_plan);
 
   if (detector->fft_plan_rev != NULL)
-    SU_FFTW(_destroy_plan)(detector->fft_plan_rev);
+    su_lib_destroy_plan(detector->fft_plan_rev);
 
   if (detector->window != NULL)
     SU_FFTW(_free)(detector->window);
@@ -462,7 +462,7 @@ su_channel_detector_new(const struct sigutils_channel_detector_params *params)
   }
 
   /* Direct FFT plan */
-  if ((new->fft_plan = SU_FFTW(_plan_dft_1d)(
+  if ((new->fft_plan = su_lib_plan_dft_1d(
       params->window_size,
       new->window,
       new->fft,
@@ -504,7 +504,7 @@ su_channel_detector_new(const struct sigutils_channel_detector_params *params)
 
       memset(new->ifft, 0, params->window_size * sizeof(SU_FFTW(_complex)));
 
-      if ((new->fft_plan_rev = SU_FFTW(_plan_dft_1d)(
+      if ((new->fft_plan_rev = su_lib_plan_dft_1d(
           params->window_size,
           new->fft,
           new->ifft,
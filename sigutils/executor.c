@@ -0,0 +1,562 @@
+/*
+
+  Copyright (C) 2016 Gonzalo José Carracedo Carballal
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, version 3.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this program.  If not, see
+  <http://www.gnu.org/licenses/>
+
+*/
+
+#include <string.h>
+#include <unistd.h>
+
+#define SU_LOG_LEVEL "executor"
+
+#include "log.h"
+#include "executor.h"
+
+#define SU_EXECUTOR_QUEUE_INITIAL_ALLOC 16
+
+/**************************** Worker queues **********************************/
+SUPRIVATE SUBOOL
+su_executor_worker_push(su_executor_worker_t *worker, su_executor_task_t *task)
+{
+  su_executor_task_t **queue;
+  unsigned int alloc;
+  unsigned int i;
+  SUBOOL ok = SU_FALSE;
+
+  pthread_mutex_lock(&worker->lock);
+
+  if (worker->queue_count == worker->queue_alloc) {
+    alloc = worker->queue_alloc == 0
+        ? SU_EXECUTOR_QUEUE_INITIAL_ALLOC
+        : 2 * worker->queue_alloc;
+
+    SU_TRYCATCH(
+        queue = malloc(alloc * sizeof (su_executor_task_t *)),
+        goto done);
+
+    for (i = 0; i < worker->queue_count; ++i)
+      queue[i] =
+          worker->queue[(worker->queue_head + i) % worker->queue_alloc];
+
+    if (worker->queue != NULL)
+      free(worker->queue);
+
+    worker->queue = queue;
+    worker->queue_alloc = alloc;
+    worker->queue_head = 0;
+  }
+
+  worker->queue[
+      (worker->queue_head + worker->queue_count++) % worker->queue_alloc] =
+      task;
+
+  ok = SU_TRUE;
+
+done:
+  pthread_mutex_unlock(&worker->lock);
+
+  return ok;
+}
+
+/* Most recently queued tasks are the most likely to have their data cached */
+SUPRIVATE su_executor_task_t *
+su_executor_worker_pop(su_executor_worker_t *worker)
+{
+  su_executor_task_t *task = NULL;
+
+  pthread_mutex_lock(&worker->lock);
+
+  if (worker->queue_count > 0)
+    task = worker->queue[
+        (worker->queue_head + --worker->queue_count) % worker->queue_alloc];
+
+  pthread_mutex_unlock(&worker->lock);
+
+  return task;
+}
+
+SUPRIVATE su_executor_task_t *
+su_executor_worker_steal(su_executor_worker_t *worker)
+{
+  su_executor_task_t *task = NULL;
+
+  pthread_mutex_lock(&worker->lock);
+
+  if (worker->queue_count > 0) {
+    task = worker->queue[worker->queue_head];
+    worker->queue_head = (worker->queue_head + 1) % worker->queue_alloc;
+    --worker->queue_count;
+  }
+
+  pthread_mutex_unlock(&worker->lock);
+
+  return task;
+}
+
+SUPRIVATE su_executor_task_t *
+su_executor_worker_get_task(su_executor_worker_t *worker)
+{
+  su_executor_t *executor = worker->owner;
+  su_executor_task_t *task;
+  unsigned int i;
+
+  if ((task = su_executor_worker_pop(worker)) != NULL)
+    return task;
+
+  for (i = 1; i < executor->worker_count; ++i)
+    if ((task = su_executor_worker_steal(
+        executor->worker_list
+        + (worker->index + i) % executor->worker_count)) != NULL)
+      return task;
+
+  return NULL;
+}
+
+/******************************** Tasks **************************************/
+SUPRIVATE void
+su_executor_task_destroy(su_executor_task_t *task)
+{
+  free(task);
+}
+
+SUPRIVATE su_executor_task_t *
+su_executor_task_new(
+    su_executor_t *owner,
+    su_block_t *block,
+    unsigned int port_id)
+{
+  su_executor_task_t *new = NULL;
+
+  if ((new = calloc(1, sizeof (su_executor_task_t))) == NULL)
+    return NULL;
+
+  new->owner   = owner;
+  new->block   = block;
+  new->port_id = port_id;
+  new->state   = SU_EXECUTOR_TASK_STATE_IDLE;
+
+  return new;
+}
+
+/*
+ * Tasks must be in QUEUED state before being pushed. Tasks queued before
+ * the executor starts are pushed by su_executor_start.
+ */
+SUPRIVATE void
+su_executor_task_push(su_executor_task_t *task)
+{
+  su_executor_t *executor = task->owner;
+  su_executor_worker_t *worker;
+
+  if (!SU_ATOMIC_LOAD(&executor->running))
+    return;
+
+  /* Tasks scheduled from outside the executor are spread among workers */
+  if ((worker = pthread_getspecific(executor->worker_key)) == NULL)
+    worker = executor->worker_list
+        + SU_ATOMIC_ADD(&executor->next, 1) % executor->worker_count;
+
+  SU_ATOMIC_ADD(&executor->queued, 1);
+
+  if (!su_executor_worker_push(worker, task)) {
+    /* Consumers will run this task by themselves */
+    SU_ERROR("Failed to queue task\n");
+    SU_ATOMIC_ADD(&executor->queued, -1);
+    return;
+  }
+
+  SU_ATOMIC_FENCE();
+
+  if (SU_ATOMIC_LOAD(&executor->sleeping) > 0) {
+    pthread_mutex_lock(&executor->lock);
+    pthread_cond_signal(&executor->cond);
+    pthread_mutex_unlock(&executor->lock);
+  }
+}
+
+/*
+ * Whether acquire() can be called without waiting for other threads: there
+ * must be room in the output and, unless a consumer waiting for this task
+ * is helping it, samples in all inputs.
+ */
+SUPRIVATE SUBOOL
+su_executor_task_is_ready(const su_executor_task_t *task, SUBOOL help)
+{
+  unsigned int i;
+
+  if (su_block_get_room(task->block, task->port_id) == 0)
+    return SU_FALSE;
+
+  if (!help)
+    for (i = 0; i < task->block->classname->in_size; ++i)
+      if (!su_block_port_is_ready(task->block->in + i))
+        return SU_FALSE;
+
+  return SU_TRUE;
+}
+
+/*
+ * Call acquire() once. Tasks remain queued while they are ready, otherwise
+ * they go idle until their consumer releases samples or their producers
+ * write new ones, which notify them. This way workers never sleep waiting
+ * for samples while other tasks are queued.
+ */
+SUPRIVATE void
+su_executor_task_run(su_executor_task_t *task, SUBOOL help)
+{
+  SUSDIFF got;
+
+  if (su_executor_task_is_ready(task, help)) {
+    if ((got = su_block_produce(task->block, task->port_id)) <= 0) {
+      if (got < 0)
+        SU_ERROR(
+            "%s: task for output #%d failed\n",
+            task->block->classname->name,
+            task->port_id);
+
+      SU_ATOMIC_STORE(&task->state, SU_EXECUTOR_TASK_STATE_DONE);
+      return;
+    }
+  }
+
+  if (su_executor_task_is_ready(task, SU_FALSE)) {
+    SU_ATOMIC_STORE(&task->state, SU_EXECUTOR_TASK_STATE_QUEUED);
+    su_executor_task_push(task);
+  } else if (!SU_ATOMIC_CAS(
+      &task->state,
+      SU_EXECUTOR_TASK_STATE_RUNNING,
+      SU_EXECUTOR_TASK_STATE_IDLE)) {
+    /* Consumer or producers notified us while we were running */
+    SU_ATOMIC_STORE(&task->state, SU_EXECUTOR_TASK_STATE_QUEUED);
+    su_executor_task_push(task);
+  }
+}
+
+void
+su_executor_task_notify(su_executor_task_t *task)
+{
+  for (;;) {
+    switch (SU_ATOMIC_LOAD(&task->state)) {
+      case SU_EXECUTOR_TASK_STATE_IDLE:
+        if (SU_ATOMIC_CAS(
+            &task->state,
+            SU_EXECUTOR_TASK_STATE_IDLE,
+            SU_EXECUTOR_TASK_STATE_QUEUED)) {
+          su_executor_task_push(task);
+          return;
+        }
+        break;
+
+      case SU_EXECUTOR_TASK_STATE_RUNNING:
+        if (SU_ATOMIC_CAS(
+            &task->state,
+            SU_EXECUTOR_TASK_STATE_RUNNING,
+            SU_EXECUTOR_TASK_STATE_NOTIFIED))
+          return;
+        break;
+
+      default:
+        return;
+    }
+  }
+}
+
+/*
+ * Run a task in the calling thread, provided that it is not running
+ * somewhere else. Queued tasks are left in their queues, and are skipped
+ * by the workers once popped. The caller is about to wait for this task
+ * anyway, so it may wait for the inputs of the task instead.
+ */
+SUBOOL
+su_executor_task_help(su_executor_task_t *task)
+{
+  if (!SU_ATOMIC_CAS(
+      &task->state,
+      SU_EXECUTOR_TASK_STATE_QUEUED,
+      SU_EXECUTOR_TASK_STATE_RUNNING)
+      && !SU_ATOMIC_CAS(
+          &task->state,
+          SU_EXECUTOR_TASK_STATE_IDLE,
+          SU_EXECUTOR_TASK_STATE_RUNNING))
+    return SU_FALSE;
+
+  su_executor_task_run(task, SU_TRUE);
+
+  return SU_TRUE;
+}
+
+SUBOOL
+su_executor_task_is_running(const su_executor_task_t *task)
+{
+  enum sigutils_executor_task_state state = SU_ATOMIC_LOAD(&task->state);
+
+  return state == SU_EXECUTOR_TASK_STATE_RUNNING
+      || state == SU_EXECUTOR_TASK_STATE_NOTIFIED;
+}
+
+/******************************* Executor ************************************/
+SUPRIVATE void *
+su_executor_worker_thread(void *data)
+{
+  su_executor_worker_t *worker = (su_executor_worker_t *) data;
+  su_executor_t *executor = worker->owner;
+  su_executor_task_t *task;
+
+  pthread_setspecific(executor->worker_key, worker);
+
+  while (SU_ATOMIC_LOAD(&executor->running)) {
+    if ((task = su_executor_worker_get_task(worker)) != NULL) {
+      SU_ATOMIC_ADD(&executor->queued, -1);
+
+      /* Tasks may have been queued twice, or taken by a consumer */
+      if (SU_ATOMIC_CAS(
+          &task->state,
+          SU_EXECUTOR_TASK_STATE_QUEUED,
+          SU_EXECUTOR_TASK_STATE_RUNNING))
+        su_executor_task_run(task, SU_FALSE);
+    } else {
+      pthread_mutex_lock(&executor->lock);
+      SU_ATOMIC_ADD(&executor->sleeping, 1);
+
+      while (SU_ATOMIC_LOAD(&executor->queued) == 0
+          && SU_ATOMIC_LOAD(&executor->running))
+        pthread_cond_wait(&executor->cond, &executor->lock);
+
+      SU_ATOMIC_ADD(&executor->sleeping, -1);
+      pthread_mutex_unlock(&executor->lock);
+    }
+  }
+
+  return NULL;
+}
+
+su_executor_t *
+su_executor_new(unsigned int workers)
+{
+  su_executor_t *new = NULL;
+  long cpus;
+  unsigned int i;
+
+  if (workers == 0) {
+    cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    workers = cpus > 0 ? cpus : 1;
+  }
+
+  SU_TRYCATCH(new = calloc(1, sizeof (su_executor_t)), goto fail);
+
+  SU_TRYCATCH(
+      new->worker_list = calloc(workers, sizeof (su_executor_worker_t)),
+      goto fail);
+
+  SU_TRYCATCH(pthread_mutex_init(&new->lock, NULL) == 0, goto fail);
+  SU_TRYCATCH(pthread_cond_init(&new->cond, NULL) == 0, goto fail);
+
+  for (i = 0; i < workers; ++i) {
+    new->worker_list[i].owner = new;
+    new->worker_list[i].index = i;
+    SU_TRYCATCH(
+        pthread_mutex_init(&new->worker_list[i].lock, NULL) == 0,
+        goto fail);
+  }
+
+  new->worker_count = workers;
+
+  SU_TRYCATCH(pthread_key_create(&new->worker_key, NULL) == 0, goto fail);
+
+  return new;
+
+fail:
+  if (new != NULL) {
+    if (new->worker_list != NULL)
+      free(new->worker_list);
+
+    free(new);
+  }
+
+  return NULL;
+}
+
+SUBOOL
+su_executor_add_block(su_executor_t *executor, su_block_t *block)
+{
+  su_executor_task_t *task = NULL;
+  su_flow_controller_t *fc;
+  unsigned int i;
+  int index;
+
+  for (i = 0; i < block->classname->out_size; ++i) {
+    fc = su_block_get_flow_controller(block, i);
+
+    if (fc->producer != NULL) {
+      SU_ERROR(
+          "%s: output #%d already belongs to an executor\n",
+          block->classname->name,
+          i);
+      return SU_FALSE;
+    }
+
+    if (!su_block_set_async(block, i, SU_TRUE))
+      return SU_FALSE;
+
+    SU_TRYCATCH(task = su_executor_task_new(executor, block, i), goto fail);
+
+    pthread_mutex_lock(&executor->lock);
+    index = PTR_LIST_APPEND_CHECK(executor->task, task);
+    pthread_mutex_unlock(&executor->lock);
+
+    SU_TRYCATCH(index != -1, goto fail);
+
+    SU_ATOMIC_STORE(&fc->producer, task);
+    SU_ATOMIC_STORE(&task->state, SU_EXECUTOR_TASK_STATE_QUEUED);
+    su_executor_task_push(task);
+  }
+
+  return SU_TRUE;
+
+fail:
+  if (task != NULL)
+    su_executor_task_destroy(task);
+
+  return SU_FALSE;
+}
+
+/*
+ * Tasks may be appended (and the list reallocated) while we iterate over
+ * them, but they are only freed by su_executor_destroy. Fetch them one by
+ * one, so that nothing else is done with the executor lock held.
+ */
+SUPRIVATE su_executor_task_t *
+su_executor_get_task(su_executor_t *executor, unsigned int i)
+{
+  su_executor_task_t *task = NULL;
+
+  pthread_mutex_lock(&executor->lock);
+  if (i < executor->task_count)
+    task = executor->task_list[i];
+  pthread_mutex_unlock(&executor->lock);
+
+  return task;
+}
+
+SUBOOL
+su_executor_start(su_executor_t *executor)
+{
+  su_executor_task_t *task;
+  unsigned int i;
+
+  if (executor->running) {
+    SU_ERROR("Executor already running\n");
+    return SU_FALSE;
+  }
+
+  SU_ATOMIC_STORE(&executor->running, SU_TRUE);
+
+  /* Pushing may take the executor lock to wake up sleeping workers */
+  for (i = 0; (task = su_executor_get_task(executor, i)) != NULL; ++i)
+    if (SU_ATOMIC_LOAD(&task->state) == SU_EXECUTOR_TASK_STATE_QUEUED)
+      su_executor_task_push(task);
+
+  for (i = 0; i < executor->worker_count; ++i) {
+    if (pthread_create(
+        &executor->worker_list[i].thread,
+        NULL,
+        su_executor_worker_thread,
+        executor->worker_list + i) != 0) {
+      SU_ERROR("Failed to create worker thread\n");
+      su_executor_stop(executor);
+      return SU_FALSE;
+    }
+
+    executor->worker_list[i].thread_running = SU_TRUE;
+  }
+
+  return SU_TRUE;
+}
+
+void
+su_executor_stop(su_executor_t *executor)
+{
+  su_executor_task_t *task;
+  unsigned int i;
+
+  if (!executor->running)
+    return;
+
+  pthread_mutex_lock(&executor->lock);
+  SU_ATOMIC_STORE(&executor->running, SU_FALSE);
+  pthread_cond_broadcast(&executor->cond);
+  pthread_mutex_unlock(&executor->lock);
+
+  /*
+   * Tasks waiting for samples from their inputs will return immediately.
+   * Forcing EOS notifies consumer tasks with the lock of their input held,
+   * and notifying may take the executor lock: it must not be held here.
+   */
+  for (i = 0; (task = su_executor_get_task(executor, i)) != NULL; ++i)
+    su_block_force_eos(task->block, task->port_id);
+
+  for (i = 0; i < executor->worker_count; ++i)
+    if (executor->worker_list[i].thread_running) {
+      pthread_join(executor->worker_list[i].thread, NULL);
+      executor->worker_list[i].thread_running = SU_FALSE;
+    }
+
+  for (i = 0; i < executor->worker_count; ++i) {
+    executor->worker_list[i].queue_head = 0;
+    executor->worker_list[i].queue_count = 0;
+  }
+
+  executor->queued = 0;
+}
+
+void
+su_executor_destroy(su_executor_t *executor)
+{
+  unsigned int i;
+
+  su_executor_stop(executor);
+
+  for (i = 0; i < executor->task_count; ++i)
+    if (executor->task_list[i] != NULL) {
+      su_block_get_flow_controller(
+          executor->task_list[i]->block,
+          executor->task_list[i]->port_id)->producer = NULL;
+      su_block_set_async(
+          executor->task_list[i]->block,
+          executor->task_list[i]->port_id,
+          SU_FALSE);
+      su_executor_task_destroy(executor->task_list[i]);
+    }
+
+  if (executor->task_list != NULL)
+    free(executor->task_list);
+
+  if (executor->worker_list != NULL) {
+    for (i = 0; i < executor->worker_count; ++i) {
+      pthread_mutex_destroy(&executor->worker_list[i].lock);
+      if (executor->worker_list[i].queue != NULL)
+        free(executor->worker_list[i].queue);
+    }
+
+    free(executor->worker_list);
+  }
+
+  pthread_cond_destroy(&executor->cond);
+  pthread_mutex_destroy(&executor->lock);
+  pthread_key_delete(executor->worker_key);
+
+  free(executor);
+}
@@ -0,0 +1,129 @@
+/*
+
+  Copyright (C) 2016 Gonzalo José Carracedo Carballal
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, version 3.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this program.  If not, see
+  <http://www.gnu.org/licenses/>
+
+*/
+
+#ifndef _SIGUTILS_EXECUTOR_H
+#define _SIGUTILS_EXECUTOR_H
+
+#include <pthread.h>
+#include <util.h>
+#include "types.h"
+#include "block.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * Executors run the acquire() method of block outputs in a fixed pool of
+ * worker threads, no matter how many blocks have been added to them. This
+ * allows running many small block graphs (i.e. one per channel) without
+ * creating a thread per block.
+ *
+ * Every block output is a task. A task is queued as long as there is room
+ * in its output stream and samples in its inputs. It goes idle when its
+ * consumer falls behind or its producers run out of samples, until they
+ * release or write some samples. This way, workers never sleep waiting for
+ * other tasks while there is work queued. Each worker has its own task
+ * queue, and workers with nothing to do steal tasks from the others.
+ *
+ * Block outputs become asynchronous. Consumers waiting for samples of a
+ * task that is not running in any worker run it themselves, so blocks not
+ * added to the executor (or threads reading the final output of a graph)
+ * never wait for a queued task.
+ */
+enum sigutils_executor_task_state {
+  SU_EXECUTOR_TASK_STATE_IDLE,
+  SU_EXECUTOR_TASK_STATE_QUEUED,
+  SU_EXECUTOR_TASK_STATE_RUNNING,
+  SU_EXECUTOR_TASK_STATE_NOTIFIED, /* Running, must be queued again */
+  SU_EXECUTOR_TASK_STATE_DONE
+};
+
+struct sigutils_executor;
+
+struct sigutils_executor_task {
+  struct sigutils_executor *owner;
+  su_block_t *block;
+  unsigned int port_id;
+  enum sigutils_executor_task_state state; /* Atomic */
+};
+
+typedef struct sigutils_executor_task su_executor_task_t;
+
+struct sigutils_executor_worker {
+  struct sigutils_executor *owner;
+  unsigned int index;
+
+  /* Task queue: owner works on the back, thieves steal from the front */
+  pthread_mutex_t lock;
+  su_executor_task_t **queue;
+  unsigned int queue_alloc;
+  unsigned int queue_head;
+  unsigned int queue_count;
+
+  pthread_t thread;
+  SUBOOL thread_running;
+};
+
+typedef struct sigutils_executor_worker su_executor_worker_t;
+
+struct sigutils_executor {
+  PTR_LIST(su_executor_task_t, task);
+  su_executor_worker_t *worker_list;
+  unsigned int worker_count;
+  unsigned int next; /* Queue for tasks scheduled from other threads */
+
+  pthread_key_t worker_key;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  unsigned int queued;   /* Total tasks in queues (atomic) */
+  unsigned int sleeping; /* Workers waiting for tasks (atomic) */
+  SUBOOL running;
+};
+
+typedef struct sigutils_executor su_executor_t;
+
+/* If workers is 0, one worker per online CPU is used */
+su_executor_t *su_executor_new(unsigned int workers);
+
+/*
+ * Run all outputs of this block in the executor. Blocks must be plugged
+ * before being added, and can be added while the executor is running.
+ */
+SUBOOL su_executor_add_block(su_executor_t *executor, su_block_t *block);
+
+SUBOOL su_executor_start(su_executor_t *executor);
+
+/* Force EOS on all outputs and wait for the workers to finish */
+void su_executor_stop(su_executor_t *executor);
+
+void su_executor_destroy(su_executor_t *executor);
+
+/* Called by block ports */
+void su_executor_task_notify(su_executor_task_t *task);
+
+SUBOOL su_executor_task_help(su_executor_task_t *task);
+
+SUBOOL su_executor_task_is_running(const su_executor_task_t *task);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _SIGUTILS_EXECUTOR_H */
@@ -25,76 +25,113 @@
 #include "iir.h"
 #include "coef.h"
 #include "taps.h"
+#include "tapcache.h"
 
 #if defined(_SU_SINGLE_PRECISION) && HAVE_VOLK
 #  define SU_USE_VOLK
 #  include <volk/volk.h>
 #endif
 
+/*
+ * Without VOLK, dot products go through a built-in kernel. On x86, GCC
+ * and clang build one version of it per instruction set and pick the
+ * best one for the running CPU when the library is loaded. NEON is part
+ * of the baseline of 64-bit ARM, where the default version is already
+ * vectorized.
+ */
+#if !defined(SU_USE_VOLK) && defined(__GNUC__) && defined(__GLIBC__)     \
+    && (defined(__x86_64__) || defined(__i386__))
+#  ifdef __has_attribute
+#    if __has_attribute(target_clones)
+#      define SU_IIR_DOT_TARGET_CLONES \
+  __attribute__((target_clones("avx512f", "avx2", "default")))
+#    endif
+#  endif
+#endif
+
+#ifndef SU_IIR_DOT_TARGET_CLONES
+#  define SU_IIR_DOT_TARGET_CLONES
+#endif
+
+/*
+ * Delay lines are stored newest sample first, and every sample is written
+ * twice (size samples apart), so that the last size samples are always
+ * contiguous from x_ptr on.
+ */
 SUINLINE void
 __su_iir_filt_push_x(su_iir_filt_t *filt, SUCOMPLEX x)
 {
-#ifdef SU_USE_VOLK
   if (--filt->x_ptr < 0)
     filt->x_ptr += filt->x_size; /* ptr: size - 1 */
   else
     filt->x[filt->x_ptr + filt->x_size] = x;
 
   filt->x[filt->x_ptr] = x;
-#else
-  filt->x[filt->x_ptr++] = x;
-  if (filt->x_ptr >= filt->x_size)
-    filt->x_ptr = 0;
-#endif /* SU_USE_VOLK */
 }
 
 SUINLINE void
 __su_iir_filt_push_y(su_iir_filt_t *filt, SUCOMPLEX y)
 {
   if (filt->y_size > 0) {
-#ifdef SU_USE_VOLK
     if (--filt->y_ptr < 0)
       filt->y_ptr += filt->y_size; /* ptr: size - 1 */
     else
       filt->y[filt->y_ptr + filt->y_size] = y;
 
     filt->y[filt->y_ptr] = y;
-#else
-    filt->y[filt->y_ptr++] = y;
-    if (filt->y_ptr >= filt->y_size)
-      filt->y_ptr = 0;
-#endif /* SU_USE_VOLK */
   }
 }
 
+/* Input sample pushed age samples ago (0 is the newest) */
 SUINLINE SUCOMPLEX
-__su_iir_filt_eval(const su_iir_filt_t *filt)
+__su_iir_filt_x_age(const su_iir_filt_t *filt, unsigned int age)
 {
-#ifdef SU_USE_VOLK
-  SUCOMPLEX y_tmp = 0;
-#else
+  return filt->x[filt->x_ptr + age];
+}
+
+#ifndef SU_USE_VOLK
+/*
+ * Complex by real dot product. Four independent partial sums let the
+ * compiler keep several samples in flight in SIMD registers without
+ * reassociating a single floating point sum.
+ */
+SUPRIVATE SU_IIR_DOT_TARGET_CLONES SUCOMPLEX
+__su_iir_cdot(const SUCOMPLEX *x, const SUFLOAT *h, unsigned int n)
+{
+  SUCOMPLEX s0 = 0, s1 = 0, s2 = 0, s3 = 0;
   unsigned int i;
-  int p;
+
+  for (i = 0; i + 3 < n; i += 4) {
+    s0 += h[i]     * x[i];
+    s1 += h[i + 1] * x[i + 1];
+    s2 += h[i + 2] * x[i + 2];
+    s3 += h[i + 3] * x[i + 3];
+  }
+
+  for (; i < n; ++i)
+    s0 += h[i] * x[i];
+
+  return (s0 + s1) + (s2 + s3);
+}
 #endif /* SU_USE_VOLK */
 
+SUINLINE SUCOMPLEX
+__su_iir_filt_eval(const su_iir_filt_t *filt)
+{
   SUCOMPLEX y = 0;
+#ifdef SU_USE_VOLK
+  SUCOMPLEX y_tmp = 0;
+#endif /* SU_USE_VOLK */
 
   /* Input feedback */
 #ifdef SU_USE_VOLK
-
   volk_32fc_32f_dot_prod_32fc(&y, filt->x + filt->x_ptr, filt->b, filt->x_size);
-
 #else
-  p = filt->x_ptr - 1;
-  for (i = 0; i < filt->x_size; ++i) {
-    if (p < 0)
-      p += filt->x_size;
-
-    y += filt->b[i] * filt->x[p--];
-  }
+  y = __su_iir_cdot(filt->x + filt->x_ptr, filt->b, filt->x_size);
 #endif /* SU_USE_VOLK */
 
-  if (filt->y_size > 0) {
+  /* Output feedback - assumes that a[0] is 1 */
+  if (filt->y_size > 1) {
 #ifdef SU_USE_VOLK
     volk_32fc_32f_dot_prod_32fc(
         &y_tmp,
@@ -103,30 +140,141 @@ __su_iir_filt_eval(const su_iir_filt_t *filt)
         filt->y_size - 1);
 
     y -= y_tmp;
-
 #else
-    /* Output feedback - assumes that a[0] is 1 */
-    p = filt->y_ptr - 1;
-    for (i = 1; i < filt->y_size; ++i) {
-      if (p < 0)
-        p += filt->y_size;
-
-      y -= filt->a[i] * filt->y[p--];
-    }
+    y -= __su_iir_cdot(filt->y + filt->y_ptr, filt->a + 1, filt->y_size - 1);
 #endif /* SU_USE_VOLK */
   }
 
   return y;
 }
 
+/************************** Overlap-save mode ********************************/
+SUPRIVATE void
+__su_iir_ols_destroy(struct sigutils_iir_ols *ols)
+{
+  if (ols->forward != NULL)
+    su_lib_destroy_plan(ols->forward);
+
+  if (ols->backward != NULL)
+    su_lib_destroy_plan(ols->backward);
+
+  if (ols->h != NULL)
+    SU_FFTW(_free)(ols->h);
+
+  if (ols->buf != NULL)
+    SU_FFTW(_free)(ols->buf);
+
+  free(ols);
+}
+
+SUPRIVATE struct sigutils_iir_ols *
+__su_iir_ols_new(const SUFLOAT *b, unsigned int x_size)
+{
+  struct sigutils_iir_ols *new = NULL;
+  unsigned int i;
+
+  if ((new = calloc(1, sizeof (struct sigutils_iir_ols))) == NULL)
+    goto fail;
+
+  for (new->size = 1;
+       new->size < SU_IIR_FILT_OLS_FFT_RATIO * x_size;
+       new->size <<= 1);
+
+  new->block = new->size - x_size + 1;
+
+  if ((new->h = SU_FFTW(_malloc)(
+      new->size * sizeof(SU_FFTW(_complex)))) == NULL)
+    goto fail;
+
+  if ((new->buf = SU_FFTW(_malloc)(
+      new->size * sizeof(SU_FFTW(_complex)))) == NULL)
+    goto fail;
+
+  if ((new->forward = su_lib_plan_dft_1d(
+      new->size,
+      new->buf,
+      new->buf,
+      FFTW_FORWARD,
+      FFTW_ESTIMATE)) == NULL)
+    goto fail;
+
+  if ((new->backward = su_lib_plan_dft_1d(
+      new->size,
+      new->buf,
+      new->buf,
+      FFTW_BACKWARD,
+      FFTW_ESTIMATE)) == NULL)
+    goto fail;
+
+  /* Frequency response, including IFFT normalization */
+  memset(new->buf, 0, new->size * sizeof(SU_FFTW(_complex)));
+  for (i = 0; i < x_size; ++i)
+    new->buf[i] = b[i] / (SUFLOAT) new->size;
+
+  SU_FFTW(_execute)(new->forward);
+
+  memcpy(new->h, new->buf, new->size * sizeof(SU_FFTW(_complex)));
+
+  return new;
+
+fail:
+  if (new != NULL)
+    __su_iir_ols_destroy(new);
+
+  return NULL;
+}
+
+/* Filter exactly ols->block samples. x and y may be the same buffer */
+SUPRIVATE void
+__su_iir_filt_ols_feed_block(
+    su_iir_filt_t *filt,
+    const SUCOMPLEX *x,
+    SUCOMPLEX *y)
+{
+  struct sigutils_iir_ols *ols = filt->ols;
+  unsigned int hist = filt->x_size - 1;
+  unsigned int i;
+
+  /* Last x_size - 1 samples, oldest first */
+  for (i = 0; i < hist; ++i)
+    ols->buf[i] = __su_iir_filt_x_age(filt, hist - 1 - i);
+
+  memcpy(ols->buf + hist, x, ols->block * sizeof(SUCOMPLEX));
+
+  /* Keep history up to date for the next block or the direct form */
+  for (i = ols->block > hist ? ols->block - hist : 0; i < ols->block; ++i)
+    __su_iir_filt_push_x(filt, x[i]);
+
+  SU_FFTW(_execute)(ols->forward);
+
+  for (i = 0; i < ols->size; ++i)
+    ols->buf[i] *= ols->h[i];
+
+  SU_FFTW(_execute)(ols->backward);
+
+  /* First hist samples are wrapped around by the circular convolution */
+  for (i = 0; i < ols->block; ++i)
+    y[i] = filt->gain * ols->buf[hist + i];
+
+  filt->curr_y = ols->buf[ols->size - 1];
+}
+
 void
 su_iir_filt_finalize(su_iir_filt_t *filt)
 {
-  if (filt->a != NULL)
-    free(filt->a);
+  if (filt->ols != NULL)
+    __su_iir_ols_destroy(filt->ols);
 
-  if (filt->b != NULL)
-    free(filt->b);
+  if (filt->taps != NULL) {
+    su_tapcache_release(filt->taps);
+    filt->taps = NULL;
+  } else {
+    if (filt->a != NULL)
+      free(filt->a);
+
+    if (filt->b != NULL)
+      free(filt->b);
+  }
 
   if (filt->x != NULL)
       free(filt->x);
@@ -157,12 +305,39 @@ su_iir_filt_feed_bulk(
     SUSCOUNT len)
 {
   SUCOMPLEX tmp_y;
+  SUFLOAT gain = filt->gain;
+  SUSCOUNT i;
+
+  if (len == 0)
+    return;
+
+  if (filt->y_size == 0) {
+    /* FIR filter: no output feedback */
+    if (filt->ols != NULL) {
+      while (len >= filt->ols->block) {
+        __su_iir_filt_ols_feed_block(filt, x, y);
+
+        x   += filt->ols->block;
+        y   += filt->ols->block;
+        len -= filt->ols->block;
+      }
 
-  while (len-- != 0) {
-    __su_iir_filt_push_x(filt, *x++);
-    tmp_y = __su_iir_filt_eval(filt);
-    __su_iir_filt_push_y(filt, tmp_y);
-    *y++ = filt->gain * tmp_y;
+      if (len == 0)
+        return;
+    }
+
+    for (i = 0; i < len; ++i) {
+      __su_iir_filt_push_x(filt, x[i]);
+      tmp_y = __su_iir_filt_eval(filt);
+      y[i] = gain * tmp_y;
+    }
+  } else {
+    for (i = 0; i < len; ++i) {
+      __su_iir_filt_push_x(filt, x[i]);
+      tmp_y = __su_iir_filt_eval(filt);
+      __su_iir_filt_push_y(filt, tmp_y);
+      y[i] = gain * tmp_y;
+    }
   }
 
   filt->curr_y = tmp_y;
@@ -177,8 +352,8 @@ su_iir_filt_get(const su_iir_filt_t *filt)
 void
 su_iir_filt_reset(su_iir_filt_t *filt)
 {
-  memset(filt->x, 0, sizeof(SUCOMPLEX) * filt->x_size);
-  memset(filt->y, 0, sizeof(SUCOMPLEX) * filt->y_size);
+  memset(filt->x, 0, sizeof(SUCOMPLEX) * filt->x_alloc);
+  memset(filt->y, 0, sizeof(SUCOMPLEX) * filt->y_alloc);
   filt->curr_y = 0;
 }
 
@@ -201,8 +376,9 @@ __su_iir_filt_init(
   SUCOMPLEX *y = NULL;
   SUFLOAT *a_copy = NULL;
   SUFLOAT *b_copy = NULL;
-  unsigned int x_alloc = x_size;
-  unsigned int y_alloc = y_size;
+  struct sigutils_iir_ols *ols = NULL;
+  unsigned int x_alloc = 2 * x_size - 1;
+  unsigned int y_alloc = y_size > 0 ? 2 * y_size - 1 : 0;
 
   assert(x_size > 0);
 
@@ -210,17 +386,6 @@ __su_iir_filt_init(
 
   filt->gain = 1;
 
-#ifdef SU_USE_VOLK
-  /*
-   * When Volk is enabled, we use contiguous buffers by duplicating
-   * values in the X and Y buffers
-   */
-  x_alloc = 2 * x_alloc - 1;
-
-  if (y_alloc > 0)
-    y_alloc = 2 * y_alloc - 1;
-#endif /* SU_USE_VOLK */
-
   if ((x = calloc(x_alloc, sizeof (SUCOMPLEX))) == NULL)
     goto fail;
 
@@ -245,6 +410,12 @@ __su_iir_filt_init(
     b_copy = b;
   }
 
+  if (y_size == 0 && x_size >= SU_IIR_FILT_OLS_MIN_TAPS)
+    if ((ols = __su_iir_ols_new(b_copy, x_size)) == NULL)
+      goto fail;
+
+  filt->ols = ols;
+
   filt->x = x;
   filt->y = y;
 
@@ -269,6 +440,9 @@ fail:
   if (y != NULL)
     free(y);
 
+  if (ols != NULL)
+    __su_iir_ols_destroy(ols);
+
   if (copy_coef) {
     if (a_copy != NULL)
       free(a_copy);
@@ -297,216 +471,289 @@ su_iir_filt_init(
       SU_TRUE);
 }
 
-SUBOOL
-su_iir_bwlpf_init(su_iir_filt_t *filt, SUSCOUNT n, SUFLOAT fc)
+/*
+ * Initialize a filter whose coefficients come from the tap cache: a goes
+ * first, followed by b. The reference to taps is released on failure.
+ */
+SUPRIVATE SUBOOL
+__su_iir_filt_init_cached(
+    su_iir_filt_t *filt,
+    SUSCOUNT y_size,
+    SUSCOUNT x_size,
+    const SUFLOAT *taps)
 {
-  SUFLOAT *a = NULL;
-  SUFLOAT *b = NULL;
-  SUFLOAT scaling;
-
-  unsigned int i;
+  if (taps == NULL)
+    return SU_FALSE;
 
-  if ((a = su_dcof_bwlp(n, fc)) == NULL)
-    goto fail;
-
-  if ((b = su_ccof_bwlp(n)) == NULL)
-    goto fail;
-
-  scaling = su_sf_bwlp(n, fc);
-
-  for (i = 0; i < n + 1; ++i)
-    b[i] *= scaling;
+  if (!__su_iir_filt_init(
+      filt,
+      y_size,
+      y_size > 0 ? (SUFLOAT *) taps : NULL,
+      x_size,
+      (SUFLOAT *) taps + y_size,
+      SU_FALSE)) {
+    su_tapcache_release(taps);
+    return SU_FALSE;
+  }
 
-  if (!__su_iir_filt_init(filt, n + 1, a, n + 1, b, SU_FALSE))
-    goto fail;
+  filt->taps = taps;
 
   return SU_TRUE;
+}
 
-fail:
-  if (a != NULL)
-    free(a);
-
-  if (b != NULL)
-    free(b);
-
-  return SU_FALSE;
+SUBOOL
+su_iir_bwlpf_init(su_iir_filt_t *filt, SUSCOUNT n, SUFLOAT fc)
+{
+  return __su_iir_filt_init_cached(
+      filt,
+      n + 1,
+      n + 1,
+      su_tapcache_bwlpf(n, fc));
 }
 
 SUBOOL
 su_iir_bwhpf_init(su_iir_filt_t *filt, SUSCOUNT n, SUFLOAT fc)
 {
-  SUFLOAT *a = NULL;
-  SUFLOAT *b = NULL;
-  SUFLOAT scaling;
-
-  unsigned int i;
-
-  if ((a = su_dcof_bwhp(n, fc)) == NULL)
-    goto fail;
-
-  if ((b = su_ccof_bwhp(n)) == NULL)
-    goto fail;
+  return __su_iir_filt_init_cached(
+      filt,
+      n + 1,
+      n + 1,
+      su_tapcache_bwhpf(n, fc));
+}
 
-  scaling = su_sf_bwhp(n, fc);
+SUBOOL
+su_iir_bwbpf_init(su_iir_filt_t *filt, SUSCOUNT n, SUFLOAT f1, SUFLOAT f2)
+{
+  return __su_iir_filt_init_cached(
+      filt,
+      2 * n + 1,
+      2 * n + 1,
+      su_tapcache_bwbpf(n, f1, f2));
+}
 
-  for (i = 0; i < n + 1; ++i)
-    b[i] *= scaling;
+SUBOOL
+su_iir_rrc_init(su_iir_filt_t *filt, SUSCOUNT n, SUFLOAT T, SUFLOAT beta)
+{
+  if (n < 1)
+    return SU_FALSE;
 
-  if (!__su_iir_filt_init(filt, n + 1, a, n + 1, b, SU_FALSE))
-    goto fail;
+  return __su_iir_filt_init_cached(filt, 0, n, su_tapcache_rrc(T, beta, n));
+}
 
-  return SU_TRUE;
+SUBOOL
+su_iir_hilbert_init(su_iir_filt_t *filt, SUSCOUNT n)
+{
+  if (n < 1)
+    return SU_FALSE;
 
-fail:
-  if (a != NULL)
-    free(a);
+  return __su_iir_filt_init_cached(filt, 0, n, su_tapcache_hilbert(n));
+}
 
-  if (b != NULL)
-    free(b);
+SUBOOL
+su_iir_brickwall_bp_init(
+    su_iir_filt_t *filt,
+    SUSCOUNT n,
+    SUFLOAT bw,
+    SUFLOAT ifnor)
+{
+  if (n < 1)
+    return SU_FALSE;
 
-  return SU_FALSE;
+  return __su_iir_filt_init_cached(
+      filt,
+      0,
+      n,
+      su_tapcache_brickwall_bp(bw, ifnor, n));
 }
 
 SUBOOL
-su_iir_bwbpf_init(su_iir_filt_t *filt, SUSCOUNT n, SUFLOAT f1, SUFLOAT f2)
+su_iir_brickwall_lp_init(su_iir_filt_t *filt, SUSCOUNT n, SUFLOAT fc)
 {
-  SUFLOAT *a = NULL;
-  SUFLOAT *b = NULL;
-  SUFLOAT scaling;
+  if (n < 1)
+    return SU_FALSE;
 
-  unsigned int i;
+  return __su_iir_filt_init_cached(
+      filt,
+      0,
+      n,
+      su_tapcache_brickwall_lp(fc, n));
+}
 
-  if ((a = su_dcof_bwbp(n, f1, f2)) == NULL)
-    goto fail;
+/****************************** Real filters *********************************/
+/* Real counterpart of __su_iir_cdot */
+SUPRIVATE SU_IIR_DOT_TARGET_CLONES SUFLOAT
+__su_iir_rdot(const SUFLOAT *a, const SUFLOAT *b, unsigned int n)
+{
+#ifdef SU_USE_VOLK
+  SUFLOAT y;
 
-  if ((b = su_ccof_bwbp(n)) == NULL)
-    goto fail;
+  volk_32f_x2_dot_prod_32f(&y, a, b, n);
 
-  scaling = su_sf_bwbp(n, f1, f2);
+  return y;
+#else
+  SUFLOAT s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+  unsigned int i;
 
-  for (i = 0; i < n + 1; ++i) {
-    b[i] *= scaling;
+  for (i = 0; i + 3 < n; i += 4) {
+    s0 += a[i]     * b[i];
+    s1 += a[i + 1] * b[i + 1];
+    s2 += a[i + 2] * b[i + 2];
+    s3 += a[i + 3] * b[i + 3];
   }
 
-  if (!__su_iir_filt_init(filt, 2 * n + 1, a, 2 * n + 1, b, SU_FALSE))
-    goto fail;
-
-  return SU_TRUE;
-
-fail:
-  if (a != NULL)
-    free(a);
+  for (; i < n; ++i)
+    s0 += a[i] * b[i];
 
-  if (b != NULL)
-    free(b);
-
-  return SU_FALSE;
+  return (s0 + s1) + (s2 + s3);
+#endif /* SU_USE_VOLK */
 }
 
-SUBOOL
-su_iir_rrc_init(su_iir_filt_t *filt, SUSCOUNT n, SUFLOAT T, SUFLOAT beta)
+/* Delay line of size samples, stored twice */
+SUINLINE void
+__su_iir_rfilt_push(
+    SUFLOAT *line,
+    unsigned int *ptr,
+    unsigned int size,
+    SUFLOAT x)
 {
-  SUFLOAT *b = NULL;
-  unsigned int i;
+  line[*ptr] = x;
+  line[*ptr + size] = x;
 
-  if (n < 1)
-    goto fail;
-
-  if ((b = malloc(n * sizeof (SUFLOAT))) == NULL)
-    goto fail;
+  if (++*ptr == size)
+    *ptr = 0;
+}
 
-  su_taps_rrc_init(b, T, beta, n);
+SUINLINE SUFLOAT
+__su_iir_rfilt_step(su_iir_rfilt_t *filt, SUFLOAT x)
+{
+  SUFLOAT y;
 
-  if (!__su_iir_filt_init(filt, 0, NULL, n, b, SU_FALSE))
-    goto fail;
+  __su_iir_rfilt_push(filt->x, &filt->x_ptr, filt->x_size, x);
 
-  return SU_TRUE;
+  y = __su_iir_rdot(filt->b, filt->x + filt->x_ptr, filt->x_size);
 
-fail:
-  if (b != NULL)
-    free(b);
+  /* Output feedback - assumes that a[0] is 1 */
+  if (filt->y_size > 1) {
+    y -= __su_iir_rdot(filt->a, filt->y + filt->y_ptr, filt->y_size - 1);
+    __su_iir_rfilt_push(filt->y, &filt->y_ptr, filt->y_size - 1, y);
+  }
 
-  return SU_FALSE;
+  return y;
 }
 
-SUBOOL
-su_iir_hilbert_init(su_iir_filt_t *filt, SUSCOUNT n)
+void
+su_iir_rfilt_finalize(su_iir_rfilt_t *filt)
 {
-  SUFLOAT *b = NULL;
-  unsigned int i;
-
-  if (n < 1)
-    goto fail;
-
-  if ((b = malloc(n * sizeof (SUFLOAT))) == NULL)
-    goto fail;
-
-  su_taps_hilbert_init(b, n);
+  if (filt->x != NULL)
+    free(filt->x);
 
-  if (!__su_iir_filt_init(filt, 0, NULL, n, b, SU_FALSE))
-    goto fail;
+  if (filt->y != NULL)
+    free(filt->y);
 
-  return SU_TRUE;
+  if (filt->a != NULL)
+    free(filt->a);
 
-fail:
-  if (b != NULL)
-    free(b);
+  if (filt->b != NULL)
+    free(filt->b);
 
-  return SU_FALSE;
+  filt->x = filt->y = filt->a = filt->b = NULL;
 }
 
 SUBOOL
-su_iir_brickwall_bp_init(
-    su_iir_filt_t *filt,
-    SUSCOUNT n,
-    SUFLOAT bw,
-    SUFLOAT ifnor)
+su_iir_rfilt_init(
+    su_iir_rfilt_t *filt,
+    SUSCOUNT y_size,
+    const SUFLOAT *a,
+    SUSCOUNT x_size,
+    const SUFLOAT *b)
 {
-  SUFLOAT *b = NULL;
   unsigned int i;
 
-  if (n < 1)
+  if (x_size == 0)
+    return SU_FALSE;
+
+  memset(filt, 0, sizeof (su_iir_rfilt_t));
+
+  filt->x_size = x_size;
+  filt->y_size = y_size;
+  filt->gain   = 1;
+
+  if ((filt->x = calloc(2 * x_size, sizeof (SUFLOAT))) == NULL)
     goto fail;
 
-  if ((b = malloc(n * sizeof (SUFLOAT))) == NULL)
+  if ((filt->b = malloc(x_size * sizeof (SUFLOAT))) == NULL)
     goto fail;
 
-  su_taps_brickwall_bp_init(b, bw, ifnor, n);
+  for (i = 0; i < x_size; ++i)
+    filt->b[i] = b[x_size - i - 1];
 
-  if (!__su_iir_filt_init(filt, 0, NULL, n, b, SU_FALSE))
-    goto fail;
+  if (y_size > 1) {
+    if ((filt->y = calloc(2 * (y_size - 1), sizeof (SUFLOAT))) == NULL)
+      goto fail;
+
+    if ((filt->a = malloc((y_size - 1) * sizeof (SUFLOAT))) == NULL)
+      goto fail;
+
+    for (i = 0; i < y_size - 1; ++i)
+      filt->a[i] = a[y_size - i - 1];
+  }
 
   return SU_TRUE;
 
 fail:
-  if (b != NULL)
-    free(b);
+  su_iir_rfilt_finalize(filt);
 
   return SU_FALSE;
 }
 
-SUBOOL
-su_iir_brickwall_lp_init(su_iir_filt_t *filt, SUSCOUNT n, SUFLOAT fc)
+SUFLOAT
+su_iir_rfilt_feed(su_iir_rfilt_t *filt, SUFLOAT x)
 {
-  SUFLOAT *b = NULL;
-  unsigned int i;
+  filt->curr_y = __su_iir_rfilt_step(filt, x);
 
-  if (n < 1)
-    goto fail;
+  return filt->gain * filt->curr_y;
+}
 
-  if ((b = malloc(n * sizeof (SUFLOAT))) == NULL)
-    goto fail;
+void
+su_iir_rfilt_feed_bulk(
+    su_iir_rfilt_t *filt,
+    const SUFLOAT *x,
+    SUFLOAT *y,
+    SUSCOUNT len)
+{
+  SUFLOAT tmp_y = filt->curr_y;
+  SUFLOAT gain = filt->gain;
+  SUSCOUNT i;
 
-  su_taps_brickwall_lp_init(b, fc, n);
+  for (i = 0; i < len; ++i) {
+    tmp_y = __su_iir_rfilt_step(filt, x[i]);
+    y[i] = gain * tmp_y;
+  }
 
-  if (!__su_iir_filt_init(filt, 0, NULL, n, b, SU_FALSE))
-    goto fail;
+  filt->curr_y = tmp_y;
+}
 
-  return SU_TRUE;
+SUFLOAT
+su_iir_rfilt_get(const su_iir_rfilt_t *filt)
+{
+  return filt->gain * filt->curr_y;
+}
 
-fail:
-  if (b != NULL)
-    free(b);
+void
+su_iir_rfilt_set_gain(su_iir_rfilt_t *filt, SUFLOAT gain)
+{
+  filt->gain = gain;
+}
 
-  return SU_FALSE;
+void
+su_iir_rfilt_reset(su_iir_rfilt_t *filt)
+{
+  memset(filt->x, 0, 2 * filt->x_size * sizeof (SUFLOAT));
+
+  if (filt->y != NULL)
+    memset(filt->y, 0, 2 * (filt->y_size - 1) * sizeof (SUFLOAT));
+
+  filt->x_ptr  = 0;
+  filt->y_ptr  = 0;
+  filt->curr_y = 0;
 }
@@ -33,6 +33,26 @@
 extern "C" {
 #endif /* __cplusplus */
 
+/*
+ * FIR filters (no output feedback) with at least SU_IIR_FILT_OLS_MIN_TAPS
+ * taps are evaluated by su_iir_filt_feed_bulk using FFT overlap-save. FFT
+ * size is the smallest power of 2 above SU_IIR_FILT_OLS_FFT_RATIO times the
+ * number of taps, and chunks shorter than a block go through the direct
+ * form. Both give the same results up to rounding, but rounding depends
+ * on how samples are split into chunks.
+ */
+#define SU_IIR_FILT_OLS_MIN_TAPS  64
+#define SU_IIR_FILT_OLS_FFT_RATIO 4
+
+struct sigutils_iir_ols {
+  unsigned int size;       /* FFT size */
+  unsigned int block;      /* New samples per FFT */
+  SU_FFTW(_complex) *h;    /* Frequency response, scaled by 1 / size */
+  SU_FFTW(_complex) *buf;  /* History + new samples, transformed in place */
+  SU_FFTW(_plan) forward;
+  SU_FFTW(_plan) backward;
+};
+
 /* TODO: Builtin filters */
 struct sigutils_iir_filt {
   unsigned int x_size;
@@ -53,11 +73,16 @@ struct sigutils_iir_filt {
   SUFLOAT *b;
 
   SUFLOAT gain;
+
+  struct sigutils_iir_ols *ols; /* Overlap-save state, or NULL */
+
+  const void *taps; /* Tap cache entry of a and b, or NULL if owned */
 };
 
 typedef struct sigutils_iir_filt su_iir_filt_t;
 
-#define su_iir_filt_INITIALIZER {0, 0, 0, 0, 0, 0, 0, NULL, NULL, NULL, NULL, 1}
+#define su_iir_filt_INITIALIZER \
+  {0, 0, 0, 0, 0, 0, 0, NULL, NULL, NULL, NULL, 1, NULL, NULL}
 
 /* Push sample to filter */
 SUCOMPLEX su_iir_filt_feed(su_iir_filt_t *filt, SUCOMPLEX x);
@@ -118,6 +143,61 @@ SUBOOL su_iir_brickwall_bp_init(su_iir_filt_t *filt, SUSCOUNT n, SUFLOAT bw, SUF
 /* Destroy filter */
 void su_iir_filt_finalize(su_iir_filt_t *filt);
 
+/*
+ * Real filter: real input, real coefficients, real output. Half the
+ * history and half the arithmetic of su_iir_filt_t for real signals.
+ * Delay lines are stored twice in a row, oldest sample first, so that
+ * the last samples are always contiguous and both feedforward and
+ * feedback terms are plain dot products.
+ */
+struct sigutils_iir_rfilt {
+  unsigned int x_size;
+  unsigned int y_size; /* Feedback coefficients, including a[0] */
+
+  unsigned int x_ptr;
+  unsigned int y_ptr;
+
+  SUFLOAT  curr_y;
+
+  SUFLOAT *x; /* 2 * x_size */
+  SUFLOAT *y; /* 2 * (y_size - 1) */
+
+  SUFLOAT *a; /* a[1...y_size - 1], in reverse order */
+  SUFLOAT *b; /* In reverse order */
+
+  SUFLOAT gain;
+};
+
+typedef struct sigutils_iir_rfilt su_iir_rfilt_t;
+
+#define su_iir_rfilt_INITIALIZER \
+  {0, 0, 0, 0, 0, NULL, NULL, NULL, NULL, 1}
+
+/* Same coefficient layout as su_iir_filt_init. Coefficients are copied */
+SUBOOL su_iir_rfilt_init(
+    su_iir_rfilt_t *filt,
+    SUSCOUNT y_size,
+    const SUFLOAT *a,
+    SUSCOUNT x_size,
+    const SUFLOAT *b);
+
+SUFLOAT su_iir_rfilt_feed(su_iir_rfilt_t *filt, SUFLOAT x);
+
+/* x and y may be the same buffer */
+void su_iir_rfilt_feed_bulk(
+    su_iir_rfilt_t *filt,
+    const SUFLOAT *x,
+    SUFLOAT *y,
+    SUSCOUNT len);
+
+SUFLOAT su_iir_rfilt_get(const su_iir_rfilt_t *filt);
+
+void su_iir_rfilt_set_gain(su_iir_rfilt_t *filt, SUFLOAT gain);
+
+void su_iir_rfilt_reset(su_iir_rfilt_t *filt);
+
+void su_iir_rfilt_finalize(su_iir_rfilt_t *filt);
+
 #ifdef __cplusplus
 #  ifdef __clang__
 #    pragma clang diagnostic pop
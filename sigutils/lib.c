@@ -18,6 +18,7 @@
 */
 
 #include <string.h>
+#include <pthread.h>
 
 #define SU_LOG_LEVEL "lib"
 
@@ -31,6 +32,11 @@ extern struct sigutils_block_class su_block_class_COSTAS;
 extern struct sigutils_block_class su_block_class_RRC;
 extern struct sigutils_block_class su_block_class_CDR;
 extern struct sigutils_block_class su_block_class_SIGGEN;
+extern struct sigutils_block_class su_block_class_FUSED;
+extern struct sigutils_block_class su_block_class_PUSH;
+extern struct sigutils_block_class su_block_class_RESAMPLER;
+extern struct sigutils_block_class su_block_class_CIC;
+extern struct sigutils_block_class su_block_class_HALFBAND;
 
 /* Modem classes */
 extern struct sigutils_modem_class su_modem_class_QPSK;
@@ -94,6 +100,11 @@ su_lib_init_ex(const struct sigutils_log_config *logconfig)
           &su_block_class_RRC,
           &su_block_class_CDR,
           &su_block_class_SIGGEN,
+          &su_block_class_FUSED,
+          &su_block_class_PUSH,
+          &su_block_class_RESAMPLER,
+          &su_block_class_CIC,
+          &su_block_class_HALFBAND,
       };
 
   struct sigutils_modem_class *modems[] =
@@ -140,3 +151,33 @@ su_lib_init(void)
 {
   return su_lib_init_ex(NULL);
 }
+
+/*
+ * FFTW planner lock
+ */
+SUPRIVATE pthread_mutex_t su_lib_fftw_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+SU_FFTW(_plan)
+su_lib_plan_dft_1d(
+    int size,
+    SU_FFTW(_complex) *in,
+    SU_FFTW(_complex) *out,
+    int sign,
+    unsigned int flags)
+{
+  SU_FFTW(_plan) plan;
+
+  (void) pthread_mutex_lock(&su_lib_fftw_mutex);
+  plan = SU_FFTW(_plan_dft_1d)(size, in, out, sign, flags);
+  (void) pthread_mutex_unlock(&su_lib_fftw_mutex);
+
+  return plan;
+}
+
+void
+su_lib_destroy_plan(SU_FFTW(_plan) plan)
+{
+  (void) pthread_mutex_lock(&su_lib_fftw_mutex);
+  SU_FFTW(_destroy_plan)(plan);
+  (void) pthread_mutex_unlock(&su_lib_fftw_mutex);
+}
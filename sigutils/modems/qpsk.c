@@ -57,6 +57,7 @@ struct qpsk_modem {
   su_block_t *costas_block;
   su_block_t *agc_block;
   su_block_t *rrc_block;
+  su_block_t *fused_block;
 
   su_block_port_t port;
 };
@@ -128,6 +129,7 @@ su_qpsk_modem_ctor(su_modem_t *modem, void **private)
   SUFLOAT *cdr_alpha = NULL;
   SUFLOAT *cdr_beta = NULL;
   SUFLOAT *costas_beta = NULL;
+  su_block_t *chain[4];
 
   if ((new = calloc(1, sizeof(struct qpsk_modem))) == NULL)
     goto fail;
@@ -258,7 +260,17 @@ su_qpsk_modem_ctor(su_modem_t *modem, void **private)
   if (!su_block_plug(new->rrc_block, 0, 0, new->cdr_block))
     goto fail;
 
-  if (!su_block_port_plug(&new->port, new->cdr_block, 0))
+  /* The whole chain is linear: run it as a single block */
+  chain[0] = new->agc_block;
+  chain[1] = new->costas_block;
+  chain[2] = new->rrc_block;
+  chain[3] = new->cdr_block;
+
+  SU_QPSK_MODEM_CREATE_BLOCK(
+      new->fused_block,
+      su_block_chain_fuse(chain, 4));
+
+  if (!su_block_port_plug(&new->port, new->fused_block, 0))
     goto fail;
 
   *private = new;
@@ -19,6 +19,7 @@
 
 #define _GNU_SOURCE
 #include <math.h>
+#include <pthread.h>
 
 #define SU_LOG_DOMAIN "ncqo"
 
@@ -36,6 +37,11 @@ su_ncqo_init(su_ncqo_t *ncqo, SUFLOAT fnor)
   ncqo->sin   = 0;
   ncqo->cos   = 1;
 
+  ncqo->phasor     = SU_FALSE;
+  ncqo->renorm_ptr = 0;
+
+  ncqo->fixed_point = SU_FALSE;
+
 #ifdef SU_NCQO_USE_PRECALC_BUFFER
   ncqo->p     = 0;
   ncqo->pre_c = SU_FALSE;
@@ -53,6 +59,82 @@ su_ncqo_init_fixed(su_ncqo_t *ncqo, SUFLOAT fnor)
 #endif /* SU_NCQO_USE_PRECALC_BUFFER */
 }
 
+void
+__su_ncqo_renorm_phasor(su_ncqo_t *ncqo)
+{
+  SU_SINCOS(ncqo->phi, &ncqo->sin, &ncqo->cos);
+  SU_SINCOS(ncqo->omega, &ncqo->rot_sin, &ncqo->rot_cos);
+
+  ncqo->cos_updated = SU_TRUE;
+  ncqo->sin_updated = SU_TRUE;
+  ncqo->renorm_ptr  = 0;
+}
+
+/* Leave fixed and fixed-point modes, keeping the current phase */
+SUPRIVATE void
+__su_ncqo_make_regular(su_ncqo_t *ncqo)
+{
+#ifdef SU_NCQO_USE_PRECALC_BUFFER
+  if (ncqo->pre_c) {
+    ncqo->phi   = ncqo->phi_buffer[ncqo->p];
+    ncqo->pre_c = SU_FALSE;
+  }
+#endif /* SU_NCQO_USE_PRECALC_BUFFER */
+
+  if (ncqo->fixed_point) {
+    ncqo->phi = su_ncqo_get_phase(ncqo);
+    ncqo->fixed_point = SU_FALSE;
+  }
+}
+
+SUPRIVATE void
+__su_ncqo_update_freq_word(su_ncqo_t *ncqo)
+{
+  ncqo->freq_word = __su_ncqo_freq_to_word(ncqo->fnor);
+
+  /* Keep floating point frequency consistent with the frequency word */
+  ncqo->fnor  = __su_ncqo_word_to_freq(ncqo->freq_word);
+  ncqo->omega = SU_NORM2ANG_FREQ(ncqo->fnor);
+}
+
+void
+su_ncqo_set_fixed_point(su_ncqo_t *ncqo, SUBOOL fixed_point)
+{
+  __su_ncqo_make_regular(ncqo);
+
+  ncqo->phasor = SU_FALSE;
+
+  if (fixed_point) {
+    su_ncqo_lut_init();
+
+    ncqo->fixed_point = SU_TRUE;
+    ncqo->phase_word  = __su_ncqo_freq_to_word(ncqo->phi / PI);
+    __su_ncqo_update_freq_word(ncqo);
+    __su_ncqo_lut_sincos(ncqo->phase_word, &ncqo->sin, &ncqo->cos);
+
+    ncqo->cos_updated = SU_TRUE;
+    ncqo->sin_updated = SU_TRUE;
+  } else {
+    ncqo->cos_updated = SU_FALSE;
+    ncqo->sin_updated = SU_FALSE;
+  }
+}
+
+void
+su_ncqo_set_phasor(su_ncqo_t *ncqo, SUBOOL phasor)
+{
+  __su_ncqo_make_regular(ncqo);
+
+  ncqo->phasor = phasor;
+
+  if (phasor) {
+    __su_ncqo_renorm_phasor(ncqo);
+  } else {
+    ncqo->cos_updated = SU_FALSE;
+    ncqo->sin_updated = SU_FALSE;
+  }
+}
+
 SUINLINE void
 __su_ncqo_assert_cos(su_ncqo_t *ncqo)
 {
@@ -82,6 +164,14 @@ su_ncqo_set_phase(su_ncqo_t *ncqo, SUFLOAT phi)
 #endif /* SU_NCQO_USE_PRECALC_BUFFER */
 
   ncqo->phi = phi - 2 * PI * SU_FLOOR(phi / (2 * PI));
+
+  if (ncqo->fixed_point) {
+    ncqo->phase_word = __su_ncqo_freq_to_word(ncqo->phi / PI);
+    __su_ncqo_lut_sincos(ncqo->phase_word, &ncqo->sin, &ncqo->cos);
+  }
+
+  if (ncqo->phasor)
+    __su_ncqo_renorm_phasor(ncqo);
 }
 
 SUFLOAT
@@ -144,6 +234,16 @@ su_ncqo_read_i(su_ncqo_t *ncqo)
 #endif /* SU_NCQO_USE_PRECALC_BUFFER */
     old = ncqo->cos;
 
+    if (ncqo->fixed_point) {
+      __su_ncqo_step_fixed_point(ncqo);
+      return old;
+    }
+
+    if (ncqo->phasor) {
+      __su_ncqo_step_phasor(ncqo);
+      return old;
+    }
+
     __su_ncqo_step(ncqo);
 
     ncqo->cos_updated = SU_TRUE;
@@ -169,6 +269,16 @@ su_ncqo_read_q(su_ncqo_t *ncqo)
 #endif /* SU_NCQO_USE_PRECALC_BUFFER */
     old = ncqo->sin;
 
+    if (ncqo->fixed_point) {
+      __su_ncqo_step_fixed_point(ncqo);
+      return old;
+    }
+
+    if (ncqo->phasor) {
+      __su_ncqo_step_phasor(ncqo);
+      return old;
+    }
+
     __su_ncqo_step(ncqo);
 
     ncqo->cos_updated = SU_FALSE;
@@ -194,6 +304,16 @@ su_ncqo_read(su_ncqo_t *ncqo)
 #endif /* SU_NCQO_USE_PRECALC_BUFFER */
     old = ncqo->cos + I * ncqo->sin;
 
+    if (ncqo->fixed_point) {
+      __su_ncqo_step_fixed_point(ncqo);
+      return old;
+    }
+
+    if (ncqo->phasor) {
+      __su_ncqo_step_phasor(ncqo);
+      return old;
+    }
+
     __su_ncqo_step(ncqo);
 
     ncqo->cos_updated = SU_TRUE;
@@ -208,6 +328,128 @@ su_ncqo_read(su_ncqo_t *ncqo)
   return old;
 }
 
+/*
+ * Compute the next len (<= SU_NCQO_BULK_STRIDE) in-phase and quadrature
+ * samples. In regular mode, phases are computed first so that the sin / cos
+ * loops can be vectorized.
+ */
+SUPRIVATE void
+__su_ncqo_read_stride(su_ncqo_t *ncqo, SUFLOAT *c, SUFLOAT *s, SUSCOUNT len)
+{
+  SUSCOUNT i;
+  SUFLOAT phi;
+
+#ifdef SU_NCQO_USE_PRECALC_BUFFER
+  if (ncqo->pre_c) {
+    for (i = 0; i < len; ++i) {
+      c[i] = ncqo->cos_buffer[ncqo->p];
+      s[i] = ncqo->sin_buffer[ncqo->p];
+      __su_ncqo_step_precalc(ncqo);
+    }
+
+    return;
+  }
+#endif /* SU_NCQO_USE_PRECALC_BUFFER */
+
+  if (ncqo->fixed_point) {
+    for (i = 0; i < len; ++i) {
+      __su_ncqo_lut_sincos(ncqo->phase_word, s + i, c + i);
+      ncqo->phase_word += ncqo->freq_word;
+    }
+
+    __su_ncqo_lut_sincos(ncqo->phase_word, &ncqo->sin, &ncqo->cos);
+
+    return;
+  }
+
+  if (ncqo->phasor) {
+    for (i = 0; i < len; ++i) {
+      c[i] = ncqo->cos;
+      s[i] = ncqo->sin;
+      __su_ncqo_step_phasor(ncqo);
+    }
+
+    return;
+  }
+
+  phi = ncqo->phi;
+
+  __su_ncqo_assert_cos(ncqo);
+  __su_ncqo_assert_sin(ncqo);
+
+  c[0] = ncqo->cos;
+  s[0] = ncqo->sin;
+
+  for (i = 1; i < len; ++i)
+    c[i] = phi + i * ncqo->omega;
+
+  for (i = 1; i < len; ++i)
+    s[i] = SU_SIN(c[i]);
+
+  for (i = 1; i < len; ++i)
+    c[i] = SU_COS(c[i]);
+
+  phi += len * ncqo->omega;
+  ncqo->phi = phi - 2 * PI * SU_FLOOR(phi / (2 * PI));
+
+  ncqo->cos_updated = SU_TRUE;
+  ncqo->sin_updated = SU_TRUE;
+  ncqo->cos = SU_COS(ncqo->phi);
+  ncqo->sin = SU_SIN(ncqo->phi);
+}
+
+void
+su_ncqo_read_bulk(su_ncqo_t *ncqo, SUCOMPLEX *out, SUSCOUNT len)
+{
+  SUFLOAT c[SU_NCQO_BULK_STRIDE];
+  SUFLOAT s[SU_NCQO_BULK_STRIDE];
+  SUSCOUNT chunk;
+  SUSCOUNT i;
+
+  while (len > 0) {
+    chunk = SU_MIN(len, SU_NCQO_BULK_STRIDE);
+
+    __su_ncqo_read_stride(ncqo, c, s, chunk);
+
+    for (i = 0; i < chunk; ++i)
+      out[i] = c[i] + I * s[i];
+
+    out += chunk;
+    len -= chunk;
+  }
+}
+
+void
+su_ncqo_mix_bulk(
+    su_ncqo_t *ncqo,
+    const SUCOMPLEX *in,
+    SUCOMPLEX *out,
+    SUSCOUNT len)
+{
+  SUFLOAT c[SU_NCQO_BULK_STRIDE];
+  SUFLOAT s[SU_NCQO_BULK_STRIDE];
+  SUFLOAT re, im;
+  SUSCOUNT chunk;
+  SUSCOUNT i;
+
+  while (len > 0) {
+    chunk = SU_MIN(len, SU_NCQO_BULK_STRIDE);
+
+    __su_ncqo_read_stride(ncqo, c, s, chunk);
+
+    /* Explicit product, to avoid the NaN checks of complex multiplication */
+    for (i = 0; i < chunk; ++i) {
+      re = SU_C_REAL(in[i]) * c[i] - SU_C_IMAG(in[i]) * s[i];
+      im = SU_C_REAL(in[i]) * s[i] + SU_C_IMAG(in[i]) * c[i];
+      out[i] = re + I * im;
+    }
+
+    in  += chunk;
+    out += chunk;
+    len -= chunk;
+  }
+}
+
 void
 su_ncqo_set_angfreq(su_ncqo_t *ncqo, SUFLOAT omrel)
 {
@@ -220,6 +462,12 @@ su_ncqo_set_angfreq(su_ncqo_t *ncqo, SUFLOAT omrel)
 
   ncqo->omega = omrel;
   ncqo->fnor  = SU_ANG2NORM_FREQ(omrel);
+
+  if (ncqo->fixed_point)
+    __su_ncqo_update_freq_word(ncqo);
+
+  if (ncqo->phasor)
+    SU_SINCOS(ncqo->omega, &ncqo->rot_sin, &ncqo->rot_cos);
 }
 
 void
@@ -232,8 +480,23 @@ su_ncqo_inc_angfreq(su_ncqo_t *ncqo, SUFLOAT delta)
   }
 #endif /* SU_NCQO_USE_PRECALC_BUFFER */
 
+  if (ncqo->fixed_point) {
+    /* Frequency words are accumulated exactly */
+    ncqo->freq_word += __su_ncqo_freq_to_word(SU_ANG2NORM_FREQ(delta));
+    ncqo->fnor  = __su_ncqo_word_to_freq(ncqo->freq_word);
+    ncqo->omega = SU_NORM2ANG_FREQ(ncqo->fnor);
+    return;
+  }
+
   ncqo->omega += delta;
   ncqo->fnor   = SU_ANG2NORM_FREQ(ncqo->omega);
+
+  if (ncqo->phasor) {
+    if (SU_ABS(delta) < SU_NCQO_PHASOR_SMALL_ANGLE)
+      __su_ncqo_rotate(&ncqo->rot_cos, &ncqo->rot_sin, delta);
+    else
+      SU_SINCOS(ncqo->omega, &ncqo->rot_sin, &ncqo->rot_cos);
+  }
 }
 
 SUFLOAT
@@ -254,6 +517,12 @@ su_ncqo_set_freq(su_ncqo_t *ncqo, SUFLOAT fnor)
 
   ncqo->fnor  = fnor;
   ncqo->omega = SU_NORM2ANG_FREQ(fnor);
+
+  if (ncqo->fixed_point)
+    __su_ncqo_update_freq_word(ncqo);
+
+  if (ncqo->phasor)
+    SU_SINCOS(ncqo->omega, &ncqo->rot_sin, &ncqo->rot_cos);
 }
 
 void
@@ -266,8 +535,18 @@ su_ncqo_inc_freq(su_ncqo_t *ncqo, SUFLOAT delta)
   }
 #endif /* SU_NCQO_USE_PRECALC_BUFFER */
 
+  if (ncqo->fixed_point) {
+    ncqo->freq_word += __su_ncqo_freq_to_word(delta);
+    ncqo->fnor  = __su_ncqo_word_to_freq(ncqo->freq_word);
+    ncqo->omega = SU_NORM2ANG_FREQ(ncqo->fnor);
+    return;
+  }
+
   ncqo->fnor  += delta;
   ncqo->omega  = SU_NORM2ANG_FREQ(ncqo->fnor);
+
+  if (ncqo->phasor)
+    SU_SINCOS(ncqo->omega, &ncqo->rot_sin, &ncqo->rot_cos);
 }
 
 SUFLOAT
@@ -276,3 +555,55 @@ su_ncqo_get_freq(const su_ncqo_t *ncqo)
   return ncqo->fnor;
 }
 
+
+/**************************** Compact NCQO ***********************************/
+SUFLOAT su_ncqo_lut[SU_NCQO_LUT_SIZE + SU_NCQO_LUT_SIZE / 4 + 1];
+
+SUPRIVATE pthread_once_t su_ncqo_lut_once = PTHREAD_ONCE_INIT;
+
+SUPRIVATE void
+su_ncqo_lut_populate(void)
+{
+  unsigned int i;
+
+  for (i = 0; i < sizeof (su_ncqo_lut) / sizeof (su_ncqo_lut[0]); ++i)
+    su_ncqo_lut[i] = sin(2 * M_PI * i / SU_NCQO_LUT_SIZE);
+}
+
+void
+su_ncqo_lut_init(void)
+{
+  (void) pthread_once(&su_ncqo_lut_once, su_ncqo_lut_populate);
+}
+
+void
+su_lut_ncqo_init(su_lut_ncqo_t *ncqo, SUFLOAT fnor)
+{
+  su_ncqo_lut_init();
+
+  ncqo->phase = 0;
+  su_lut_ncqo_set_freq(ncqo, fnor);
+}
+
+void
+su_lut_ncqo_mix_bulk(
+    su_lut_ncqo_t *ncqo,
+    const SUCOMPLEX *in,
+    SUCOMPLEX *out,
+    SUSCOUNT len)
+{
+  SUSCOUNT i;
+  SUFLOAT s, c, re, im;
+  uint32_t phase = ncqo->phase;
+
+  for (i = 0; i < len; ++i) {
+    __su_ncqo_lut_sincos(phase, &s, &c);
+    phase += ncqo->dphase;
+
+    re = SU_C_REAL(in[i]) * c - SU_C_IMAG(in[i]) * s;
+    im = SU_C_REAL(in[i]) * s + SU_C_IMAG(in[i]) * c;
+    out[i] = re + I * im;
+  }
+
+  ncqo->phase = phase;
+}
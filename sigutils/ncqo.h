@@ -37,6 +37,19 @@ extern "C" {
 #  define SU_NCQO_PRECALC_BUFFER_LEN 1024
 #endif /* SU_NCQO_USE_PRECALC_BUFFER */
 
+/*
+ * Phasor mode: instead of computing sin and cos on every step, the output
+ * is rotated by multiplying it by cos(omega) + I sin(omega). Every
+ * SU_NCQO_PHASOR_RENORM_INTERVAL steps it is computed again from the phase
+ * accumulator, which keeps rounding errors from building up both in its
+ * magnitude and in its phase. Small phase and frequency increments (as
+ * those of tracking loops) are applied by rotation too.
+ */
+#define SU_NCQO_PHASOR_RENORM_INTERVAL 256
+#define SU_NCQO_PHASOR_SMALL_ANGLE     5e-2
+
+#define SU_NCQO_BULK_STRIDE 64
+
 /* The numerically-controlled quadruature oscillator definition */
 struct sigutils_ncqo {
 #ifdef SU_NCQO_USE_PRECALC_BUFFER
@@ -56,6 +69,17 @@ struct sigutils_ncqo {
 
   SUBOOL  cos_updated;
   SUFLOAT cos;
+
+  /* Phasor mode, see su_ncqo_set_phasor */
+  SUBOOL  phasor;
+  SUFLOAT rot_cos; /* cos(omega) */
+  SUFLOAT rot_sin; /* sin(omega) */
+  unsigned int renorm_ptr; /* Steps since last renormalization */
+
+  /* Fixed-point mode, see su_ncqo_set_fixed_point */
+  SUBOOL   fixed_point;
+  uint32_t phase_word; /* 2^32 is 2 pi */
+  uint32_t freq_word;  /* Phase increment */
 };
 
 typedef struct sigutils_ncqo su_ncqo_t;
@@ -154,12 +178,112 @@ __su_ncqo_step_precalc(su_ncqo_t *ncqo)
 #endif /* SU_NCQO_USE_PRECALC_BUFFER */
 /* ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^ VOLK HACKS ABOVE ^^^^^^^^^^^^^^^^^^^^^^^^^^^*/
 
+/*
+ * Shared sine table, used by fixed-point NCQOs (see su_ncqo_set_fixed_point
+ * and su_lut_ncqo_t).
+ */
+#define SU_NCQO_LUT_BITS      10
+#define SU_NCQO_LUT_SIZE      (1 << SU_NCQO_LUT_BITS)
+#define SU_NCQO_LUT_FRAC_BITS (32 - SU_NCQO_LUT_BITS)
+#define SU_NCQO_LUT_FRAC_MASK ((1u << SU_NCQO_LUT_FRAC_BITS) - 1)
+
+/* One full period, plus a quarter for cosine and a guard for interpolation */
+extern SUFLOAT su_ncqo_lut[SU_NCQO_LUT_SIZE + SU_NCQO_LUT_SIZE / 4 + 1];
+
+/* Populate su_ncqo_lut. Called by constructors, safe to call many times */
+void su_ncqo_lut_init(void);
+
+SUINLINE void
+__su_ncqo_lut_sincos(uint32_t phase, SUFLOAT *s, SUFLOAT *c)
+{
+  uint32_t idx  = phase >> SU_NCQO_LUT_FRAC_BITS;
+  SUFLOAT  frac =
+      (SUFLOAT) (phase & SU_NCQO_LUT_FRAC_MASK)
+      * (1.f / (SUFLOAT) (1u << SU_NCQO_LUT_FRAC_BITS));
+  const SUFLOAT *sp = su_ncqo_lut + idx;
+  const SUFLOAT *cp = sp + SU_NCQO_LUT_SIZE / 4;
+
+  *s = sp[0] + frac * (sp[1] - sp[0]);
+  *c = cp[0] + frac * (cp[1] - cp[0]);
+}
+
+/* Normalized frequency to phase increment, wrapping around fs */
+SUINLINE uint32_t
+__su_ncqo_freq_to_word(SUFLOAT fnor)
+{
+  /* fnor = 1 is half a turn (2^31) */
+  return (uint32_t) (int64_t) SU_FLOOR(fnor * 2147483648. + .5);
+}
+
+SUINLINE SUFLOAT
+__su_ncqo_word_to_freq(uint32_t word)
+{
+  return (SUFLOAT) ((int32_t) word / 2147483648.);
+}
+
+/* Recompute phasor and rotation from phi and omega */
+void __su_ncqo_renorm_phasor(su_ncqo_t *ncqo);
+
+/* Rotate (*c, *s) by a small angle, using the Taylor series of sin / cos */
+SUINLINE void
+__su_ncqo_rotate(SUFLOAT *c, SUFLOAT *s, SUFLOAT delta)
+{
+  SUFLOAT d2 = delta * delta;
+  SUFLOAT rc = 1 - .5f * d2;
+  SUFLOAT rs = delta * (1 - d2 / 6);
+  SUFLOAT tmp;
+
+  tmp = *c * rc - *s * rs;
+  *s  = *s * rc + *c * rs;
+  *c  = tmp;
+}
+
+SUINLINE void
+__su_ncqo_step_fixed_point(su_ncqo_t *ncqo)
+{
+  ncqo->phase_word += ncqo->freq_word;
+  __su_ncqo_lut_sincos(ncqo->phase_word, &ncqo->sin, &ncqo->cos);
+}
+
+SUINLINE void
+__su_ncqo_step_phasor(su_ncqo_t *ncqo)
+{
+  SUFLOAT c = ncqo->cos;
+  SUFLOAT s = ncqo->sin;
+
+  /* Phase is still needed by su_ncqo_get_phase and renormalization */
+  __su_ncqo_step(ncqo);
+
+  if (++ncqo->renorm_ptr == SU_NCQO_PHASOR_RENORM_INTERVAL) {
+    __su_ncqo_renorm_phasor(ncqo);
+  } else {
+    ncqo->cos = c * ncqo->rot_cos - s * ncqo->rot_sin;
+    ncqo->sin = s * ncqo->rot_cos + c * ncqo->rot_sin;
+  }
+}
+
 /* NCQO constructor */
 void su_ncqo_init(su_ncqo_t *ncqo, SUFLOAT frel);
 
 /* NCQO constructor for fixed frequency */
 void su_ncqo_init_fixed(su_ncqo_t *ncqo, SUFLOAT fnor);
 
+/*
+ * Switch to (or from) phasor mode. Fixed NCQOs become regular NCQOs in
+ * phasor mode, as precalculated buffers are no longer needed.
+ */
+void su_ncqo_set_phasor(su_ncqo_t *ncqo, SUBOOL phasor);
+
+/*
+ * Switch to (or from) fixed-point mode. Phase and frequency are kept as
+ * 32-bit words that wrap around naturally, so the phase does not drift
+ * no matter how long the NCQO runs, and the output is read from the shared
+ * sine table with linear interpolation. Frequency resolution is 2^-31
+ * (normalized). Fixed NCQOs become regular NCQOs in this mode, and phasor
+ * mode is disabled.
+ */
+void su_ncqo_set_fixed_point(su_ncqo_t *ncqo, SUBOOL fixed_point);
+
 /* Compute next step */
 SUINLINE void
 su_ncqo_step(su_ncqo_t *ncqo)
@@ -167,16 +291,19 @@ su_ncqo_step(su_ncqo_t *ncqo)
 #ifdef SU_NCQO_USE_PRECALC_BUFFER
   if (ncqo->pre_c) {
     __su_ncqo_step_precalc(ncqo);
-  } else {
+  } else
 #endif /* SU_NCQO_USE_PRECALC_BUFFER */
+  if (ncqo->fixed_point) {
+    __su_ncqo_step_fixed_point(ncqo);
+  } else if (ncqo->phasor) {
+    __su_ncqo_step_phasor(ncqo);
+  } else {
     __su_ncqo_step(ncqo);
 
     /* Sine & cosine values are now outdated */
     ncqo->cos_updated = SU_FALSE;
     ncqo->sin_updated = SU_FALSE;
-#ifdef SU_NCQO_USE_PRECALC_BUFFER
   }
-#endif /* SU_NCQO_USE_PRECALC_BUFFER */
 }
 
 
@@ -192,6 +319,9 @@ su_ncqo_get_phase(su_ncqo_t *ncqo)
     return ncqo->phi_buffer[ncqo->p];
 #endif /* SU_NCQO_USE_PRECALC_BUFFER */
 
+  if (ncqo->fixed_point)
+    return (SUFLOAT) (ncqo->phase_word * (2 * PI / 4294967296.));
+
   return ncqo->phi;
 }
 
@@ -208,12 +338,26 @@ su_ncqo_inc_phase(su_ncqo_t *ncqo, SUFLOAT delta)
   }
 #endif /* SU_NCQO_USE_PRECALC_BUFFER */
 
+  if (ncqo->fixed_point) {
+    ncqo->phase_word += __su_ncqo_freq_to_word(delta / PI);
+    __su_ncqo_lut_sincos(ncqo->phase_word, &ncqo->sin, &ncqo->cos);
+    return;
+  }
+
   ncqo->phi += delta;
 
   if (ncqo->phi < 0 || ncqo->phi >= 2 * PI) {
     ncqo->phi -= 2 * PI * SU_FLOOR(ncqo->phi / (2 * PI));
   }
+
+  if (ncqo->phasor) {
+    if (SU_ABS(delta) < SU_NCQO_PHASOR_SMALL_ANGLE)
+      __su_ncqo_rotate(&ncqo->cos, &ncqo->sin, delta);
+    else
+      __su_ncqo_renorm_phasor(ncqo);
+  }
 }
+
 /* Get in-phase component */
 SUFLOAT su_ncqo_get_i(su_ncqo_t *ncqo);
 
@@ -232,6 +376,21 @@ SUFLOAT su_ncqo_read_q(su_ncqo_t *ncqo);
 /* Read (compute next + get) both components as complex */
 SUCOMPLEX su_ncqo_read(su_ncqo_t *ncqo);
 
+/*
+ * Bulk versions of su_ncqo_read. Output is computed in chunks of
+ * SU_NCQO_BULK_STRIDE samples, with loops simple enough to be vectorized
+ * by the compiler. Frequency and phase changes take effect at call
+ * boundaries.
+ */
+void su_ncqo_read_bulk(su_ncqo_t *ncqo, SUCOMPLEX *out, SUSCOUNT len);
+
+/* out[i] = in[i] * su_ncqo_read(ncqo). in and out may be the same buffer */
+void su_ncqo_mix_bulk(
+    su_ncqo_t *ncqo,
+    const SUCOMPLEX *in,
+    SUCOMPLEX *out,
+    SUSCOUNT len);
+
 /* Set oscillator frequency (normalized angular freq) */
 void su_ncqo_set_angfreq(su_ncqo_t *ncqo, SUFLOAT omrel);
 
@@ -250,6 +409,66 @@ void su_ncqo_inc_freq(su_ncqo_t *ncqo, SUFLOAT delta);
 /* Get current frequency (normalized freq) */
 SUFLOAT su_ncqo_get_freq(const su_ncqo_t *ncqo);
 
+/*
+ * Compact NCQO: a fixed-point phase accumulator (2^32 is a full turn) and
+ * a sine table shared by all instances, read with linear interpolation.
+ * Meant for objects holding many oscillators, as it takes 8 bytes instead
+ * of the precalculated buffers of su_ncqo_t.
+ */
+struct sigutils_lut_ncqo {
+  uint32_t phase;  /* Current phase */
+  uint32_t dphase; /* Phase increment (frequency word) */
+};
+
+typedef struct sigutils_lut_ncqo su_lut_ncqo_t;
+
+#define su_lut_ncqo_INITIALIZER {0, 0}
+
+void su_lut_ncqo_init(su_lut_ncqo_t *ncqo, SUFLOAT fnor);
+
+SUINLINE void
+su_lut_ncqo_set_freq(su_lut_ncqo_t *ncqo, SUFLOAT fnor)
+{
+  ncqo->dphase = __su_ncqo_freq_to_word(fnor);
+}
+
+SUINLINE SUFLOAT
+su_lut_ncqo_get_freq(const su_lut_ncqo_t *ncqo)
+{
+  return __su_ncqo_word_to_freq(ncqo->dphase);
+}
+
+SUINLINE void
+su_lut_ncqo_set_phase(su_lut_ncqo_t *ncqo, SUFLOAT phi)
+{
+  ncqo->phase = __su_ncqo_freq_to_word(phi / PI);
+}
+
+SUINLINE SUFLOAT
+su_lut_ncqo_get_phase(const su_lut_ncqo_t *ncqo)
+{
+  return (SUFLOAT) (ncqo->phase * (2 * PI / 4294967296.));
+}
+
+/* Read (get + compute next) both components as complex */
+SUINLINE SUCOMPLEX
+su_lut_ncqo_read(su_lut_ncqo_t *ncqo)
+{
+  SUFLOAT s, c;
+
+  __su_ncqo_lut_sincos(ncqo->phase, &s, &c);
+  ncqo->phase += ncqo->dphase;
+
+  return c + I * s;
+}
+
+/* out[i] = in[i] * su_lut_ncqo_read(ncqo). in and out may be the same */
+void su_lut_ncqo_mix_bulk(
+    su_lut_ncqo_t *ncqo,
+    const SUCOMPLEX *in,
+    SUCOMPLEX *out,
+    SUSCOUNT len);
+
 #ifdef __cplusplus
 #  ifdef __clang__
 #    pragma clang diagnostic pop
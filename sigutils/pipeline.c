@@ -0,0 +1,346 @@
+/*
+
+  Copyright (C) 2016 Gonzalo José Carracedo Carballal
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, version 3.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this program.  If not, see
+  <http://www.gnu.org/licenses/>
+
+*/
+
+#ifdef __linux__
+#  ifndef _GNU_SOURCE
+#    define _GNU_SOURCE
+#  endif /* _GNU_SOURCE */
+#  include <sched.h>
+#  define SU_PIPELINE_HAVE_AFFINITY
+#endif /* __linux__ */
+
+#include <string.h>
+
+#define SU_LOG_LEVEL "pipeline"
+
+#include "log.h"
+#include "pipeline.h"
+
+SUPRIVATE void
+su_pipeline_worker_destroy(su_pipeline_worker_t *worker)
+{
+  if (worker->cpu_list != NULL)
+    free(worker->cpu_list);
+
+  free(worker);
+}
+
+SUPRIVATE su_pipeline_worker_t *
+su_pipeline_worker_new(
+    su_pipeline_t *owner,
+    su_block_t *block,
+    unsigned int port_id)
+{
+  su_pipeline_worker_t *new = NULL;
+
+  if ((new = calloc(1, sizeof (su_pipeline_worker_t))) == NULL)
+    return NULL;
+
+  new->owner   = owner;
+  new->block   = block;
+  new->port_id = port_id;
+
+  return new;
+}
+
+/* Pin the worker, and move the streams it reads from to its NUMA node */
+SUPRIVATE void
+su_pipeline_worker_place(su_pipeline_worker_t *worker)
+{
+#ifdef SU_PIPELINE_HAVE_AFFINITY
+  cpu_set_t set;
+  unsigned int i;
+
+  CPU_ZERO(&set);
+
+  for (i = 0; i < worker->cpu_count; ++i)
+    CPU_SET(worker->cpu_list[i], &set);
+
+  if (pthread_setaffinity_np(pthread_self(), sizeof (cpu_set_t), &set) != 0) {
+    SU_WARNING(
+        "%s: cannot set CPU affinity of worker for output #%d\n",
+        worker->block->classname->name,
+        worker->port_id);
+    return;
+  }
+
+  /* Inputs are shared by all outputs, relocate them once */
+  if (worker->port_id == 0)
+    for (i = 0; i < worker->block->classname->in_size; ++i)
+      if (su_block_port_is_plugged(worker->block->in + i)
+          && worker->block->in[i].fc->consumers == 1)
+        if (!su_block_port_relocate_stream(worker->block->in + i))
+          SU_WARNING(
+              "%s: cannot relocate stream of input #%d\n",
+              worker->block->classname->name,
+              i);
+#else
+  SU_WARNING("CPU affinity not supported in this platform\n");
+#endif /* SU_PIPELINE_HAVE_AFFINITY */
+}
+
+SUPRIVATE void *
+su_pipeline_worker_thread(void *data)
+{
+  su_pipeline_worker_t *worker = (su_pipeline_worker_t *) data;
+  su_pipeline_t *pipeline = worker->owner;
+  SUSDIFF got;
+
+  if (worker->cpu_count > 0)
+    su_pipeline_worker_place(worker);
+
+  /* Streams must not be written before all consumers have placed them */
+  pthread_mutex_lock(&pipeline->lock);
+
+  ++pipeline->ready;
+  pthread_cond_broadcast(&pipeline->cond);
+
+  while (pipeline->ready < pipeline->worker_count && !pipeline->cancelled)
+    pthread_cond_wait(&pipeline->cond, &pipeline->lock);
+
+  pthread_mutex_unlock(&pipeline->lock);
+
+  /* su_block_produce forces EOS when this loop ends */
+  while ((got = su_block_produce(worker->block, worker->port_id)) > 0);
+
+  if (got < 0)
+    SU_ERROR(
+        "%s: worker for output #%d failed\n",
+        worker->block->classname->name,
+        worker->port_id);
+
+  return NULL;
+}
+
+su_pipeline_t *
+su_pipeline_new(void)
+{
+  su_pipeline_t *new = NULL;
+
+  if ((new = calloc(1, sizeof (su_pipeline_t))) == NULL)
+    return NULL;
+
+  if (pthread_mutex_init(&new->lock, NULL) != 0) {
+    free(new);
+    return NULL;
+  }
+
+  if (pthread_cond_init(&new->cond, NULL) != 0) {
+    pthread_mutex_destroy(&new->lock);
+    free(new);
+    return NULL;
+  }
+
+  return new;
+}
+
+SUBOOL
+su_pipeline_add_block(su_pipeline_t *pipeline, su_block_t *block)
+{
+  su_pipeline_worker_t *worker = NULL;
+  unsigned int async_count = 0;
+  unsigned int i;
+
+  if (pipeline->running) {
+    SU_ERROR("Cannot add blocks to a running pipeline\n");
+    return SU_FALSE;
+  }
+
+  for (i = 0; i < pipeline->worker_count; ++i)
+    if (pipeline->worker_list[i]->block == block) {
+      SU_ERROR("Block `%s' already in pipeline\n", block->classname->name);
+      return SU_FALSE;
+    }
+
+  for (i = 0; i < block->classname->out_size; ++i) {
+    SU_TRYCATCH(su_block_set_async(block, i, SU_TRUE), goto fail);
+    ++async_count;
+
+    SU_TRYCATCH(worker = su_pipeline_worker_new(pipeline, block, i), goto fail);
+    SU_TRYCATCH(PTR_LIST_APPEND_CHECK(pipeline->worker, worker) != -1, goto fail);
+    worker = NULL;
+  }
+
+  return SU_TRUE;
+
+fail:
+  if (worker != NULL)
+    su_pipeline_worker_destroy(worker);
+
+  /* Leave the block as it was: no workers, and all outputs synchronous */
+  for (i = 0; i < pipeline->worker_count; ++i)
+    if (pipeline->worker_list[i] != NULL
+        && pipeline->worker_list[i]->block == block) {
+      su_pipeline_worker_destroy(pipeline->worker_list[i]);
+      pipeline->worker_list[i] = NULL;
+    }
+
+  /* They were the last ones appended, the list has no holes otherwise */
+  while (pipeline->worker_count > 0
+      && pipeline->worker_list[pipeline->worker_count - 1] == NULL)
+    --pipeline->worker_count;
+
+  for (i = 0; i < async_count; ++i)
+    (void) su_block_set_async(block, i, SU_FALSE);
+
+  return SU_FALSE;
+}
+
+SUBOOL
+su_pipeline_set_affinity(
+    su_pipeline_t *pipeline,
+    const su_block_t *block,
+    const unsigned int *cpu_list,
+    unsigned int cpu_count)
+{
+  su_pipeline_worker_t *worker;
+  unsigned int *copy;
+  unsigned int i;
+  SUBOOL found = SU_FALSE;
+
+  if (pipeline->running) {
+    SU_ERROR("Cannot change affinity of a running pipeline\n");
+    return SU_FALSE;
+  }
+
+#ifdef SU_PIPELINE_HAVE_AFFINITY
+  for (i = 0; i < cpu_count; ++i)
+    if (cpu_list[i] >= CPU_SETSIZE) {
+      SU_ERROR("Invalid CPU %d\n", cpu_list[i]);
+      return SU_FALSE;
+    }
+#endif /* SU_PIPELINE_HAVE_AFFINITY */
+
+  for (i = 0; i < pipeline->worker_count; ++i) {
+    if ((worker = pipeline->worker_list[i]) == NULL
+        || worker->block != block)
+      continue;
+
+    copy = NULL;
+    if (cpu_count > 0) {
+      SU_TRYCATCH(
+          copy = malloc(cpu_count * sizeof (unsigned int)),
+          return SU_FALSE);
+      memcpy(copy, cpu_list, cpu_count * sizeof (unsigned int));
+    }
+
+    if (worker->cpu_list != NULL)
+      free(worker->cpu_list);
+
+    worker->cpu_list  = copy;
+    worker->cpu_count = cpu_count;
+
+    found = SU_TRUE;
+  }
+
+  if (!found) {
+    SU_ERROR("Block `%s' not in pipeline\n", block->classname->name);
+    return SU_FALSE;
+  }
+
+  return SU_TRUE;
+}
+
+SUBOOL
+su_pipeline_start(su_pipeline_t *pipeline)
+{
+  unsigned int i;
+
+  if (pipeline->running) {
+    SU_ERROR("Pipeline already running\n");
+    return SU_FALSE;
+  }
+
+  pipeline->running = SU_TRUE;
+  pipeline->ready = 0;
+  pipeline->cancelled = SU_FALSE;
+
+  for (i = 0; i < pipeline->worker_count; ++i) {
+    if (pthread_create(
+        &pipeline->worker_list[i]->thread,
+        NULL,
+        su_pipeline_worker_thread,
+        pipeline->worker_list[i]) != 0) {
+      SU_ERROR("Failed to create worker thread\n");
+      su_pipeline_stop(pipeline);
+      return SU_FALSE;
+    }
+
+    pipeline->worker_list[i]->thread_running = SU_TRUE;
+  }
+
+  return SU_TRUE;
+}
+
+void
+su_pipeline_stop(su_pipeline_t *pipeline)
+{
+  unsigned int i;
+
+  if (!pipeline->running)
+    return;
+
+  /* Release workers still waiting for the others to start */
+  pthread_mutex_lock(&pipeline->lock);
+  pipeline->cancelled = SU_TRUE;
+  pthread_cond_broadcast(&pipeline->cond);
+  pthread_mutex_unlock(&pipeline->lock);
+
+  /*
+   * Forcing EOS wakes up both workers waiting for room in their outputs
+   * and workers waiting for samples from their upstream blocks.
+   */
+  for (i = 0; i < pipeline->worker_count; ++i)
+    su_block_force_eos(
+        pipeline->worker_list[i]->block,
+        pipeline->worker_list[i]->port_id);
+
+  for (i = 0; i < pipeline->worker_count; ++i)
+    if (pipeline->worker_list[i]->thread_running) {
+      pthread_join(pipeline->worker_list[i]->thread, NULL);
+      pipeline->worker_list[i]->thread_running = SU_FALSE;
+    }
+
+  pipeline->running = SU_FALSE;
+}
+
+void
+su_pipeline_destroy(su_pipeline_t *pipeline)
+{
+  unsigned int i;
+
+  su_pipeline_stop(pipeline);
+
+  for (i = 0; i < pipeline->worker_count; ++i)
+    if (pipeline->worker_list[i] != NULL) {
+      su_block_set_async(
+          pipeline->worker_list[i]->block,
+          pipeline->worker_list[i]->port_id,
+          SU_FALSE);
+      su_pipeline_worker_destroy(pipeline->worker_list[i]);
+    }
+
+  if (pipeline->worker_list != NULL)
+    free(pipeline->worker_list);
+
+  pthread_mutex_destroy(&pipeline->lock);
+  pthread_cond_destroy(&pipeline->cond);
+
+  free(pipeline);
+}
@@ -0,0 +1,102 @@
+/*
+
+  Copyright (C) 2016 Gonzalo José Carracedo Carballal
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, version 3.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this program.  If not, see
+  <http://www.gnu.org/licenses/>
+
+*/
+
+#ifndef _SIGUTILS_PIPELINE_H
+#define _SIGUTILS_PIPELINE_H
+
+#include <pthread.h>
+#include <util.h>
+#include "types.h"
+#include "block.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * Pipelines run the acquire() method of every block output added to them
+ * in a dedicated worker thread. Block outputs become asynchronous: their
+ * streams act as bounded queues, and reading from them just waits for the
+ * worker thread to produce new samples.
+ *
+ * Blocks must be plugged before being added to the pipeline, and outputs
+ * can only have one consumer. Blocks not added to the pipeline keep working
+ * in pull mode, in the thread of their consumer.
+ *
+ * Workers can be pinned to a set of CPUs. Pinned workers also reallocate
+ * the streams they read from before any worker starts producing samples,
+ * so that under first-touch memory policies (the Linux default) streams
+ * end up in the NUMA node of their consumer.
+ */
+struct sigutils_pipeline;
+
+struct sigutils_pipeline_worker {
+  struct sigutils_pipeline *owner;
+  su_block_t *block;
+  unsigned int port_id;
+
+  unsigned int *cpu_list; /* CPUs this worker is pinned to */
+  unsigned int cpu_count;
+
+  pthread_t thread;
+  SUBOOL thread_running;
+};
+
+typedef struct sigutils_pipeline_worker su_pipeline_worker_t;
+
+struct sigutils_pipeline {
+  PTR_LIST(su_pipeline_worker_t, worker);
+  SUBOOL running;
+
+  /* Workers wait here until all of them are placed */
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  unsigned int ready;
+  SUBOOL cancelled;
+};
+
+typedef struct sigutils_pipeline su_pipeline_t;
+
+su_pipeline_t *su_pipeline_new(void);
+
+/* Run all outputs of this block in their own threads */
+SUBOOL su_pipeline_add_block(su_pipeline_t *pipeline, su_block_t *block);
+
+/*
+ * Pin the workers of a block already added to the pipeline to the given
+ * CPUs. Must be called before the pipeline starts.
+ */
+SUBOOL su_pipeline_set_affinity(
+    su_pipeline_t *pipeline,
+    const su_block_t *block,
+    const unsigned int *cpu_list,
+    unsigned int cpu_count);
+
+SUBOOL su_pipeline_start(su_pipeline_t *pipeline);
+
+/* Force EOS on all outputs and wait for the workers to finish */
+void su_pipeline_stop(su_pipeline_t *pipeline);
+
+void su_pipeline_destroy(su_pipeline_t *pipeline);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _SIGUTILS_PIPELINE_H */
@@ -56,6 +56,12 @@ fail:
   return SU_FALSE;
 }
 
+void
+su_pll_set_phasor(su_pll_t *pll, SUBOOL phasor)
+{
+  su_ncqo_set_phasor(&pll->ncqo, phasor);
+}
+
 SUCOMPLEX
 su_pll_track(su_pll_t *pll, SUCOMPLEX x)
 {
@@ -105,6 +111,12 @@ su_costas_set_loop_gain(su_costas_t *costas, SUFLOAT gain)
   costas->gain = gain;
 }
 
+void
+su_costas_set_phasor(su_costas_t *costas, SUBOOL phasor)
+{
+  su_ncqo_set_phasor(&costas->ncqo, phasor);
+}
+
 SUBOOL
 su_costas_init(
     su_costas_t *costas,
@@ -182,40 +194,28 @@ fail:
   return SU_FALSE;
 }
 
-SUCOMPLEX
-su_costas_feed(su_costas_t *costas, SUCOMPLEX x)
+SUINLINE SUFLOAT
+__su_costas_error(enum sigutils_costas_kind kind, SUCOMPLEX z)
 {
-  SUCOMPLEX s;
   SUCOMPLEX L;
   SUFLOAT e = 0;
 
-  s = su_ncqo_read(&costas->ncqo);
-  /*
-   * s = cos(wt) + sin(wt). Signal sQ be 90 deg delayed wrt sI, therefore
-   * we must multiply by conj(s).
-   */
-  costas->z = costas->gain * su_iir_filt_feed(&costas->af, SU_C_CONJ(s) * x);
-
-  switch (costas->kind) {
-    case SU_COSTAS_KIND_NONE:
-      SU_ERROR("Invalid Costas loop\n");
-      return 0;
-
+  switch (kind) {
     case SU_COSTAS_KIND_BPSK:
       /* Taken directly from Wikipedia */
-      e = -SU_C_REAL(costas->z) * SU_C_IMAG(costas->z);
+      e = -SU_C_REAL(z) * SU_C_IMAG(z);
       break;
 
     case SU_COSTAS_KIND_QPSK:
       /* Compute limiter output */
-      L = SU_C_SGN(costas->z);
+      L = SU_C_SGN(z);
 
       /*
        * Error signal taken from Maarten Tytgat's paper "Time Domain Model
        * for Costas Loop Based QPSK Receiver.
        */
-      e =  SU_C_REAL(L) * SU_C_IMAG(costas->z)
-          -SU_C_IMAG(L) * SU_C_REAL(costas->z);
+      e =  SU_C_REAL(L) * SU_C_IMAG(z)
+          -SU_C_IMAG(L) * SU_C_REAL(z);
       break;
 
     case SU_COSTAS_KIND_8PSK:
@@ -240,31 +240,100 @@ su_costas_feed(su_costas_t *costas, SUCOMPLEX x)
        * -----------8<--------------------------------------------------
        */
 
-      L = SU_C_SGN(costas->z);
+      L = SU_C_SGN(z);
 
-      if (SU_ABS(SU_C_REAL(costas->z)) >= SU_ABS(SU_C_IMAG(costas->z)))
-        e =  SU_C_REAL(L) * SU_C_IMAG(costas->z)
-            -SU_C_IMAG(L) * SU_C_REAL(costas->z) * (SU_SQRT2 - 1);
+      if (SU_ABS(SU_C_REAL(z)) >= SU_ABS(SU_C_IMAG(z)))
+        e =  SU_C_REAL(L) * SU_C_IMAG(z)
+            -SU_C_IMAG(L) * SU_C_REAL(z) * (SU_SQRT2 - 1);
       else
-        e =  SU_C_REAL(L) * SU_C_IMAG(costas->z) * (SU_SQRT2 - 1)
-            -SU_C_IMAG(L) * SU_C_REAL(costas->z);
+        e =  SU_C_REAL(L) * SU_C_IMAG(z) * (SU_SQRT2 - 1)
+            -SU_C_IMAG(L) * SU_C_REAL(z);
       break;
 
     default:
-      SU_ERROR("Unsupported Costas loop kind\n");
-      return 0;
+      break;
+  }
+
+  return e;
+}
+
+/*
+ * The loop kind is a constant in every call to this function, so the
+ * phase detector is chosen once per call instead of once per sample.
+ */
+SUINLINE void
+__su_costas_feed_bulk(
+    su_costas_t *costas,
+    const SUCOMPLEX *x,
+    SUCOMPLEX *y,
+    SUSCOUNT len,
+    enum sigutils_costas_kind kind)
+{
+  SUCOMPLEX s;
+  SUFLOAT e;
+  SUSCOUNT i;
+
+  for (i = 0; i < len; ++i) {
+    s = su_ncqo_read(&costas->ncqo);
+    /*
+     * s = cos(wt) + sin(wt). Signal sQ be 90 deg delayed wrt sI, therefore
+     * we must multiply by conj(s).
+     */
+    costas->z = costas->gain * su_iir_filt_feed(&costas->af, SU_C_CONJ(s) * x[i]);
+
+    e = __su_costas_error(kind, costas->z);
+
+    costas->lock += costas->a * (1 - e - costas->lock);
+    costas->y += costas->y_alpha * (costas->z - costas->y);
+
+    /* IIR loop filter suggested by Eric Hagemann */
+    su_ncqo_inc_angfreq(&costas->ncqo, costas->b * e);
+    su_ncqo_inc_phase(&costas->ncqo, costas->a * e);
+
+    y[i] = costas->y;
   }
+}
+
+void
+su_costas_feed_bulk(
+    su_costas_t *costas,
+    const SUCOMPLEX *x,
+    SUCOMPLEX *y,
+    SUSCOUNT len)
+{
+  switch (costas->kind) {
+    case SU_COSTAS_KIND_BPSK:
+      __su_costas_feed_bulk(costas, x, y, len, SU_COSTAS_KIND_BPSK);
+      break;
+
+    case SU_COSTAS_KIND_QPSK:
+      __su_costas_feed_bulk(costas, x, y, len, SU_COSTAS_KIND_QPSK);
+      break;
 
-  costas->lock += costas->a * (1 - e - costas->lock);
-  costas->y += costas->y_alpha * (costas->z - costas->y);
+    case SU_COSTAS_KIND_8PSK:
+      __su_costas_feed_bulk(costas, x, y, len, SU_COSTAS_KIND_8PSK);
+      break;
 
-  /* IIR loop filter suggested by Eric Hagemann */
-  su_ncqo_inc_angfreq(&costas->ncqo, costas->b * e);
-  su_ncqo_inc_phase(&costas->ncqo, costas->a * e);
+    case SU_COSTAS_KIND_NONE:
+      SU_ERROR("Invalid Costas loop\n");
+      memset(y, 0, len * sizeof (SUCOMPLEX));
+      break;
 
-  return costas->y;
+    default:
+      SU_ERROR("Unsupported Costas loop kind\n");
+      memset(y, 0, len * sizeof (SUCOMPLEX));
+  }
 }
 
+SUCOMPLEX
+su_costas_feed(su_costas_t *costas, SUCOMPLEX x)
+{
+  SUCOMPLEX y;
+
+  su_costas_feed_bulk(costas, &x, &y, 1);
+
+  return y;
+}
 
 void
 su_costas_set_kind(su_costas_t *costas, enum sigutils_costas_kind kind)
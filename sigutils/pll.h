@@ -81,6 +81,9 @@ SUBOOL su_pll_init(su_pll_t *, SUFLOAT, SUFLOAT);
 SUCOMPLEX su_pll_track(su_pll_t *, SUCOMPLEX);
 void su_pll_feed(su_pll_t *, SUFLOAT);
 
+/* Use a phasor-rotation NCQO (see su_ncqo_set_phasor) */
+void su_pll_set_phasor(su_pll_t *, SUBOOL);
+
 /* QPSK costas loops are way more complex than that */
 void su_costas_finalize(su_costas_t *);
 
@@ -96,6 +99,15 @@ void su_costas_set_kind(su_costas_t *costas, enum sigutils_costas_kind);
 
 void su_costas_set_loop_gain(su_costas_t *costas, SUFLOAT gain);
 
+void su_costas_set_phasor(su_costas_t *costas, SUBOOL phasor);
+
 SUCOMPLEX su_costas_feed(su_costas_t *costas, SUCOMPLEX x);
 
+/* Feed a bunch of samples. x and y may point to the same buffer */
+void su_costas_feed_bulk(
+    su_costas_t *costas,
+    const SUCOMPLEX *x,
+    SUCOMPLEX *y,
+    SUSCOUNT len);
+
 #endif /* _SIGUTILS_PLL_H */
@@ -0,0 +1,217 @@
+/*
+
+  Copyright (C) 2016 Gonzalo José Carracedo Carballal
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, version 3.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this program.  If not, see
+  <http://www.gnu.org/licenses/>
+
+*/
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#define SU_LOG_DOMAIN "resampler"
+
+#include "log.h"
+#include "resampler.h"
+#include "taps.h"
+
+SUPRIVATE SUSCOUNT
+su_resampler_gcd(SUSCOUNT a, SUSCOUNT b)
+{
+  SUSCOUNT t;
+
+  while (b != 0) {
+    t = a % b;
+    a = b;
+    b = t;
+  }
+
+  return a;
+}
+
+SUINLINE void
+__su_resampler_push(su_resampler_t *resampler, SUCOMPLEX x)
+{
+  resampler->x[resampler->x_ptr] = x;
+  resampler->x[resampler->x_ptr + resampler->phase_size] = x;
+
+  if (++resampler->x_ptr == resampler->phase_size)
+    resampler->x_ptr = 0;
+}
+
+/* Evaluate one phase of the filter over the last phase_size samples */
+SUINLINE SUCOMPLEX
+__su_resampler_eval(const su_resampler_t *resampler, unsigned int phase)
+{
+  const SUFLOAT *h = resampler->bank + phase * resampler->phase_size;
+  const SUCOMPLEX *x = resampler->x + resampler->x_ptr;
+  SUCOMPLEX y = 0;
+  unsigned int i;
+
+  for (i = 0; i < resampler->phase_size; ++i)
+    y += h[i] * x[i];
+
+  return y;
+}
+
+void
+su_resampler_finalize(su_resampler_t *resampler)
+{
+  if (resampler->bank != NULL)
+    free(resampler->bank);
+
+  if (resampler->x != NULL)
+    free(resampler->x);
+
+  resampler->bank = NULL;
+  resampler->x = NULL;
+}
+
+SUBOOL
+su_resampler_init(
+    su_resampler_t *resampler,
+    unsigned int interp,
+    unsigned int decim,
+    unsigned int lobes)
+{
+  SUFLOAT *h = NULL;
+  unsigned int max;
+  unsigned int gcd;
+  unsigned int size;
+  unsigned int p, j;
+  SUBOOL ok = SU_FALSE;
+
+  memset(resampler, 0, sizeof (su_resampler_t));
+
+  SU_TRYCATCH(interp > 0 && decim > 0, goto done);
+
+  if (lobes == 0)
+    lobes = SU_RESAMPLER_DEFAULT_LOBES;
+
+  gcd = su_resampler_gcd(interp, decim);
+  interp /= gcd;
+  decim  /= gcd;
+
+  resampler->interp = interp;
+  resampler->decim  = decim;
+
+  /*
+   * The prototype filter works at interp times the input rate, and must
+   * remove both the images of the upsampling and whatever would alias
+   * after decimation. Its length is rounded up to a whole number of taps
+   * per phase.
+   */
+  max  = SU_MAX(interp, decim);
+  resampler->phase_size = (lobes * max + interp - 1) / interp;
+  size = resampler->phase_size * interp;
+
+  SU_TRYCATCH(h = malloc(size * sizeof (SUFLOAT)), goto done);
+  SU_TRYCATCH(
+      resampler->bank = malloc(size * sizeof (SUFLOAT)),
+      goto done);
+  SU_TRYCATCH(
+      resampler->x = calloc(2 * resampler->phase_size, sizeof (SUCOMPLEX)),
+      goto done);
+
+  su_taps_brickwall_lp_init(h, 1. / max, size);
+
+  /*
+   * Phase p is applied to the input samples at times p, p + interp,
+   * p + 2 * interp... (newest first) of the upsampled signal. Zero
+   * stuffing divides the gain by interp, which is restored here.
+   */
+  for (p = 0; p < interp; ++p)
+    for (j = 0; j < resampler->phase_size; ++j)
+      resampler->bank[(p + 1) * resampler->phase_size - j - 1]
+        = interp * h[p + j * interp];
+
+  ok = SU_TRUE;
+
+done:
+  if (h != NULL)
+    free(h);
+
+  if (!ok)
+    su_resampler_finalize(resampler);
+
+  return ok;
+}
+
+SUBOOL
+su_resampler_init_rate(
+    su_resampler_t *resampler,
+    SUSCOUNT in_rate,
+    SUSCOUNT out_rate,
+    unsigned int lobes)
+{
+  SUSCOUNT gcd;
+
+  SU_TRYCATCH(in_rate > 0 && out_rate > 0, return SU_FALSE);
+
+  gcd = su_resampler_gcd(in_rate, out_rate);
+  in_rate  /= gcd;
+  out_rate /= gcd;
+
+  if (in_rate > UINT32_MAX || out_rate > UINT32_MAX) {
+    SU_ERROR("Cannot resample: rate ratio too big\n");
+    return SU_FALSE;
+  }
+
+  return su_resampler_init(
+      resampler,
+      (unsigned int) out_rate,
+      (unsigned int) in_rate,
+      lobes);
+}
+
+void
+su_resampler_reset(su_resampler_t *resampler)
+{
+  memset(resampler->x, 0, 2 * resampler->phase_size * sizeof (SUCOMPLEX));
+
+  resampler->phase = 0;
+  resampler->x_ptr = 0;
+}
+
+SUSCOUNT
+su_resampler_feed_bulk(
+    su_resampler_t *resampler,
+    const SUCOMPLEX *x,
+    SUSCOUNT len,
+    SUCOMPLEX *y)
+{
+  SUSCOUNT i;
+  SUSCOUNT n = 0;
+  unsigned int phase = resampler->phase;
+
+  /*
+   * phase is the time of the next output in the upsampled signal,
+   * relative to the last input sample.
+   */
+  for (i = 0; i < len; ++i) {
+    __su_resampler_push(resampler, x[i]);
+
+    while (phase < resampler->interp) {
+      y[n++] = __su_resampler_eval(resampler, phase);
+      phase += resampler->decim;
+    }
+
+    phase -= resampler->interp;
+  }
+
+  resampler->phase = phase;
+
+  return n;
+}
@@ -0,0 +1,112 @@
+/*
+
+  Copyright (C) 2016 Gonzalo José Carracedo Carballal
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, version 3.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this program.  If not, see
+  <http://www.gnu.org/licenses/>
+
+*/
+
+#ifndef _SIGUTILS_RESAMPLER_H
+#define _SIGUTILS_RESAMPLER_H
+
+#include "types.h"
+
+#ifdef __cplusplus
+#  ifdef __clang__
+#    pragma clang diagnostic push
+#    pragma clang diagnostic ignored "-Wreturn-type-c-linkage"
+#  endif // __clang__
+extern "C" {
+#endif /* __cplusplus */
+
+/* Length of the anti-aliasing filter, in zero crossings of its sinc */
+#define SU_RESAMPLER_DEFAULT_LOBES 16
+
+/*
+ * Rational resampler: changes the sample rate by interp / decim in a
+ * single pass. Conceptually, the input is upsampled by interp (zero
+ * stuffing), low pass filtered and decimated by decim. The filter is split
+ * in interp phases of phase_size taps each, and only the phases of the
+ * samples that are kept are evaluated, so every output costs phase_size
+ * complex-by-real products.
+ */
+struct sigutils_resampler {
+  unsigned int interp;     /* L */
+  unsigned int decim;      /* M */
+  unsigned int phase_size; /* Taps per phase */
+  unsigned int phase;      /* Phase of the next output */
+  unsigned int x_ptr;      /* Delay line position */
+
+  SUFLOAT   *bank; /* interp phases of phase_size taps, in reverse order */
+  SUCOMPLEX *x;    /* Delay line (2 * phase_size) */
+};
+
+typedef struct sigutils_resampler su_resampler_t;
+
+#define su_resampler_INITIALIZER {1, 1, 0, 0, 0, NULL, NULL}
+
+/*
+ * Initialize a resampler by interp / decim (the fraction is reduced
+ * first). The windowed-sinc filter spans `lobes' zero crossings, or
+ * SU_RESAMPLER_DEFAULT_LOBES if 0.
+ */
+SUBOOL su_resampler_init(
+    su_resampler_t *resampler,
+    unsigned int interp,
+    unsigned int decim,
+    unsigned int lobes);
+
+/* Resample from in_rate to out_rate (i.e. in samples per second) */
+SUBOOL su_resampler_init_rate(
+    su_resampler_t *resampler,
+    SUSCOUNT in_rate,
+    SUSCOUNT out_rate,
+    unsigned int lobes);
+
+void su_resampler_finalize(su_resampler_t *resampler);
+
+void su_resampler_reset(su_resampler_t *resampler);
+
+/* Largest number of input samples that produce at most `outputs' samples */
+SUINLINE SUSCOUNT
+su_resampler_get_max_input(const su_resampler_t *resampler, SUSCOUNT outputs)
+{
+  return (outputs * resampler->decim + resampler->phase) / resampler->interp;
+}
+
+/* Largest number of output samples produced by `len' input samples */
+SUINLINE SUSCOUNT
+su_resampler_get_max_output(const su_resampler_t *resampler, SUSCOUNT len)
+{
+  return (len * resampler->interp + resampler->decim - 1) / resampler->decim;
+}
+
+/*
+ * Push len samples, returns the number of outputs written to y. When
+ * decimating (interp <= decim), x and y may be the same buffer.
+ */
+SUSCOUNT su_resampler_feed_bulk(
+    su_resampler_t *resampler,
+    const SUCOMPLEX *x,
+    SUSCOUNT len,
+    SUCOMPLEX *y);
+
+#ifdef __cplusplus
+#  ifdef __clang__
+#    pragma clang diagnostic pop
+#  endif // __clang__
+}
+#endif /* __cplusplus */
+
+#endif /* _SIGUTILS_RESAMPLER_H */
@@ -232,7 +232,7 @@ su_smoothpsd_set_params(
     memset(fftbuf, 0, params->fft_size * sizeof(SU_FFTW(_complex)));
 
     /* Direct FFT plan */
-    if ((fft_plan = SU_FFTW(_plan_dft_1d)(
+    if ((fft_plan = su_lib_plan_dft_1d(
         params->fft_size,
         fftbuf,
         fftbuf,
@@ -325,7 +325,7 @@ done:
     (void) pthread_mutex_unlock(&self->mutex);
 
   if (fft_plan != NULL)
-    SU_FFTW(_destroy_plan)(fft_plan);
+    su_lib_destroy_plan(fft_plan);
 
   if (window_func != NULL)
     SU_FFTW(_free)(window_func);
@@ -346,7 +346,7 @@ su_smoothpsd_destroy(su_smoothpsd_t *self)
     pthread_mutex_destroy(&self->mutex);
 
   if (self->fft_plan != NULL)
-    SU_FFTW(_destroy_plan)(self->fft_plan);
+    su_lib_destroy_plan(self->fft_plan);
 
   if (self->window_func != NULL)
     SU_FFTW(_free)(self->window_func);
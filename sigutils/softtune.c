@@ -46,6 +46,8 @@ su_softtuner_init(
     su_softtuner_t *tuner,
     const struct sigutils_softtuner_params *params)
 {
+  SUFLOAT fc;
+
   assert(params->samp_rate > 0);
   assert(params->decimation > 0);
 
@@ -58,13 +60,29 @@ su_softtuner_init(
       su_stream_init(&tuner->output, SU_BLOCK_STREAM_BUFFER_SIZE),
       goto fail);
 
+  /* Negative frequency: mixing brings fc down to baseband */
   su_ncqo_init_fixed(
       &tuner->lo,
-      SU_ABS2NORM_FREQ(params->samp_rate, params->fc));
+      -SU_ABS2NORM_FREQ(params->samp_rate, params->fc));
+
+  if (params->phasor)
+    su_ncqo_set_phasor(&tuner->lo, SU_TRUE);
 
-  if (params->bw > 0.0) {
+  if (params->fir_decim && params->decimation > 1) {
+    /* Output bandwidth, as long as it fits in the decimated band */
+    fc = 0;
+    if (params->bw > 0.0)
+      fc = SU_MIN(
+          .5 * SU_ABS2NORM_FREQ(params->samp_rate, params->bw)
+             * SU_SOFTTUNER_ANTIALIAS_EXTRA_BW,
+          1. / params->decimation);
+
+    SU_TRYCATCH(
+        su_fir_decim_init_lpf(&tuner->decim, params->decimation, fc, 0),
+        goto fail);
+  } else if (params->bw > 0.0) {
     SU_TRYCATCH(
-        su_iir_bwlpf_init(
+        su_sos_bwlpf_init(
             &tuner->antialias,
             SU_SOFTTUNER_ANTIALIAS_ORDER,
             .5 * SU_ABS2NORM_FREQ(params->samp_rate, params->bw)
@@ -88,7 +106,9 @@ su_softtuner_feed(
     SUSCOUNT size)
 {
   SUSCOUNT  i = 0;
+  SUSCOUNT  j, chunk;
   SUCOMPLEX x;
+  SUCOMPLEX mix[SU_SOFTTUNER_MIX_STRIDE];
   SUSCOUNT avail;
   SUCOMPLEX *buf;
   SUSCOUNT n = 0;
@@ -100,25 +120,52 @@ su_softtuner_feed(
 
   SU_TRYCATCH(avail > 0, return 0);
 
+  if (tuner->decim.x != NULL) {
+    size = SU_MIN(size, su_fir_decim_get_max_input(&tuner->decim, avail));
+
+    for (i = 0; i < size; i += chunk) {
+      chunk = SU_MIN(size - i, SU_SOFTTUNER_MIX_STRIDE);
+
+      su_ncqo_mix_bulk(&tuner->lo, input + i, mix, chunk);
+      n += su_fir_decim_feed_bulk(&tuner->decim, mix, chunk, buf + n);
+    }
+
+    su_stream_advance_contiguous(&tuner->output, n);
+
+    return i;
+  }
+
   buf[0] = 0;
 
-  for (i = 0; i < size && n < avail; ++i) {
+  /*
+   * Do not mix more samples than those that fit in the output stream, as
+   * the oscillator cannot go back.
+   */
+  size = SU_MIN(size, avail * tuner->params.decimation - tuner->decim_ptr);
+
+  for (i = 0; i < size; i += chunk) {
+    chunk = SU_MIN(size - i, SU_SOFTTUNER_MIX_STRIDE);
+
     /* Carrier centering. Must happen *before* decimation */
-    x = input[i] * SU_C_CONJ(su_ncqo_read(&tuner->lo));
+    su_ncqo_mix_bulk(&tuner->lo, input + i, mix, chunk);
 
     if (tuner->filtered)
-      x = su_iir_filt_feed(&tuner->antialias, x);
-
-    if (tuner->params.decimation > 1) {
-      if (++tuner->decim_ptr < tuner->params.decimation) {
-        buf[n] += tuner->avginv * x;
+      su_sos_filt_feed_bulk(&tuner->antialias, mix, mix, chunk);
+
+    for (j = 0; j < chunk; ++j) {
+      x = mix[j];
+
+      if (tuner->params.decimation > 1) {
+        if (++tuner->decim_ptr < tuner->params.decimation) {
+          buf[n] += tuner->avginv * x;
+        } else {
+          if (++n < avail)
+            buf[n] = 0;
+          tuner->decim_ptr = 0; /* Reset decimation pointer */
+        }
       } else {
-        if (++n < avail)
-          buf[n] = 0;
-        tuner->decim_ptr = 0; /* Reset decimation pointer */
+        buf[n++] = x;
       }
-    } else {
-      buf[n++] = x;
     }
   }
 
@@ -149,7 +196,9 @@ void
 su_softtuner_finalize(su_softtuner_t *tuner)
 {
   if (tuner->filtered)
-    su_iir_filt_finalize(&tuner->antialias);
+    su_sos_filt_finalize(&tuner->antialias);
+
+  su_fir_decim_finalize(&tuner->decim);
 
   su_stream_finalize(&tuner->output);
 
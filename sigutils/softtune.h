@@ -24,11 +24,13 @@
 #include "sigutils.h"
 #include "ncqo.h"
 #include "sampling.h"
-#include "iir.h"
+#include "sos.h"
+#include "decim.h"
 
 /* Extra bandwidth given to antialias filter */
 #define SU_SOFTTUNER_ANTIALIAS_EXTRA_BW 2
 #define SU_SOFTTUNER_ANTIALIAS_ORDER    4
+#define SU_SOFTTUNER_MIX_STRIDE         256
 
 struct sigutils_channel {
   SUFREQ  fc;    /* Channel central frequency */
@@ -48,6 +50,8 @@ struct sigutils_softtuner_params {
   SUSCOUNT decimation;
   SUFREQ   fc;
   SUFLOAT  bw;
+  SUBOOL   phasor; /* Use a phasor-rotation local oscillator */
+  SUBOOL   fir_decim; /* Decimate with a FIR filter instead of averaging */
 };
 
 #define sigutils_softtuner_params_INITIALIZER   \
@@ -56,12 +60,15 @@ struct sigutils_softtuner_params {
   0, /* decimation */                           \
   0, /* fc */                                   \
   0, /* bw */                                   \
+  SU_FALSE, /* phasor */                        \
+  SU_FALSE, /* fir_decim */                     \
 }
 
 struct sigutils_softtuner {
   struct sigutils_softtuner_params params;
   su_ncqo_t lo; /* Local oscillator */
-  su_iir_filt_t antialias; /* Antialiasing filter */
+  su_sos_filt_t antialias; /* Antialiasing filter */
+  su_fir_decim_t decim; /* Antialiasing + decimation, if fir_decim */
   su_stream_t output; /* Output stream */
   su_off_t read_ptr;
   SUSCOUNT decim_ptr;
@@ -78,7 +85,10 @@ su_channel_detector_set_fc(su_softtuner_t *cd, SUFLOAT fc)
 
   su_ncqo_init(
       &cd->lo,
-      SU_ABS2NORM_FREQ(cd->params.samp_rate, cd->params.fc));
+      -SU_ABS2NORM_FREQ(cd->params.samp_rate, cd->params.fc));
+
+  if (cd->params.phasor)
+    su_ncqo_set_phasor(&cd->lo, SU_TRUE);
 }
 
 void su_softtuner_params_adjust_to_channel(
@@ -0,0 +1,341 @@
+/*
+
+  Copyright (C) 2016 Gonzalo José Carracedo Carballal
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, version 3.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this program.  If not, see
+  <http://www.gnu.org/licenses/>
+
+*/
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#define SU_LOG_DOMAIN "sos"
+
+#include "log.h"
+#include "sos.h"
+
+void
+su_sos_filt_finalize(su_sos_filt_t *filt)
+{
+  if (filt->coef != NULL)
+    free(filt->coef);
+
+  if (filt->z != NULL)
+    free(filt->z);
+
+  filt->coef = NULL;
+  filt->z = NULL;
+}
+
+SUBOOL
+su_sos_filt_init(
+    su_sos_filt_t *filt,
+    unsigned int sections,
+    const SUFLOAT *coef)
+{
+  SU_TRYCATCH(sections > 0, return SU_FALSE);
+
+  memset(filt, 0, sizeof (su_sos_filt_t));
+
+  filt->sections = sections;
+  filt->channels = 1;
+
+  SU_TRYCATCH(
+      filt->coef = malloc(sections * SU_SOS_COEF_COUNT * sizeof (SUFLOAT)),
+      goto fail);
+  SU_TRYCATCH(filt->z = calloc(2 * sections, sizeof (SUCOMPLEX)), goto fail);
+
+  memcpy(filt->coef, coef, sections * SU_SOS_COEF_COUNT * sizeof (SUFLOAT));
+
+  return SU_TRUE;
+
+fail:
+  su_sos_filt_finalize(filt);
+
+  return SU_FALSE;
+}
+
+SUBOOL
+su_sos_filt_set_channels(su_sos_filt_t *filt, unsigned int channels)
+{
+  SUCOMPLEX *z;
+
+  SU_TRYCATCH(channels > 0, return SU_FALSE);
+
+  SU_TRYCATCH(
+      z = calloc(2 * filt->sections * channels, sizeof (SUCOMPLEX)),
+      return SU_FALSE);
+
+  free(filt->z);
+
+  filt->z = z;
+  filt->channels = channels;
+
+  return SU_TRUE;
+}
+
+void
+su_sos_filt_reset(su_sos_filt_t *filt)
+{
+  memset(filt->z, 0, 2 * filt->sections * filt->channels * sizeof (SUCOMPLEX));
+}
+
+SUCOMPLEX
+su_sos_filt_feed(su_sos_filt_t *filt, SUCOMPLEX x)
+{
+  const SUFLOAT *c = filt->coef;
+  SUCOMPLEX *z = filt->z;
+  SUCOMPLEX y;
+  unsigned int i;
+
+  for (i = 0; i < filt->sections; ++i) {
+    y    = c[0] * x + z[0];
+    z[0] = c[1] * x - c[3] * y + z[1];
+    z[1] = c[2] * x - c[4] * y;
+
+    x  = y;
+    c += SU_SOS_COEF_COUNT;
+    z += 2;
+  }
+
+  return x;
+}
+
+/*
+ * Run a whole buffer through one section before going to the next one:
+ * coefficients and state stay in registers, and the recursions of
+ * different channels are independent from each other.
+ */
+SUINLINE void
+__su_sos_filt_section_bulk(
+    const SUFLOAT *c,
+    SUCOMPLEX *z1,
+    SUCOMPLEX *z2,
+    unsigned int channels,
+    const SUCOMPLEX *x,
+    SUCOMPLEX *y,
+    SUSCOUNT len)
+{
+  SUFLOAT b0 = c[0], b1 = c[1], b2 = c[2], a1 = c[3], a2 = c[4];
+  SUCOMPLEX in, out;
+  SUSCOUNT n;
+  unsigned int j;
+
+  for (n = 0; n < len; ++n) {
+    for (j = 0; j < channels; ++j) {
+      in    = x[j];
+      out   = b0 * in + z1[j];
+      z1[j] = b1 * in - a1 * out + z2[j];
+      z2[j] = b2 * in - a2 * out;
+      y[j]  = out;
+    }
+
+    x += channels;
+    y += channels;
+  }
+}
+
+void
+su_sos_filt_feed_bulk(
+    su_sos_filt_t *filt,
+    const SUCOMPLEX *x,
+    SUCOMPLEX *y,
+    SUSCOUNT len)
+{
+  unsigned int ch = filt->channels;
+  unsigned int i;
+
+  for (i = 0; i < filt->sections; ++i) {
+    __su_sos_filt_section_bulk(
+        filt->coef + i * SU_SOS_COEF_COUNT,
+        filt->z + 2 * i * ch,
+        filt->z + (2 * i + 1) * ch,
+        ch,
+        x,
+        y,
+        len);
+
+    /* Remaining sections work in place */
+    x = y;
+  }
+}
+
+/******************************** Design *************************************/
+/*
+ * Sections are designed in the analog domain, with frequencies prewarped
+ * as W = tan(pi * f / 2), and mapped to the digital domain with the
+ * bilinear transform s = (1 - z^-1) / (1 + z^-1).
+ */
+
+/* (n2 s^2 + n1 s + n0) / (s^2 + d1 s + d0) */
+SUPRIVATE void
+su_sos_bilinear(
+    SUFLOAT *c,
+    SUFLOAT n2,
+    SUFLOAT n1,
+    SUFLOAT n0,
+    SUFLOAT d1,
+    SUFLOAT d0)
+{
+  SUFLOAT a0 = 1 + d1 + d0;
+
+  c[0] = (n2 + n1 + n0) / a0;
+  c[1] = 2 * (n0 - n2) / a0;
+  c[2] = (n2 - n1 + n0) / a0;
+  c[3] = 2 * (d0 - 1) / a0;
+  c[4] = (1 - d1 + d0) / a0;
+}
+
+/* (n1 s + n0) / (s + d0) */
+SUPRIVATE void
+su_sos_bilinear_1(SUFLOAT *c, SUFLOAT n1, SUFLOAT n0, SUFLOAT d0)
+{
+  SUFLOAT a0 = 1 + d0;
+
+  c[0] = (n1 + n0) / a0;
+  c[1] = (n0 - n1) / a0;
+  c[2] = 0;
+  c[3] = (d0 - 1) / a0;
+  c[4] = 0;
+}
+
+SUINLINE SUFLOAT
+su_sos_prewarp(SUFLOAT f)
+{
+  return SU_TAN(.5 * M_PI * f);
+}
+
+/* Analog Butterworth pole k of the upper half plane */
+SUINLINE SUCOMPLEX
+su_sos_bw_pole(SUSCOUNT n, SUSCOUNT k)
+{
+  SUFLOAT theta = M_PI * (2 * k + 1) / (2. * n);
+
+  return -SU_SIN(theta) + I * SU_COS(theta);
+}
+
+SUPRIVATE SUBOOL
+su_sos_bw_lp_hp_init(su_sos_filt_t *filt, SUSCOUNT n, SUFLOAT fc, SUBOOL hp)
+{
+  SUFLOAT *coef = NULL;
+  SUFLOAT W;
+  SUFLOAT q;
+  unsigned int sections = (n + 1) / 2;
+  unsigned int k;
+  SUBOOL ok = SU_FALSE;
+
+  SU_TRYCATCH(n > 0, goto done);
+  SU_TRYCATCH(
+      coef = malloc(sections * SU_SOS_COEF_COUNT * sizeof (SUFLOAT)),
+      goto done);
+
+  W = su_sos_prewarp(fc);
+
+  /* Pairs of complex conjugate poles: s^2 + q W s + W^2 */
+  for (k = 0; k < n / 2; ++k) {
+    q = -2 * SU_C_REAL(su_sos_bw_pole(n, k));
+
+    if (hp)
+      su_sos_bilinear(coef + k * SU_SOS_COEF_COUNT, 1, 0, 0, q * W, W * W);
+    else
+      su_sos_bilinear(coef + k * SU_SOS_COEF_COUNT, 0, 0, W * W, q * W, W * W);
+  }
+
+  /* Odd orders have a real pole at -W */
+  if (n & 1) {
+    if (hp)
+      su_sos_bilinear_1(coef + k * SU_SOS_COEF_COUNT, 1, 0, W);
+    else
+      su_sos_bilinear_1(coef + k * SU_SOS_COEF_COUNT, 0, W, W);
+  }
+
+  SU_TRYCATCH(su_sos_filt_init(filt, sections, coef), goto done);
+
+  ok = SU_TRUE;
+
+done:
+  if (coef != NULL)
+    free(coef);
+
+  return ok;
+}
+
+SUBOOL
+su_sos_bwlpf_init(su_sos_filt_t *filt, SUSCOUNT n, SUFLOAT fc)
+{
+  return su_sos_bw_lp_hp_init(filt, n, fc, SU_FALSE);
+}
+
+SUBOOL
+su_sos_bwhpf_init(su_sos_filt_t *filt, SUSCOUNT n, SUFLOAT fc)
+{
+  return su_sos_bw_lp_hp_init(filt, n, fc, SU_TRUE);
+}
+
+SUBOOL
+su_sos_bwbpf_init(su_sos_filt_t *filt, SUSCOUNT n, SUFLOAT f1, SUFLOAT f2)
+{
+  SUFLOAT *coef = NULL;
+  SUFLOAT *c;
+  SUFLOAT W1, W2, W0sq, BW;
+  SUCOMPLEX p, d, s;
+  unsigned int k;
+  SUBOOL ok = SU_FALSE;
+
+  SU_TRYCATCH(n > 0, goto done);
+  SU_TRYCATCH(f1 < f2, goto done);
+  SU_TRYCATCH(
+      coef = malloc(n * SU_SOS_COEF_COUNT * sizeof (SUFLOAT)),
+      goto done);
+
+  W1   = su_sos_prewarp(f1);
+  W2   = su_sos_prewarp(f2);
+  W0sq = W1 * W2;
+  BW   = W2 - W1;
+  c    = coef;
+
+  /*
+   * Low pass to band pass: every low pass pole p becomes the two roots of
+   * s^2 - p BW s + W0^2, with a gain of BW s. The roots of a pair of
+   * conjugate poles are conjugate too, and give two sections.
+   */
+  for (k = 0; k < n / 2; ++k) {
+    p = su_sos_bw_pole(n, k) * BW;
+    d = p * p - 4 * W0sq;
+    d = SU_SQRT(SU_C_ABS(d)) * SU_C_EXP(.5 * I * SU_C_ARG(d));
+
+    s = .5 * (p + d);
+    su_sos_bilinear(c, 0, BW, 0, -2 * SU_C_REAL(s), SU_C_ABS(s) * SU_C_ABS(s));
+    c += SU_SOS_COEF_COUNT;
+
+    s = .5 * (p - d);
+    su_sos_bilinear(c, 0, BW, 0, -2 * SU_C_REAL(s), SU_C_ABS(s) * SU_C_ABS(s));
+    c += SU_SOS_COEF_COUNT;
+  }
+
+  /* The real pole at -1 gives s^2 + BW s + W0^2 */
+  if (n & 1)
+    su_sos_bilinear(c, 0, BW, 0, BW, W0sq);
+
+  SU_TRYCATCH(su_sos_filt_init(filt, n, coef), goto done);
+
+  ok = SU_TRUE;
+
+done:
+  if (coef != NULL)
+    free(coef);
+
+  return ok;
+}
@@ -0,0 +1,105 @@
+/*
+
+  Copyright (C) 2016 Gonzalo José Carracedo Carballal
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, version 3.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this program.  If not, see
+  <http://www.gnu.org/licenses/>
+
+*/
+
+#ifndef _SIGUTILS_SOS_H
+#define _SIGUTILS_SOS_H
+
+#include "types.h"
+
+#ifdef __cplusplus
+#  ifdef __clang__
+#    pragma clang diagnostic push
+#    pragma clang diagnostic ignored "-Wreturn-type-c-linkage"
+#  endif // __clang__
+extern "C" {
+#endif /* __cplusplus */
+
+/* Coefficients per section: b0, b1, b2, a1, a2 (a0 is always 1) */
+#define SU_SOS_COEF_COUNT 5
+
+/*
+ * IIR filter as a cascade of second order sections (biquads), in
+ * transposed direct form II. Unlike the direct form of su_iir_filt_t, high
+ * order filters remain stable in single precision.
+ *
+ * A filter may run several independent channels at once, interleaved in
+ * the same buffer (channel c of frame n is x[n * channels + c]). Since
+ * channels do not depend on each other, the innermost loop of the bulk
+ * kernel goes through channels and can be vectorized.
+ */
+struct sigutils_sos_filt {
+  unsigned int sections;
+  unsigned int channels;
+
+  SUFLOAT   *coef; /* sections * SU_SOS_COEF_COUNT */
+  SUCOMPLEX *z;    /* 2 state variables per section and channel */
+};
+
+typedef struct sigutils_sos_filt su_sos_filt_t;
+
+#define su_sos_filt_INITIALIZER {0, 1, NULL, NULL}
+
+SUBOOL su_sos_filt_init(
+    su_sos_filt_t *filt,
+    unsigned int sections,
+    const SUFLOAT *coef);
+
+/* Change the number of interleaved channels. Resets the filter state */
+SUBOOL su_sos_filt_set_channels(su_sos_filt_t *filt, unsigned int channels);
+
+void su_sos_filt_finalize(su_sos_filt_t *filt);
+
+void su_sos_filt_reset(su_sos_filt_t *filt);
+
+/* Single channel filters only */
+SUCOMPLEX su_sos_filt_feed(su_sos_filt_t *filt, SUCOMPLEX x);
+
+/*
+ * Filter len frames (len * channels samples) from x into y. x and y may
+ * be the same buffer.
+ */
+void su_sos_filt_feed_bulk(
+    su_sos_filt_t *filt,
+    const SUCOMPLEX *x,
+    SUCOMPLEX *y,
+    SUSCOUNT len);
+
+/*
+ * Butterworth filters of order n, designed section by section. Cutoff
+ * frequencies are normalized as in su_iir_bwlpf_init. Band pass filters
+ * have order 2 * n.
+ */
+SUBOOL su_sos_bwlpf_init(su_sos_filt_t *filt, SUSCOUNT n, SUFLOAT fc);
+
+SUBOOL su_sos_bwhpf_init(su_sos_filt_t *filt, SUSCOUNT n, SUFLOAT fc);
+
+SUBOOL su_sos_bwbpf_init(
+    su_sos_filt_t *filt,
+    SUSCOUNT n,
+    SUFLOAT f1,
+    SUFLOAT f2);
+
+#ifdef __cplusplus
+#  ifdef __clang__
+#    pragma clang diagnostic pop
+#  endif // __clang__
+}
+#endif /* __cplusplus */
+
+#endif /* _SIGUTILS_SOS_H */
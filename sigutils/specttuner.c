@@ -24,16 +24,17 @@
 #include <stdlib.h>
 #include "sampling.h"
 #include "taps.h"
+#include "tapcache.h"
 #include "specttuner.h"
 
 SUPRIVATE void
 su_specttuner_channel_destroy(su_specttuner_channel_t *channel)
 {
   if (channel->plan[SU_SPECTTUNER_STATE_EVEN] != NULL)
-    SU_FFTW(_destroy_plan) (channel->plan[SU_SPECTTUNER_STATE_EVEN]);
+    su_lib_destroy_plan(channel->plan[SU_SPECTTUNER_STATE_EVEN]);
 
   if (channel->plan[SU_SPECTTUNER_STATE_ODD] != NULL)
-    SU_FFTW(_destroy_plan) (channel->plan[SU_SPECTTUNER_STATE_ODD]);
+    su_lib_destroy_plan(channel->plan[SU_SPECTTUNER_STATE_ODD]);
 
   if (channel->ifft[SU_SPECTTUNER_STATE_EVEN] != NULL)
     SU_FFTW(_free) (channel->ifft[SU_SPECTTUNER_STATE_EVEN]);
@@ -47,94 +48,126 @@ su_specttuner_channel_destroy(su_specttuner_channel_t *channel)
   if (channel->window != NULL)
     SU_FFTW(_free) (channel->window);
 
-  if (channel->forward != NULL)
-    SU_FFTW(_destroy_plan) (channel->forward);
-
-  if (channel->backward != NULL)
-    SU_FFTW(_destroy_plan) (channel->backward);
-
   if (channel->h != NULL)
-    SU_FFTW(_free) (channel->h);
+    su_tapcache_release(channel->h);
 
   free(channel);
 }
 
-SUPRIVATE void
-su_specttuner_update_channel_filter(
-    const su_specttuner_t *owner,
-    su_specttuner_channel_t *channel)
+/*
+ * The filter response only depends on the window size, the channel width
+ * and the scaling factor. Channels with the same parameters share it
+ * through the tap cache.
+ */
+SUPRIVATE SUBOOL
+su_specttuner_design_channel_filter(void *taps, const su_tapcache_key_t *key)
 {
+  SU_FFTW(_complex) *h = NULL;
+  SU_FFTW(_plan) forward = NULL;
+  SU_FFTW(_plan) backward = NULL;
   SUCOMPLEX tmp;
-  unsigned int window_size = owner->params.window_size;
+  unsigned int window_size = key->size / sizeof(SUCOMPLEX);
   unsigned int window_half = window_size / 2;
+  unsigned int halfw = key->params[0];
+  SUFLOAT k = key->params[1];
   unsigned int i;
+  SUBOOL ok = SU_FALSE;
+
+  SU_TRYCATCH(
+      h = SU_FFTW(_malloc)(window_size * sizeof(SU_FFTW(_complex))),
+      goto done);
+
+  SU_TRYCATCH(
+      forward = su_lib_plan_dft_1d(
+          window_size,
+          h,
+          h,
+          FFTW_FORWARD,
+          FFTW_ESTIMATE),
+      goto done);
+
+  SU_TRYCATCH(
+      backward = su_lib_plan_dft_1d(
+          window_size,
+          h,
+          h,
+          FFTW_BACKWARD,
+          FFTW_ESTIMATE),
+      goto done);
 
   /* First step: Setup ideal filter response */
-  memset(channel->h, 0, sizeof(SUCOMPLEX) * window_size);
+  memset(h, 0, sizeof(SUCOMPLEX) * window_size);
 
-  for (i = 0; i < channel->halfw; ++i) {
-    channel->h[i] = 1;
-    channel->h[window_size - i - 1] = 1;
+  for (i = 0; i < halfw; ++i) {
+    h[i] = 1;
+    h[window_size - i - 1] = 1;
   }
 
   /* Second step: switch to time domain */
-  SU_FFTW(_execute) (channel->backward);
+  SU_FFTW(_execute) (backward);
 
   /* Third step: recenter coefficients to apply window function */
   for (i = 0; i < window_half; ++i) {
-    tmp = channel->h[i];
-    channel->h[i] = channel->k * channel->h[window_half + i];
-    channel->h[window_half + i] = channel->k * tmp;
+    tmp = h[i];
+    h[i] = k * h[window_half + i];
+    h[window_half + i] = k * tmp;
   }
 
   /* Fourth step: apply Window function */
-  su_taps_apply_blackmann_harris_complex(channel->h, window_size);
+  su_taps_apply_blackmann_harris_complex(h, window_size);
 
   /* Fifth step: recenter back */
   for (i = 0; i < window_half; ++i) {
-    tmp = channel->h[i];
-    channel->h[i] = channel->h[window_half + i];
-    channel->h[window_half + i] = tmp;
+    tmp = h[i];
+    h[i] = h[window_half + i];
+    h[window_half + i] = tmp;
   }
 
   /* Sixth step: move back to frequency domain */
-  SU_FFTW(_execute) (channel->forward);
+  SU_FFTW(_execute) (forward);
+
+  memcpy(taps, h, sizeof(SUCOMPLEX) * window_size);
+
+  ok = SU_TRUE;
+
+done:
+  if (forward != NULL)
+    su_lib_destroy_plan(forward);
+
+  if (backward != NULL)
+    su_lib_destroy_plan(backward);
+
+  if (h != NULL)
+    SU_FFTW(_free) (h);
+
+  return ok;
 }
 
 SUPRIVATE SUBOOL
-su_specttuner_init_filter_response(
+su_specttuner_update_channel_filter(
     const su_specttuner_t *owner,
     su_specttuner_channel_t *channel)
 {
-  SUBOOL ok = SU_FALSE;
-  unsigned int window_size = owner->params.window_size;
+  su_tapcache_key_t key;
+  const SUCOMPLEX *h;
 
-  /* Backward plan */
-  SU_TRYCATCH(
-      channel->forward = SU_FFTW(_plan_dft_1d)(
-          window_size,
-          channel->h,
-          channel->h,
-          FFTW_FORWARD,
-          FFTW_ESTIMATE),
-      goto done);
+  memset(&key, 0, sizeof(su_tapcache_key_t));
+
+  key.design    = SU_TAPCACHE_DESIGN_SPECTTUNER;
+  key.size      = owner->params.window_size * sizeof(SUCOMPLEX);
+  key.params[0] = channel->halfw;
+  key.params[1] = channel->k;
 
-  /* Forward plan */
   SU_TRYCATCH(
-      channel->backward = SU_FFTW(_plan_dft_1d)(
-          window_size,
-          channel->h,
-          channel->h,
-          FFTW_BACKWARD,
-          FFTW_ESTIMATE),
-      goto done);
+      h = su_tapcache_acquire(&key, su_specttuner_design_channel_filter),
+      return SU_FALSE);
 
-  su_specttuner_update_channel_filter(owner, channel);
+  if (channel->h != NULL)
+    su_tapcache_release(channel->h);
 
-  ok = SU_TRUE;
-done:
+  channel->h = h;
 
-  return ok;
+  return SU_TRUE;
 }
 
 void
@@ -144,7 +177,6 @@ su_specttuner_set_channel_freq(
     SUFLOAT f0)
 {
   unsigned int window_size = st->params.window_size;
-  su_ncqo_t lo = su_ncqo_INITIALIZER;
   SUFLOAT off;
 
   channel->params.f0 = f0;
@@ -158,7 +190,7 @@ su_specttuner_set_channel_freq(
   if (channel->params.precise) {
     off = channel->center * (2 * PI) / (SUFLOAT) window_size - f0;
     off *= channel->decimation;
-    su_ncqo_init_fixed(&channel->lo, SU_ANG2NORM_FREQ(off));
+    su_lut_ncqo_init(&channel->lo, SU_ANG2NORM_FREQ(off));
   }
 }
 
@@ -171,6 +203,7 @@ su_specttuner_set_channel_bandwidth(
   SUFLOAT k;
   unsigned int min_size;
   unsigned int width;
+  unsigned int old_width;
 
   unsigned int window_size = st->params.window_size;
 
@@ -192,10 +225,16 @@ su_specttuner_set_channel_bandwidth(
   SU_TRYCATCH(width <= channel->size, return SU_FALSE);
   SU_TRYCATCH(width > 1, return SU_FALSE);
 
+  old_width = channel->width;
+
   channel->width  = width;
   channel->halfw  = channel->width >> 1;
 
-  su_specttuner_update_channel_filter(st, channel);
+  if (!su_specttuner_update_channel_filter(st, channel)) {
+    channel->width = old_width;
+    channel->halfw = channel->width >> 1;
+    return SU_FALSE;
+  }
 
   return SU_TRUE;
 }
@@ -281,7 +320,7 @@ su_specttuner_channel_new(
   if (params->precise) {
     off = new->center * (2 * PI) / (SUFLOAT) window_size - params->f0;
     off *= new->decimation;
-    su_ncqo_init_fixed(&new->lo, SU_ANG2NORM_FREQ(off));
+    su_lut_ncqo_init(&new->lo, SU_ANG2NORM_FREQ(off));
   }
 
   new->halfsz = new->size >> 1;
@@ -299,11 +338,7 @@ su_specttuner_channel_new(
       new->window = SU_FFTW(_malloc)(new->size * sizeof(SUFLOAT)),
       goto fail);
 
-  SU_TRYCATCH(
-      new->h     = SU_FFTW(_malloc)(window_size * sizeof(SU_FFTW(_complex))),
-      goto fail);
-
-  SU_TRYCATCH(su_specttuner_init_filter_response(owner, new), goto fail);
+  SU_TRYCATCH(su_specttuner_update_channel_filter(owner, new), goto fail);
 
   /*
    * Squared cosine window. Seems odd, right? Well, it turns out that
@@ -354,7 +389,7 @@ su_specttuner_channel_new(
 
   SU_TRYCATCH(
       new->plan[SU_SPECTTUNER_STATE_EVEN] =
-          SU_FFTW(_plan_dft_1d)(
+          su_lib_plan_dft_1d(
               new->size,
               new->fft,
               new->ifft[SU_SPECTTUNER_STATE_EVEN],
@@ -364,7 +399,7 @@ su_specttuner_channel_new(
 
   SU_TRYCATCH(
       new->plan[SU_SPECTTUNER_STATE_ODD] =
-          SU_FFTW(_plan_dft_1d)(
+          su_lib_plan_dft_1d(
               new->size,
               new->fft,
               new->ifft[SU_SPECTTUNER_STATE_ODD],
@@ -394,10 +429,10 @@ su_specttuner_destroy(su_specttuner_t *st)
     free(st->channel_list);
 
   if (st->plans[SU_SPECTTUNER_STATE_EVEN] != NULL)
-    SU_FFTW(_destroy_plan) (st->plans[SU_SPECTTUNER_STATE_EVEN]);
+    su_lib_destroy_plan(st->plans[SU_SPECTTUNER_STATE_EVEN]);
 
   if (st->plans[SU_SPECTTUNER_STATE_ODD] != NULL)
-    SU_FFTW(_destroy_plan) (st->plans[SU_SPECTTUNER_STATE_ODD]);
+    su_lib_destroy_plan(st->plans[SU_SPECTTUNER_STATE_ODD]);
 
   if (st->fft != NULL)
     SU_FFTW(_free) (st->fft);
@@ -435,7 +470,7 @@ su_specttuner_new(const struct sigutils_specttuner_params *params)
 
   /* Even plan starts at the beginning of the window */
   SU_TRYCATCH(
-      new->plans[SU_SPECTTUNER_STATE_EVEN] = SU_FFTW(_plan_dft_1d)(
+      new->plans[SU_SPECTTUNER_STATE_EVEN] = su_lib_plan_dft_1d(
           params->window_size,
           new->window,
           new->fft,
@@ -445,7 +480,7 @@ su_specttuner_new(const struct sigutils_specttuner_params *params)
 
   /* Odd plan stars at window_size / 2 */
   SU_TRYCATCH(
-      new->plans[SU_SPECTTUNER_STATE_ODD] = SU_FFTW(_plan_dft_1d)(
+      new->plans[SU_SPECTTUNER_STATE_ODD] = su_lib_plan_dft_1d(
           params->window_size,
           new->window + new->half_size,
           new->fft,
@@ -527,7 +562,6 @@ __su_specttuner_feed_channel(
   int len;
   int window_size = st->params.window_size;
   unsigned int i;
-  SUCOMPLEX phase;
   SUFLOAT alpha, beta;
   SUCOMPLEX *prev, *curr;
 
@@ -591,24 +625,16 @@ __su_specttuner_feed_channel(
   prev = channel->ifft[!channel->state] + channel->halfsz;
 
   /* Glue buffers */
-  if (channel->params.precise) {
-    for (i = 0; i < channel->halfsz; ++i) {
-      alpha = channel->window[i]; /* Positive slope */
-      beta  = channel->window[i + channel->halfsz]; /* Negative slope */
-
-      phase = su_ncqo_read(&channel->lo);
-
-      curr[i] = channel->gain * phase * (alpha * curr[i] + beta * prev[i]);
-    }
-  } else {
-    for (i = 0; i < channel->halfsz; ++i) {
-      alpha = channel->window[i]; /* Positive slope */
-      beta  = channel->window[i + channel->halfsz]; /* Negative slope */
+  for (i = 0; i < channel->halfsz; ++i) {
+    alpha = channel->window[i]; /* Positive slope */
+    beta  = channel->window[i + channel->halfsz]; /* Negative slope */
 
-      curr[i] = channel->gain * (alpha * curr[i] + beta * prev[i]);
-    }
+    curr[i] = channel->gain * (alpha * curr[i] + beta * prev[i]);
   }
 
+  if (channel->params.precise)
+    su_lut_ncqo_mix_bulk(&channel->lo, curr, curr, channel->halfsz);
+
   channel->state = !channel->state;
 
   /************************** Call user callback *****************************/
@@ -69,7 +69,7 @@ struct sigutils_specttuner_channel {
   SUFLOAT k;           /* Scaling factor */
   SUFLOAT gain;        /* Channel gain */
   SUFLOAT decimation;  /* Equivalent decimation */
-  su_ncqo_t lo;        /* Local oscilator to correct imprecise centering */
+  su_lut_ncqo_t lo;    /* Local oscilator to correct imprecise centering */
   unsigned int center; /* FFT center bin */
   unsigned int size;   /* FFT bins to allocate */
   unsigned int width;  /* FFT bins to copy (for guard bands, etc) */
@@ -83,10 +83,8 @@ struct sigutils_specttuner_channel {
    */
   enum sigutils_specttuner_state state;
   SU_FFTW(_complex) *fft;      /* Filtered spectrum */
-  SU_FFTW(_complex) *h;        /* Frequency response of filter */
+  const SUCOMPLEX   *h;        /* Frequency response of filter (cached) */
   SU_FFTW(_plan)     plan[2];  /* Even & Odd plans */
-  SU_FFTW(_plan)     forward;  /* Filter response forward plan */
-  SU_FFTW(_plan)     backward; /* Filter response backward plan */
 
   SU_FFTW(_complex) *ifft[2];  /* Even & Odd time-domain signal */
   SUFLOAT           *window;   /* Window function */
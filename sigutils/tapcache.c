@@ -0,0 +1,340 @@
+/*
+
+  Copyright (C) 2016 Gonzalo José Carracedo Carballal
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, version 3.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this program.  If not, see
+  <http://www.gnu.org/licenses/>
+
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define SU_LOG_DOMAIN "tapcache"
+
+#include "log.h"
+#include "taps.h"
+#include "coef.h"
+#include "tapcache.h"
+
+#define SU_TAPCACHE_BUCKETS 64
+
+/*
+ * Taps are stored right after the entry. The dummy complex member keeps
+ * them aligned for any tap type.
+ */
+struct sigutils_tapcache_entry {
+  struct sigutils_tapcache_entry *next;
+  su_tapcache_key_t key;
+  unsigned int refs;
+  SUCOMPLEX align;
+};
+
+SUPRIVATE pthread_mutex_t g_tapcache_mutex = PTHREAD_MUTEX_INITIALIZER;
+SUPRIVATE struct sigutils_tapcache_entry *g_tapcache[SU_TAPCACHE_BUCKETS];
+
+SUPRIVATE unsigned int
+su_tapcache_key_hash(const su_tapcache_key_t *key)
+{
+  const unsigned char *bytes = (const unsigned char *) key->params;
+  unsigned int hash = 2166136261u;
+  unsigned int i;
+
+  hash = (hash ^ key->design) * 16777619u;
+  hash = (hash ^ (unsigned int) key->size) * 16777619u;
+
+  for (i = 0; i < sizeof (key->params); ++i)
+    hash = (hash ^ bytes[i]) * 16777619u;
+
+  return hash % SU_TAPCACHE_BUCKETS;
+}
+
+SUINLINE SUBOOL
+su_tapcache_key_equals(const su_tapcache_key_t *a, const su_tapcache_key_t *b)
+{
+  return a->design == b->design
+      && a->size == b->size
+      && memcmp(a->params, b->params, sizeof (a->params)) == 0;
+}
+
+const void *
+su_tapcache_acquire(
+    const su_tapcache_key_t *key,
+    su_tapcache_design_func_t design)
+{
+  struct sigutils_tapcache_entry *entry;
+  unsigned int hash = su_tapcache_key_hash(key);
+  const void *taps = NULL;
+
+  SU_TRYCATCH(pthread_mutex_lock(&g_tapcache_mutex) == 0, return NULL);
+
+  for (entry = g_tapcache[hash]; entry != NULL; entry = entry->next)
+    if (su_tapcache_key_equals(&entry->key, key))
+      break;
+
+  if (entry == NULL) {
+    SU_TRYCATCH(
+        entry = malloc(sizeof (struct sigutils_tapcache_entry) + key->size),
+        goto done);
+
+    entry->key  = *key;
+    entry->refs = 0;
+
+    if (!(design) (entry + 1, key)) {
+      SU_ERROR("Filter design failed\n");
+      free(entry);
+      goto done;
+    }
+
+    entry->next = g_tapcache[hash];
+    g_tapcache[hash] = entry;
+  }
+
+  ++entry->refs;
+  taps = entry + 1;
+
+done:
+  (void) pthread_mutex_unlock(&g_tapcache_mutex);
+
+  return taps;
+}
+
+void
+su_tapcache_release(const void *taps)
+{
+  struct sigutils_tapcache_entry *entry;
+  struct sigutils_tapcache_entry **prev;
+
+  if (taps == NULL)
+    return;
+
+  entry = (struct sigutils_tapcache_entry *) taps - 1;
+
+  if (pthread_mutex_lock(&g_tapcache_mutex) != 0) {
+    SU_ERROR("Failed to lock tap cache, taps leaked\n");
+    return;
+  }
+
+  if (--entry->refs == 0) {
+    prev = g_tapcache + su_tapcache_key_hash(&entry->key);
+    while (*prev != entry)
+      prev = &(*prev)->next;
+
+    *prev = entry->next;
+    free(entry);
+  }
+
+  (void) pthread_mutex_unlock(&g_tapcache_mutex);
+}
+
+/***************************** Builtin designs *******************************/
+#define SU_TAPCACHE_FLOAT_COUNT(key) ((key)->size / sizeof (SUFLOAT))
+
+SUPRIVATE SUBOOL
+su_tapcache_design_rrc(void *taps, const su_tapcache_key_t *key)
+{
+  su_taps_rrc_init(
+      taps,
+      key->params[0],
+      key->params[1],
+      SU_TAPCACHE_FLOAT_COUNT(key));
+
+  return SU_TRUE;
+}
+
+SUPRIVATE SUBOOL
+su_tapcache_design_hilbert(void *taps, const su_tapcache_key_t *key)
+{
+  su_taps_hilbert_init(taps, SU_TAPCACHE_FLOAT_COUNT(key));
+
+  return SU_TRUE;
+}
+
+SUPRIVATE SUBOOL
+su_tapcache_design_brickwall_lp(void *taps, const su_tapcache_key_t *key)
+{
+  su_taps_brickwall_lp_init(taps, key->params[0], SU_TAPCACHE_FLOAT_COUNT(key));
+
+  return SU_TRUE;
+}
+
+SUPRIVATE SUBOOL
+su_tapcache_design_brickwall_bp(void *taps, const su_tapcache_key_t *key)
+{
+  su_taps_brickwall_bp_init(
+      taps,
+      key->params[0],
+      key->params[1],
+      SU_TAPCACHE_FLOAT_COUNT(key));
+
+  return SU_TRUE;
+}
+
+/* params[0] is the order, params[1] and params[2] the cutoff frequencies */
+SUPRIVATE SUBOOL
+su_tapcache_design_butterworth(void *taps, const su_tapcache_key_t *key)
+{
+  SUFLOAT *coef = (SUFLOAT *) taps;
+  SUFLOAT *a = NULL;
+  SUFLOAT *b = NULL;
+  SUFLOAT scaling;
+  int n = key->params[0];
+  SUSCOUNT size = SU_TAPCACHE_FLOAT_COUNT(key) / 2;
+  int i;
+  SUBOOL ok = SU_FALSE;
+
+  switch (key->design) {
+    case SU_TAPCACHE_DESIGN_BWLPF:
+      SU_TRYCATCH(a = su_dcof_bwlp(n, key->params[1]), goto done);
+      SU_TRYCATCH(b = su_ccof_bwlp(n), goto done);
+      scaling = su_sf_bwlp(n, key->params[1]);
+      break;
+
+    case SU_TAPCACHE_DESIGN_BWHPF:
+      SU_TRYCATCH(a = su_dcof_bwhp(n, key->params[1]), goto done);
+      SU_TRYCATCH(b = su_ccof_bwhp(n), goto done);
+      scaling = su_sf_bwhp(n, key->params[1]);
+      break;
+
+    case SU_TAPCACHE_DESIGN_BWBPF:
+      SU_TRYCATCH(a = su_dcof_bwbp(n, key->params[1], key->params[2]), goto done);
+      SU_TRYCATCH(b = su_ccof_bwbp(n), goto done);
+      scaling = su_sf_bwbp(n, key->params[1], key->params[2]);
+      break;
+
+    default:
+      goto done;
+  }
+
+  /* Scaling is applied to the first n + 1 numerator coefficients only */
+  for (i = 0; i < n + 1; ++i)
+    b[i] *= scaling;
+
+  memcpy(coef, a, size * sizeof (SUFLOAT));
+  memcpy(coef + size, b, size * sizeof (SUFLOAT));
+
+  ok = SU_TRUE;
+
+done:
+  if (a != NULL)
+    free(a);
+
+  if (b != NULL)
+    free(b);
+
+  return ok;
+}
+
+const SUFLOAT *
+su_tapcache_rrc(SUFLOAT T, SUFLOAT beta, SUSCOUNT size)
+{
+  su_tapcache_key_t key;
+
+  memset(&key, 0, sizeof (su_tapcache_key_t));
+
+  key.design    = SU_TAPCACHE_DESIGN_RRC;
+  key.size      = size * sizeof (SUFLOAT);
+  key.params[0] = T;
+  key.params[1] = beta;
+
+  return su_tapcache_acquire(&key, su_tapcache_design_rrc);
+}
+
+const SUFLOAT *
+su_tapcache_hilbert(SUSCOUNT size)
+{
+  su_tapcache_key_t key;
+
+  memset(&key, 0, sizeof (su_tapcache_key_t));
+
+  key.design = SU_TAPCACHE_DESIGN_HILBERT;
+  key.size   = size * sizeof (SUFLOAT);
+
+  return su_tapcache_acquire(&key, su_tapcache_design_hilbert);
+}
+
+const SUFLOAT *
+su_tapcache_brickwall_lp(SUFLOAT fc, SUSCOUNT size)
+{
+  su_tapcache_key_t key;
+
+  memset(&key, 0, sizeof (su_tapcache_key_t));
+
+  key.design    = SU_TAPCACHE_DESIGN_BRICKWALL_LP;
+  key.size      = size * sizeof (SUFLOAT);
+  key.params[0] = fc;
+
+  return su_tapcache_acquire(&key, su_tapcache_design_brickwall_lp);
+}
+
+const SUFLOAT *
+su_tapcache_brickwall_bp(SUFLOAT bw, SUFLOAT if_nor, SUSCOUNT size)
+{
+  su_tapcache_key_t key;
+
+  memset(&key, 0, sizeof (su_tapcache_key_t));
+
+  key.design    = SU_TAPCACHE_DESIGN_BRICKWALL_BP;
+  key.size      = size * sizeof (SUFLOAT);
+  key.params[0] = bw;
+  key.params[1] = if_nor;
+
+  return su_tapcache_acquire(&key, su_tapcache_design_brickwall_bp);
+}
+
+const SUFLOAT *
+su_tapcache_bwlpf(SUSCOUNT n, SUFLOAT fc)
+{
+  su_tapcache_key_t key;
+
+  memset(&key, 0, sizeof (su_tapcache_key_t));
+
+  key.design    = SU_TAPCACHE_DESIGN_BWLPF;
+  key.size      = 2 * (n + 1) * sizeof (SUFLOAT);
+  key.params[0] = n;
+  key.params[1] = fc;
+
+  return su_tapcache_acquire(&key, su_tapcache_design_butterworth);
+}
+
+const SUFLOAT *
+su_tapcache_bwhpf(SUSCOUNT n, SUFLOAT fc)
+{
+  su_tapcache_key_t key;
+
+  memset(&key, 0, sizeof (su_tapcache_key_t));
+
+  key.design    = SU_TAPCACHE_DESIGN_BWHPF;
+  key.size      = 2 * (n + 1) * sizeof (SUFLOAT);
+  key.params[0] = n;
+  key.params[1] = fc;
+
+  return su_tapcache_acquire(&key, su_tapcache_design_butterworth);
+}
+
+const SUFLOAT *
+su_tapcache_bwbpf(SUSCOUNT n, SUFLOAT f1, SUFLOAT f2)
+{
+  su_tapcache_key_t key;
+
+  memset(&key, 0, sizeof (su_tapcache_key_t));
+
+  key.design    = SU_TAPCACHE_DESIGN_BWBPF;
+  key.size      = 2 * (2 * n + 1) * sizeof (SUFLOAT);
+  key.params[0] = n;
+  key.params[1] = f1;
+  key.params[2] = f2;
+
+  return su_tapcache_acquire(&key, su_tapcache_design_butterworth);
+}
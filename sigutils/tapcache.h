@@ -0,0 +1,99 @@
+/*
+
+  Copyright (C) 2016 Gonzalo José Carracedo Carballal
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, version 3.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this program.  If not, see
+  <http://www.gnu.org/licenses/>
+
+*/
+
+#ifndef _SIGUTILS_TAPCACHE_H
+#define _SIGUTILS_TAPCACHE_H
+
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * Process-wide cache of filter designs. Filters with the same design
+ * parameters share the same, read-only, tap array. Every successful
+ * acquire must be paired with a su_tapcache_release, and the array is
+ * freed when its last user releases it. All functions are thread safe.
+ */
+
+#define SU_TAPCACHE_MAX_PARAMS 3
+
+enum sigutils_tapcache_design {
+  SU_TAPCACHE_DESIGN_RRC,
+  SU_TAPCACHE_DESIGN_HILBERT,
+  SU_TAPCACHE_DESIGN_BRICKWALL_LP,
+  SU_TAPCACHE_DESIGN_BRICKWALL_BP,
+  SU_TAPCACHE_DESIGN_BWLPF,
+  SU_TAPCACHE_DESIGN_BWHPF,
+  SU_TAPCACHE_DESIGN_BWBPF,
+  SU_TAPCACHE_DESIGN_SPECTTUNER
+};
+
+struct sigutils_tapcache_key {
+  enum sigutils_tapcache_design design;
+  SUSCOUNT size; /* Bytes */
+  SUFLOAT params[SU_TAPCACHE_MAX_PARAMS]; /* Unused params must be 0 */
+};
+
+typedef struct sigutils_tapcache_key su_tapcache_key_t;
+
+/* Fill key->size bytes of taps according to key. Called with the cache locked */
+typedef SUBOOL (*su_tapcache_design_func_t) (
+    void *taps,
+    const su_tapcache_key_t *key);
+
+/*
+ * Return the taps of key, calling design to compute them if they are not
+ * in the cache yet. NULL on failure.
+ */
+const void *su_tapcache_acquire(
+    const su_tapcache_key_t *key,
+    su_tapcache_design_func_t design);
+
+void su_tapcache_release(const void *taps);
+
+/* Cached versions of the su_taps_* designers, with the same arguments */
+const SUFLOAT *su_tapcache_rrc(SUFLOAT T, SUFLOAT beta, SUSCOUNT size);
+
+const SUFLOAT *su_tapcache_hilbert(SUSCOUNT size);
+
+const SUFLOAT *su_tapcache_brickwall_lp(SUFLOAT fc, SUSCOUNT size);
+
+const SUFLOAT *su_tapcache_brickwall_bp(
+    SUFLOAT bw,
+    SUFLOAT if_nor,
+    SUSCOUNT size);
+
+/*
+ * Butterworth filters of order n, as in su_iir_bw*_init. Denominator
+ * coefficients go first, followed by the scaled numerator coefficients
+ * (n + 1 of each, or 2 * n + 1 for band pass filters).
+ */
+const SUFLOAT *su_tapcache_bwlpf(SUSCOUNT n, SUFLOAT fc);
+
+const SUFLOAT *su_tapcache_bwhpf(SUSCOUNT n, SUFLOAT fc);
+
+const SUFLOAT *su_tapcache_bwbpf(SUSCOUNT n, SUFLOAT f1, SUFLOAT f2);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _SIGUTILS_TAPCACHE_H */
@@ -44,7 +44,7 @@ su_pulse_finder_new(
     coef[i] = peak - base;
 
   SU_TRYCATCH(
-      su_iir_filt_init(
+      su_iir_rfilt_init(
           &new->corr,
           0,    /* y_size */
           NULL, /* y_coef */
@@ -82,7 +82,7 @@ su_pulse_finder_feed(su_pulse_finder_t *self, SUFLOAT x)
 
   x -= self->base;
 
-  y = SU_C_REAL(su_iir_filt_feed(&self->corr, x));
+  y = su_iir_rfilt_feed(&self->corr, x);
 
 
   match = y > self->peak_thr;
@@ -119,7 +119,7 @@ su_pulse_finder_get_pos(const su_pulse_finder_t *self)
 void
 su_pulse_finder_destroy(su_pulse_finder_t *self)
 {
-  su_iir_filt_finalize(&self->corr);
+  su_iir_rfilt_finalize(&self->corr);
 
   free(self);
 }
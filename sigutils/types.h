@@ -86,6 +86,28 @@
 #  define SUINLINE   static inline
 #endif /* __cplusplus */
 
+/*
+ * Atomic accessors, used by the lock-free (single producer, single consumer)
+ * paths. Stores have release semantics and loads have acquire semantics.
+ * SU_ATOMIC_ADD returns the updated value, and SU_ATOMIC_CAS returns
+ * whether the swap took place.
+ */
+#ifdef __GNUC__
+#  define SU_ATOMIC_LOAD(ptr)       __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#  define SU_ATOMIC_STORE(ptr, val) __atomic_store_n(ptr, val, __ATOMIC_RELEASE)
+#  define SU_ATOMIC_FENCE()         __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#  define SU_ATOMIC_ADD(ptr, val)   __atomic_add_fetch(ptr, val, __ATOMIC_SEQ_CST)
+#  define SU_ATOMIC_CAS(ptr, old, new)                  \
+  __sync_bool_compare_and_swap(ptr, old, new)
+#else
+#  define SU_ATOMIC_LOAD(ptr)       (*(ptr))
+#  define SU_ATOMIC_STORE(ptr, val) (*(ptr) = (val))
+#  define SU_ATOMIC_FENCE()
+#  define SU_ATOMIC_ADD(ptr, val)   (*(ptr) += (val))
+#  define SU_ATOMIC_CAS(ptr, old, new)                  \
+  (*(ptr) == (old) ? (*(ptr) = (new), 1) : 0)
+#endif /* __GNUC__ */
+
 /* Perform casts in C and C++ */
 #ifdef __cplusplus
 #  define SUCAST(type, value) static_cast<type>(value)
@@ -199,6 +221,27 @@
 /* Required for the map from sigutils types to FFTW3 types */
 #define SU_FFTW(method) JOIN(SU_SOURCE_FFTW_PREFIX, method)
 
+/*
+ * FFTW's planner is not thread safe. Plans must be created and destroyed
+ * through these, which serialize all planner calls of the library (lib.c)
+ */
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+SU_FFTW(_plan) su_lib_plan_dft_1d(
+    int size,
+    SU_FFTW(_complex) *in,
+    SU_FFTW(_complex) *out,
+    int sign,
+    unsigned int flags);
+
+void su_lib_destroy_plan(SU_FFTW(_plan) plan);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
 /* Symbol manipulation */
 #define SU_FROMSYM(x) ((x) - '0')
 #define SU_TOSYM(x)   ((x) + '0')
@@ -23,7 +23,18 @@
 
 SUPRIVATE su_test_entry_t test_list[] = {
     SU_TEST_ENTRY(su_test_ncqo),
+    SU_TEST_ENTRY(su_test_ncqo_phasor),
+    SU_TEST_ENTRY(su_test_ncqo_bulk),
+    SU_TEST_ENTRY(su_test_ncqo_lut),
+    SU_TEST_ENTRY(su_test_ncqo_fixed_point),
     SU_TEST_ENTRY(su_test_butterworth_lpf),
+    SU_TEST_ENTRY(su_test_fir_overlap_save),
+    SU_TEST_ENTRY(su_test_fir_decim),
+    SU_TEST_ENTRY(su_test_cic_halfband),
+    SU_TEST_ENTRY(su_test_resampler),
+    SU_TEST_ENTRY(su_test_sos),
+    SU_TEST_ENTRY(su_test_rfilt),
+    SU_TEST_ENTRY(su_test_tapcache),
     SU_TEST_ENTRY(su_test_agc_transient),
     SU_TEST_ENTRY(su_test_agc_steady_rising),
     SU_TEST_ENTRY(su_test_agc_steady_falling),
@@ -31,6 +42,17 @@ SUPRIVATE su_test_entry_t test_list[] = {
     SU_TEST_ENTRY(su_test_block),
     SU_TEST_ENTRY(su_test_block_plugging),
     SU_TEST_ENTRY(su_test_block_flow_control),
+    SU_TEST_ENTRY(su_test_block_flow_control_spsc),
+    SU_TEST_ENTRY(su_test_block_flow_control_broadcast),
+    SU_TEST_ENTRY(su_test_block_shared_peek),
+    SU_TEST_ENTRY(su_test_block_mirrored_stream),
+    SU_TEST_ENTRY(su_test_block_pipeline),
+    SU_TEST_ENTRY(su_test_block_executor),
+    SU_TEST_ENTRY(su_test_block_executor_progress),
+    SU_TEST_ENTRY(su_test_block_fusion),
+    SU_TEST_ENTRY(su_test_block_stats),
+    SU_TEST_ENTRY(su_test_block_stream_resize),
+    SU_TEST_ENTRY(su_test_block_push),
     SU_TEST_ENTRY(su_test_tuner),
     SU_TEST_ENTRY(su_test_costas_lock),
     SU_TEST_ENTRY(su_test_costas_bpsk),
@@ -41,6 +63,7 @@ SUPRIVATE su_test_entry_t test_list[] = {
     SU_TEST_ENTRY(su_test_rrc_block_with_if),
     SU_TEST_ENTRY(su_test_clock_recovery),
     SU_TEST_ENTRY(su_test_clock_recovery_noisy),
+    SU_TEST_ENTRY(su_test_farrow),
     SU_TEST_ENTRY(su_test_cdr_block),
     SU_TEST_ENTRY(su_test_channel_detector_qpsk),
     SU_TEST_ENTRY(su_test_channel_detector_qpsk_noisy),
@@ -20,12 +20,15 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include <sigutils/sampling.h>
 #include <sigutils/ncqo.h>
 #include <sigutils/iir.h>
 #include <sigutils/agc.h>
 #include <sigutils/pll.h>
+#include <sigutils/pipeline.h>
+#include <sigutils/executor.h>
 
 #include <sigutils/sigutils.h>
 
@@ -317,6 +320,1178 @@ done:
 }
 
 
+SUBOOL
+su_test_block_flow_control_broadcast(su_test_context_t *ctx)
+{
+  SUBOOL ok = SU_FALSE;
+  su_block_t *siggen_block = NULL;
+  su_block_port_t port_1 = su_block_port_INITIALIZER;
+  su_block_port_t port_2 = su_block_port_INITIALIZER;
+  SUCOMPLEX *readbuf_1 = NULL;
+  SUCOMPLEX *readbuf_2 = NULL;
+  pthread_t thread_1;
+  pthread_t thread_2;
+  SUBOOL thread_1_running = SU_FALSE;
+  SUBOOL thread_2_running = SU_FALSE;
+  struct su_test_block_flow_control_params thread_1_params;
+  struct su_test_block_flow_control_params thread_2_params;
+  SUSCOUNT i;
+
+  SU_TEST_START(ctx);
+
+  SU_TEST_ASSERT(readbuf_1  = su_test_ctx_getc(ctx, "thread1_buf"));
+  SU_TEST_ASSERT(readbuf_2  = su_test_ctx_getc(ctx, "thread2_buf"));
+
+  /* Casts are mandatory here */
+  siggen_block = su_block_new(
+      "siggen",
+      "sawtooth",
+      (SUFLOAT)  SU_TEST_BLOCK_SAWTOOTH_WIDTH,
+      (SUSCOUNT) SU_TEST_BLOCK_SAWTOOTH_WIDTH,
+      (SUSCOUNT) 0,
+      "null",
+      (SUFLOAT)  0,
+      (SUSCOUNT) 0,
+      (SUSCOUNT) 0);
+
+  SU_TEST_ASSERT(siggen_block != NULL);
+
+  SU_TEST_ASSERT(
+      su_block_set_flow_controller(
+          siggen_block,
+          0,
+          SU_FLOW_CONTROL_KIND_BROADCAST));
+
+  SU_TEST_ASSERT(su_block_port_plug(&port_1, siggen_block, 0));
+  SU_TEST_ASSERT(su_block_port_plug(&port_2, siggen_block, 0));
+
+  /* Threads sleep on alternate reads, so either may get ahead */
+  thread_1_params.ctx = ctx;
+  thread_1_params.port = &port_1;
+  thread_1_params.readbuf = readbuf_1;
+  thread_1_params.buffer_size = ctx->params->buffer_size;
+  thread_1_params.oddity = SU_FALSE;
+
+  thread_2_params = thread_1_params;
+  thread_2_params.port = &port_2;
+  thread_2_params.readbuf = readbuf_2;
+  thread_2_params.oddity = SU_TRUE;
+
+  SU_TEST_ASSERT(
+      pthread_create(
+          &thread_1,
+          NULL,
+          su_test_block_flow_control_reader_thread,
+          &thread_1_params) != -1);
+  thread_1_running = SU_TRUE;
+
+  SU_TEST_ASSERT(
+      pthread_create(
+          &thread_2,
+          NULL,
+          su_test_block_flow_control_reader_thread,
+          &thread_2_params) != -1);
+  thread_2_running = SU_TRUE;
+
+  pthread_join(thread_1, NULL);
+  thread_1_running = SU_FALSE;
+
+  pthread_join(thread_2, NULL);
+  thread_2_running = SU_FALSE;
+
+  SU_TEST_ASSERT(thread_1_params.ok);
+  SU_TEST_ASSERT(thread_2_params.ok);
+
+  /* Faster readers must wait for the slower ones, instead of losing samples */
+  SU_TEST_ASSERT(port_1.dropped == 0);
+  SU_TEST_ASSERT(port_2.dropped == 0);
+
+  for (i = 0; i < ctx->params->buffer_size; ++i)
+    SU_TEST_ASSERT(thread_1_params.readbuf[i] == thread_2_params.readbuf[i]);
+
+  ok = SU_TRUE;
+
+done:
+  SU_TEST_END(ctx);
+
+  if (!thread_1_running && !thread_2_running) {
+    if (su_block_port_is_plugged(&port_1))
+      su_block_port_unplug(&port_1);
+
+    if (su_block_port_is_plugged(&port_2))
+      su_block_port_unplug(&port_2);
+
+    if (siggen_block != NULL)
+      su_block_destroy(siggen_block);
+  }
+
+  return ok;
+}
+
+SUBOOL
+su_test_block_flow_control_spsc(su_test_context_t *ctx)
+{
+  SUBOOL ok = SU_FALSE;
+  su_block_t *siggen_block_1 = NULL;
+  su_block_t *siggen_block_2 = NULL;
+  su_block_port_t port_1 = su_block_port_INITIALIZER;
+  su_block_port_t port_2 = su_block_port_INITIALIZER;
+  su_block_port_t port_3 = su_block_port_INITIALIZER;
+  SUCOMPLEX *readbuf_1 = NULL;
+  SUCOMPLEX *readbuf_2 = NULL;
+  SUSCOUNT p_1 = 0;
+  SUSCOUNT p_2 = 0;
+  SUSDIFF got;
+  SUSCOUNT i;
+
+  SU_TEST_START(ctx);
+
+  SU_TEST_ASSERT(readbuf_1  = su_test_ctx_getc(ctx, "spsc_buf"));
+  SU_TEST_ASSERT(readbuf_2  = su_test_ctx_getc(ctx, "none_buf"));
+
+  /* Casts are mandatory here */
+  siggen_block_1 = su_block_new(
+      "siggen",
+      "sawtooth",
+      (SUFLOAT)  SU_TEST_BLOCK_SAWTOOTH_WIDTH,
+      (SUSCOUNT) SU_TEST_BLOCK_SAWTOOTH_WIDTH,
+      (SUSCOUNT) 0,
+      "null",
+      (SUFLOAT)  0,
+      (SUSCOUNT) 0,
+      (SUSCOUNT) 0);
+  SU_TEST_ASSERT(siggen_block_1 != NULL);
+
+  siggen_block_2 = su_block_new(
+      "siggen",
+      "sawtooth",
+      (SUFLOAT)  SU_TEST_BLOCK_SAWTOOTH_WIDTH,
+      (SUSCOUNT) SU_TEST_BLOCK_SAWTOOTH_WIDTH,
+      (SUSCOUNT) 0,
+      "null",
+      (SUFLOAT)  0,
+      (SUSCOUNT) 0,
+      (SUSCOUNT) 0);
+  SU_TEST_ASSERT(siggen_block_2 != NULL);
+
+  SU_TEST_ASSERT(
+      su_block_set_flow_controller(
+          siggen_block_1,
+          0,
+          SU_FLOW_CONTROL_KIND_SPSC));
+
+  SU_TEST_ASSERT(su_block_port_plug(&port_1, siggen_block_1, 0));
+  SU_TEST_ASSERT(su_block_port_plug(&port_2, siggen_block_2, 0));
+
+  /* SPSC flow controllers must refuse a second consumer */
+  SU_TEST_ASSERT(!su_block_port_plug(&port_3, siggen_block_1, 0));
+
+  /* Read with different (prime) sizes to exercise buffer wraparound */
+  while (p_1 < ctx->params->buffer_size) {
+    got = su_block_port_read(
+        &port_1,
+        readbuf_1 + p_1,
+        SU_MIN(17, ctx->params->buffer_size - p_1));
+    SU_TEST_ASSERT(got > 0);
+    p_1 += got;
+  }
+
+  while (p_2 < ctx->params->buffer_size) {
+    got = su_block_port_read(
+        &port_2,
+        readbuf_2 + p_2,
+        SU_MIN(1031, ctx->params->buffer_size - p_2));
+    SU_TEST_ASSERT(got > 0);
+    p_2 += got;
+  }
+
+  /* Both flow controllers must deliver exactly the same samples */
+  for (i = 0; i < ctx->params->buffer_size; ++i)
+    SU_TEST_ASSERT(readbuf_1[i] == readbuf_2[i]);
+
+  ok = SU_TRUE;
+
+done:
+  SU_TEST_END(ctx);
+
+  if (su_block_port_is_plugged(&port_1))
+    su_block_port_unplug(&port_1);
+
+  if (su_block_port_is_plugged(&port_2))
+    su_block_port_unplug(&port_2);
+
+  if (su_block_port_is_plugged(&port_3))
+    su_block_port_unplug(&port_3);
+
+  if (siggen_block_1 != NULL)
+    su_block_destroy(siggen_block_1);
+
+  if (siggen_block_2 != NULL)
+    su_block_destroy(siggen_block_2);
+
+  return ok;
+}
+
+
+SUBOOL
+su_test_block_shared_peek(su_test_context_t *ctx)
+{
+  SUBOOL ok = SU_FALSE;
+  su_block_t *siggen_block = NULL;
+  su_block_port_t port_1 = su_block_port_INITIALIZER;
+  su_block_port_t port_2 = su_block_port_INITIALIZER;
+  SUCOMPLEX *readbuf = NULL;
+  SUCOMPLEX *copy = NULL;
+  const SUCOMPLEX *view;
+  SUSCOUNT stream_size;
+  SUSCOUNT p = 0;
+  SUSDIFF size;
+  SUSDIFF got;
+  SUSDIFF i;
+
+  SU_TEST_START(ctx);
+
+  SU_TEST_ASSERT(readbuf = su_test_ctx_getc(ctx, "buf"));
+
+  /* Casts are mandatory here */
+  SU_TEST_ASSERT(
+      siggen_block = su_block_new(
+          "siggen",
+          "sawtooth",
+          (SUFLOAT)  SU_TEST_BLOCK_SAWTOOTH_WIDTH,
+          (SUSCOUNT) SU_TEST_BLOCK_SAWTOOTH_WIDTH,
+          (SUSCOUNT) 0,
+          "null",
+          (SUFLOAT)  0,
+          (SUSCOUNT) 0,
+          (SUSCOUNT) 0));
+
+  /* No flow control: any of both ports may call acquire() */
+  SU_TEST_ASSERT(su_block_port_plug(&port_1, siggen_block, 0));
+  SU_TEST_ASSERT(su_block_port_plug(&port_2, siggen_block, 0));
+
+  stream_size = su_block_get_stream(siggen_block, 0)->size;
+  SU_TEST_ASSERT(ctx->params->buffer_size >= 2 * stream_size);
+  SU_TEST_ASSERT(copy = malloc(stream_size * sizeof (SUCOMPLEX)));
+
+  SU_TEST_ASSERT((size = su_block_port_peek(&port_1, &view, 17)) > 0);
+  memcpy(copy, view, size * sizeof (SUCOMPLEX));
+
+  /* The other port makes the stream wrap around a couple of times */
+  while (p < 2 * stream_size) {
+    got = su_block_port_read(&port_2, readbuf + p, 2 * stream_size - p);
+    SU_TEST_ASSERT(got > 0);
+    p += got;
+  }
+
+  /* Peeked samples must survive until consumed */
+  for (i = 0; i < size; ++i)
+    SU_TEST_ASSERT(view[i] == copy[i]);
+
+  SU_TEST_ASSERT(su_block_port_consume(&port_1, size));
+
+  ok = SU_TRUE;
+
+done:
+  SU_TEST_END(ctx);
+
+  su_block_port_unplug(&port_1);
+  su_block_port_unplug(&port_2);
+
+  if (siggen_block != NULL)
+    su_block_destroy(siggen_block);
+
+  if (copy != NULL)
+    free(copy);
+
+  return ok;
+}
+
+
+SUBOOL
+su_test_block_mirrored_stream(su_test_context_t *ctx)
+{
+  SUBOOL ok = SU_FALSE;
+  su_stream_t stream = su_stream_INITIALIZER;
+  SUCOMPLEX *buffer = NULL;
+  SUCOMPLEX *start;
+  const SUCOMPLEX *view;
+  SUSCOUNT size;
+  SUSCOUNT i;
+
+  SU_TEST_START(ctx);
+
+  if (!su_stream_init_mirrored(&stream, SU_BLOCK_STREAM_BUFFER_SIZE)) {
+    SU_INFO("Mirrored streams not supported, skipping test...\n");
+    ok = SU_TRUE;
+    goto done;
+  }
+
+  SU_TEST_ASSERT(stream.size >= SU_BLOCK_STREAM_BUFFER_SIZE);
+  SU_TEST_ASSERT(buffer = malloc(stream.size * sizeof (SUCOMPLEX)));
+
+  for (i = 0; i < stream.size; ++i)
+    buffer[i] = i;
+
+  /* Leave the buffer pointer in the middle of the stream */
+  su_stream_write(&stream, buffer, stream.size / 2 + 1);
+
+  /* The whole stream must be writable in one go */
+  size = su_stream_get_contiguous(&stream, &start, stream.size);
+  SU_TEST_ASSERT(size == stream.size);
+
+  for (i = 0; i < size; ++i)
+    start[i] = buffer[i];
+
+  SU_TEST_ASSERT(su_stream_advance_contiguous(&stream, size) == size);
+
+  /* Both copies must hold the same samples */
+  for (i = 0; i < stream.size; ++i)
+    SU_TEST_ASSERT(stream.buffer[i] == stream.buffer[i + stream.size]);
+
+  /* And the whole stream must be readable in one go */
+  size = su_stream_peek(
+      &stream,
+      su_stream_tell(&stream),
+      &view,
+      stream.size);
+  SU_TEST_ASSERT(size == stream.size);
+
+  for (i = 0; i < size; ++i)
+    SU_TEST_ASSERT(view[i] == buffer[i]);
+
+  ok = SU_TRUE;
+
+done:
+  SU_TEST_END(ctx);
+
+  su_stream_finalize(&stream);
+
+  if (buffer != NULL)
+    free(buffer);
+
+  return ok;
+}
+
+struct su_test_block_chain {
+  su_block_t *siggen_block;
+  su_block_t *agc_block;
+  su_block_t *rrc_block;
+  su_block_port_t port;
+};
+
+/*
+ * The RRC filter of the chain is long enough to be evaluated with FFT
+ * overlap-save, whose rounding depends on how samples are split in chunks.
+ * Outputs of different execution modes are equal up to that rounding.
+ */
+#define SU_TEST_BLOCK_CHAIN_TOLERANCE 1e-5
+
+SUPRIVATE SUBOOL
+su_test_block_chain_same(SUCOMPLEX a, SUCOMPLEX b)
+{
+  return SU_C_ABS(a - b) < SU_TEST_BLOCK_CHAIN_TOLERANCE;
+}
+
+SUPRIVATE void
+su_test_block_chain_finalize(struct su_test_block_chain *chain)
+{
+  if (su_block_port_is_plugged(&chain->port))
+    su_block_port_unplug(&chain->port);
+
+  if (chain->rrc_block != NULL)
+    su_block_destroy(chain->rrc_block);
+
+  if (chain->agc_block != NULL)
+    su_block_destroy(chain->agc_block);
+
+  if (chain->siggen_block != NULL)
+    su_block_destroy(chain->siggen_block);
+}
+
+SUPRIVATE SUBOOL
+su_test_block_chain_init(struct su_test_block_chain *chain)
+{
+  struct su_agc_params agc_params = su_agc_params_INITIALIZER;
+  su_block_port_t port = su_block_port_INITIALIZER;
+
+  memset(chain, 0, sizeof(struct su_test_block_chain));
+  chain->port = port;
+
+  agc_params.delay_line_size  = 10;
+  agc_params.mag_history_size = 10;
+  agc_params.fast_rise_t      = 2;
+  agc_params.fast_fall_t      = 4;
+
+  agc_params.slow_rise_t      = 20;
+  agc_params.slow_fall_t      = 40;
+
+  agc_params.threshold        = SU_DB(2e-2);
+
+  agc_params.hang_max         = 30;
+  agc_params.slope_factor     = 0;
+
+  /* Casts are mandatory here */
+  SU_TRYCATCH(
+      chain->siggen_block = su_block_new(
+          "siggen",
+          "sin",
+          (SUFLOAT)  1,
+          (SUSCOUNT) SU_TEST_BLOCK_SAWTOOTH_WIDTH,
+          (SUSCOUNT) 0,
+          "sawtooth",
+          (SUFLOAT)  1,
+          (SUSCOUNT) SU_TEST_BLOCK_SAWTOOTH_WIDTH,
+          (SUSCOUNT) 0),
+      goto fail);
+
+  SU_TRYCATCH(chain->agc_block = su_block_new("agc", &agc_params), goto fail);
+
+  SU_TRYCATCH(
+      chain->rrc_block = su_block_new(
+          "rrc",
+          (unsigned int) 100,
+          (double) 10,
+          (double) 0.25),
+      goto fail);
+
+  SU_TRYCATCH(
+      su_block_plug(chain->siggen_block, 0, 0, chain->agc_block),
+      goto fail);
+  SU_TRYCATCH(
+      su_block_plug(chain->agc_block, 0, 0, chain->rrc_block),
+      goto fail);
+  SU_TRYCATCH(su_block_port_plug(&chain->port, chain->rrc_block, 0), goto fail);
+
+  return SU_TRUE;
+
+fail:
+  su_test_block_chain_finalize(chain);
+
+  return SU_FALSE;
+}
+
+SUBOOL
+su_test_block_pipeline(su_test_context_t *ctx)
+{
+  SUBOOL ok = SU_FALSE;
+  struct su_test_block_chain sync_chain;
+  struct su_test_block_chain async_chain;
+  SUBOOL sync_chain_init = SU_FALSE;
+  SUBOOL async_chain_init = SU_FALSE;
+  su_pipeline_t *pipeline = NULL;
+  unsigned int cpu = 0;
+  su_block_port_t extra_port = su_block_port_INITIALIZER;
+  SUCOMPLEX *readbuf_1 = NULL;
+  SUCOMPLEX *readbuf_2 = NULL;
+  SUSCOUNT p_1 = 0;
+  SUSCOUNT p_2 = 0;
+  SUSDIFF got;
+  SUSCOUNT i;
+
+  SU_TEST_START(ctx);
+
+  SU_TEST_ASSERT(readbuf_1  = su_test_ctx_getc(ctx, "sync_buf"));
+  SU_TEST_ASSERT(readbuf_2  = su_test_ctx_getc(ctx, "async_buf"));
+
+  SU_TEST_ASSERT(sync_chain_init = su_test_block_chain_init(&sync_chain));
+  SU_TEST_ASSERT(async_chain_init = su_test_block_chain_init(&async_chain));
+
+  /* Run every block of the second chain in its own thread */
+  SU_TEST_ASSERT(pipeline = su_pipeline_new());
+  SU_TEST_ASSERT(su_pipeline_add_block(pipeline, async_chain.siggen_block));
+  SU_TEST_ASSERT(su_pipeline_add_block(pipeline, async_chain.agc_block));
+  SU_TEST_ASSERT(su_pipeline_add_block(pipeline, async_chain.rrc_block));
+
+  /* Going back to synchronous restores the original flow control */
+  SU_TEST_ASSERT(su_block_set_async(sync_chain.siggen_block, 0, SU_TRUE));
+  SU_TEST_ASSERT(su_block_set_async(sync_chain.siggen_block, 0, SU_FALSE));
+  SU_TEST_ASSERT(
+      sync_chain.siggen_block->out[0].kind == SU_FLOW_CONTROL_KIND_NONE);
+
+  /* Failed additions must leave both the pipeline and the block intact */
+  SU_TEST_ASSERT(!su_pipeline_add_block(pipeline, async_chain.rrc_block));
+  SU_TEST_ASSERT(su_block_port_plug(&extra_port, sync_chain.rrc_block, 0));
+  SU_TEST_ASSERT(!su_pipeline_add_block(pipeline, sync_chain.rrc_block));
+  SU_TEST_ASSERT(pipeline->worker_count == 3);
+  SU_TEST_ASSERT(!sync_chain.rrc_block->out[0].async);
+  su_block_port_unplug(&extra_port);
+
+  /* Pinned workers relocate their input streams before starting */
+  SU_TEST_ASSERT(
+      su_pipeline_set_affinity(pipeline, async_chain.agc_block, &cpu, 1));
+  SU_TEST_ASSERT(
+      su_pipeline_set_affinity(pipeline, async_chain.rrc_block, &cpu, 1));
+
+  SU_TEST_ASSERT(su_pipeline_start(pipeline));
+
+  while (p_1 < ctx->params->buffer_size) {
+    got = su_block_port_read(
+        &sync_chain.port,
+        readbuf_1 + p_1,
+        SU_MIN(17, ctx->params->buffer_size - p_1));
+    SU_TEST_ASSERT(got > 0);
+    p_1 += got;
+  }
+
+  while (p_2 < ctx->params->buffer_size) {
+    got = su_block_port_read(
+        &async_chain.port,
+        readbuf_2 + p_2,
+        SU_MIN(17, ctx->params->buffer_size - p_2));
+    SU_TEST_ASSERT(got > 0);
+    p_2 += got;
+  }
+
+  /* Threads must not change the results */
+  for (i = 0; i < ctx->params->buffer_size; ++i)
+    SU_TEST_ASSERT(su_test_block_chain_same(readbuf_1[i], readbuf_2[i]));
+
+  /* Stopping the pipeline must make readers return EOS */
+  su_pipeline_stop(pipeline);
+
+  do
+    got = su_block_port_read(&async_chain.port, readbuf_2, 17);
+  while (got > 0);
+
+  SU_TEST_ASSERT(got == SU_BLOCK_PORT_READ_END_OF_STREAM);
+
+  ok = SU_TRUE;
+
+done:
+  SU_TEST_END(ctx);
+
+  su_block_port_unplug(&extra_port);
+
+  if (pipeline != NULL)
+    su_pipeline_destroy(pipeline);
+
+  if (sync_chain_init)
+    su_test_block_chain_finalize(&sync_chain);
+
+  if (async_chain_init)
+    su_test_block_chain_finalize(&async_chain);
+
+  return ok;
+}
+
+SUBOOL
+su_test_block_stats(su_test_context_t *ctx)
+{
+  SUBOOL ok = SU_FALSE;
+  struct su_test_block_chain chain;
+  SUBOOL chain_init = SU_FALSE;
+  SUCOMPLEX *readbuf = NULL;
+  uint64_t *samples;
+  uint64_t *acquires;
+  uint64_t *acquire_ns;
+  uint64_t *desyncs;
+  uint64_t *out_samples;
+  SUSCOUNT p = 0;
+  SUSDIFF got;
+
+  SU_TEST_START(ctx);
+
+  SU_TEST_ASSERT(readbuf = su_test_ctx_getc(ctx, "buf"));
+  SU_TEST_ASSERT(chain_init = su_test_block_chain_init(&chain));
+
+  SU_TEST_ASSERT(samples = su_block_get_property_ref(
+      chain.rrc_block,
+      SU_PROPERTY_TYPE_INTEGER,
+      "stats.samples"));
+  SU_TEST_ASSERT(acquires = su_block_get_property_ref(
+      chain.rrc_block,
+      SU_PROPERTY_TYPE_INTEGER,
+      "stats.acquires"));
+  SU_TEST_ASSERT(acquire_ns = su_block_get_property_ref(
+      chain.rrc_block,
+      SU_PROPERTY_TYPE_INTEGER,
+      "stats.acquire_ns"));
+  SU_TEST_ASSERT(desyncs = su_block_get_property_ref(
+      chain.rrc_block,
+      SU_PROPERTY_TYPE_INTEGER,
+      "stats.desyncs"));
+  SU_TEST_ASSERT(out_samples = su_block_get_property_ref(
+      chain.rrc_block,
+      SU_PROPERTY_TYPE_INTEGER,
+      "stats.out0.samples"));
+
+  SU_TEST_ASSERT(*samples == 0 && *acquires == 0);
+
+  while (p < ctx->params->buffer_size) {
+    got = su_block_port_read(
+        &chain.port,
+        readbuf + p,
+        SU_MIN(17, ctx->params->buffer_size - p));
+    SU_TEST_ASSERT(got > 0);
+    p += got;
+  }
+
+  SU_INFO(
+      "rrc: %lu samples in %lu acquires (%lu ns)\n",
+      (unsigned long) *samples,
+      (unsigned long) *acquires,
+      (unsigned long) *acquire_ns);
+
+  SU_TEST_ASSERT(*samples >= ctx->params->buffer_size);
+  SU_TEST_ASSERT(*acquires > 0);
+  SU_TEST_ASSERT(*acquire_ns > 0);
+  SU_TEST_ASSERT(*desyncs == 0);
+  SU_TEST_ASSERT(*out_samples == *samples);
+
+  ok = SU_TRUE;
+
+done:
+  SU_TEST_END(ctx);
+
+  if (chain_init)
+    su_test_block_chain_finalize(&chain);
+
+  return ok;
+}
+
+SUBOOL
+su_test_block_stream_resize(su_test_context_t *ctx)
+{
+  SUBOOL ok = SU_FALSE;
+  struct su_test_block_chain chain;
+  struct su_test_block_chain resized_chain;
+  SUBOOL chain_init = SU_FALSE;
+  SUBOOL resized_chain_init = SU_FALSE;
+  su_block_t *block = NULL;
+  su_stream_t *stream;
+  su_stream_t raw;
+  SUBOOL raw_init = SU_FALSE;
+  SUCOMPLEX samples[40];
+  su_block_port_t extra_port = su_block_port_INITIALIZER;
+  SUCOMPLEX *readbuf_1 = NULL;
+  SUCOMPLEX *readbuf_2 = NULL;
+  SUSCOUNT p_1 = 0;
+  SUSCOUNT p_2 = 0;
+  SUSDIFF got;
+  SUSCOUNT i;
+
+  SU_TEST_START(ctx);
+
+  SU_TEST_ASSERT(readbuf_1  = su_test_ctx_getc(ctx, "buf"));
+  SU_TEST_ASSERT(readbuf_2  = su_test_ctx_getc(ctx, "resized_buf"));
+
+  /* Growing a full stream must not expose samples that were not kept */
+  for (i = 0; i < 40; ++i)
+    samples[i] = i;
+
+  SU_TEST_ASSERT(raw_init = su_stream_init(&raw, 16));
+  su_stream_write(&raw, samples, 40);
+  SU_TEST_ASSERT(su_stream_resize(&raw, 64));
+  SU_TEST_ASSERT(raw.avail == 16);
+  SU_TEST_ASSERT(su_stream_tell(&raw) == 24);
+  SU_TEST_ASSERT(su_stream_read(&raw, 8, readbuf_1, 16) == -1);
+  SU_TEST_ASSERT(su_stream_read(&raw, 24, readbuf_1, 16) == 16);
+
+  for (i = 0; i < 16; ++i)
+    SU_TEST_ASSERT(readbuf_1[i] == samples[24 + i]);
+
+  /* Stream sizes given at construction */
+  SU_TEST_ASSERT(
+      block = su_block_new_ex(
+          512,
+          "rrc",
+          (unsigned int) 100,
+          (double) 10,
+          (double) 0.25));
+  SU_TEST_ASSERT(stream = su_block_get_stream(block, 0));
+  SU_TEST_ASSERT(stream->size == 512);
+
+  SU_TEST_ASSERT(chain_init = su_test_block_chain_init(&chain));
+  SU_TEST_ASSERT(
+      resized_chain_init = su_test_block_chain_init(&resized_chain));
+
+  while (p_1 < ctx->params->buffer_size) {
+    got = su_block_port_read(
+        &chain.port,
+        readbuf_1 + p_1,
+        SU_MIN(17, ctx->params->buffer_size - p_1));
+    SU_TEST_ASSERT(got > 0);
+    p_1 += got;
+  }
+
+  while (p_2 < ctx->params->buffer_size / 2) {
+    got = su_block_port_read(&resized_chain.port, readbuf_2 + p_2, 17);
+    SU_TEST_ASSERT(got > 0);
+    p_2 += got;
+  }
+
+  /* Resize streams halfway, samples in them must survive */
+  SU_TEST_ASSERT(su_block_set_stream_size(resized_chain.agc_block, 0, 16384));
+  SU_TEST_ASSERT(su_block_set_stream_size(resized_chain.rrc_block, 0, 8192));
+  SU_TEST_ASSERT(su_block_set_autotune(resized_chain.siggen_block, 0, SU_TRUE));
+
+  while (p_2 < ctx->params->buffer_size) {
+    got = su_block_port_read(
+        &resized_chain.port,
+        readbuf_2 + p_2,
+        SU_MIN(17, ctx->params->buffer_size - p_2));
+    SU_TEST_ASSERT(got > 0);
+    p_2 += got;
+  }
+
+  SU_TEST_ASSERT(
+      su_block_get_stream(resized_chain.agc_block, 0)->size >= 16384);
+
+  for (i = 0; i < ctx->params->buffer_size; ++i)
+    SU_TEST_ASSERT(su_test_block_chain_same(readbuf_1[i], readbuf_2[i]));
+
+  /* Other consumers may be peeking: shared streams cannot be resized */
+  SU_TEST_ASSERT(
+      su_block_port_plug(&extra_port, resized_chain.rrc_block, 0));
+  SU_TEST_ASSERT(
+      !su_block_set_stream_size(resized_chain.rrc_block, 0, 4096));
+  SU_TEST_ASSERT(
+      !su_block_set_autotune(resized_chain.rrc_block, 0, SU_TRUE));
+
+  ok = SU_TRUE;
+
+done:
+  SU_TEST_END(ctx);
+
+  su_block_port_unplug(&extra_port);
+
+  if (raw_init)
+    su_stream_finalize(&raw);
+
+  if (block != NULL)
+    su_block_destroy(block);
+
+  if (chain_init)
+    su_test_block_chain_finalize(&chain);
+
+  if (resized_chain_init)
+    su_test_block_chain_finalize(&resized_chain);
+
+  return ok;
+}
+
+SUBOOL
+su_test_block_push(su_test_context_t *ctx)
+{
+  SUBOOL ok = SU_FALSE;
+  struct su_test_block_chain chain;
+  struct su_test_block_chain push_chain;
+  SUBOOL chain_init = SU_FALSE;
+  SUBOOL push_chain_init = SU_FALSE;
+  su_block_t *push_block = NULL;
+  su_block_port_t siggen_port = su_block_port_INITIALIZER;
+  SUCOMPLEX *readbuf_1 = NULL;
+  SUCOMPLEX *readbuf_2 = NULL;
+  SUCOMPLEX samples[1000];
+  SUSCOUNT p_1 = 0;
+  SUSCOUNT p_2 = 0;
+  SUSCOUNT lag;
+  SUSDIFF got;
+  SUSCOUNT i;
+
+  SU_TEST_START(ctx);
+
+  SU_TEST_ASSERT(readbuf_1  = su_test_ctx_getc(ctx, "pull_buf"));
+  SU_TEST_ASSERT(readbuf_2  = su_test_ctx_getc(ctx, "push_buf"));
+
+  SU_TEST_ASSERT(chain_init = su_test_block_chain_init(&chain));
+  SU_TEST_ASSERT(push_chain_init = su_test_block_chain_init(&push_chain));
+
+  while (p_1 < ctx->params->buffer_size) {
+    got = su_block_port_read(
+        &chain.port,
+        readbuf_1 + p_1,
+        SU_MIN(17, ctx->params->buffer_size - p_1));
+    SU_TEST_ASSERT(got > 0);
+    p_1 += got;
+  }
+
+  /* Pull samples from the signal generator ourselves, and push them */
+  su_block_port_unplug(&push_chain.agc_block->in[0]);
+  SU_TEST_ASSERT(
+      su_block_port_plug(&siggen_port, push_chain.siggen_block, 0));
+
+  SU_TEST_ASSERT(push_block = su_block_new("push"));
+  SU_TEST_ASSERT(su_block_plug(push_block, 0, 0, push_chain.agc_block));
+
+  while (p_2 < ctx->params->buffer_size) {
+    got = su_block_port_read(&siggen_port, samples, 1000);
+    SU_TEST_ASSERT(got > 0);
+    SU_TEST_ASSERT(su_block_push(push_block, 0, samples, got) == got);
+
+    /* Samples must be waiting at the end of the graph */
+    lag = su_block_port_get_lag(&push_chain.port);
+    SU_TEST_ASSERT(lag > 0);
+    lag = SU_MIN(lag, ctx->params->buffer_size - p_2);
+
+    SU_TEST_ASSERT(
+        su_block_port_read(&push_chain.port, readbuf_2 + p_2, lag) == lag);
+    p_2 += lag;
+  }
+
+  for (i = 0; i < ctx->params->buffer_size; ++i)
+    SU_TEST_ASSERT(su_test_block_chain_same(readbuf_1[i], readbuf_2[i]));
+
+  ok = SU_TRUE;
+
+done:
+  SU_TEST_END(ctx);
+
+  if (su_block_port_is_plugged(&siggen_port))
+    su_block_port_unplug(&siggen_port);
+
+  if (push_chain_init)
+    su_test_block_chain_finalize(&push_chain);
+
+  if (push_block != NULL)
+    su_block_destroy(push_block);
+
+  if (chain_init)
+    su_test_block_chain_finalize(&chain);
+
+  return ok;
+}
+
+SUBOOL
+su_test_block_fusion(su_test_context_t *ctx)
+{
+  SUBOOL ok = SU_FALSE;
+  struct su_test_block_chain chain;
+  struct su_test_block_chain fused_chain;
+  SUBOOL chain_init = SU_FALSE;
+  SUBOOL fused_chain_init = SU_FALSE;
+  su_block_t *fused_block = NULL;
+  su_block_t *stages[2];
+  SUCOMPLEX *readbuf_1 = NULL;
+  SUCOMPLEX *readbuf_2 = NULL;
+  SUSCOUNT p_1 = 0;
+  SUSCOUNT p_2 = 0;
+  SUSDIFF got;
+  SUSCOUNT i;
+
+  SU_TEST_START(ctx);
+
+  SU_TEST_ASSERT(readbuf_1  = su_test_ctx_getc(ctx, "unfused_buf"));
+  SU_TEST_ASSERT(readbuf_2  = su_test_ctx_getc(ctx, "fused_buf"));
+
+  SU_TEST_ASSERT(chain_init = su_test_block_chain_init(&chain));
+  SU_TEST_ASSERT(fused_chain_init = su_test_block_chain_init(&fused_chain));
+
+  /* Signal generators have no process() method, fuse the rest */
+  su_block_port_unplug(&fused_chain.port);
+  stages[0] = fused_chain.agc_block;
+  stages[1] = fused_chain.rrc_block;
+
+  SU_TEST_ASSERT(su_block_chain_fuse(stages, 1) == NULL);
+  SU_TEST_ASSERT(fused_block = su_block_chain_fuse(stages, 2));
+  SU_TEST_ASSERT(su_block_port_plug(&fused_chain.port, fused_block, 0));
+
+  while (p_1 < ctx->params->buffer_size) {
+    got = su_block_port_read(
+        &chain.port,
+        readbuf_1 + p_1,
+        SU_MIN(17, ctx->params->buffer_size - p_1));
+    SU_TEST_ASSERT(got > 0);
+    p_1 += got;
+  }
+
+  while (p_2 < ctx->params->buffer_size) {
+    got = su_block_port_read(
+        &fused_chain.port,
+        readbuf_2 + p_2,
+        SU_MIN(17, ctx->params->buffer_size - p_2));
+    SU_TEST_ASSERT(got > 0);
+    p_2 += got;
+  }
+
+  /* Fusion must not change the results */
+  for (i = 0; i < ctx->params->buffer_size; ++i)
+    SU_TEST_ASSERT(su_test_block_chain_same(readbuf_1[i], readbuf_2[i]));
+
+  ok = SU_TRUE;
+
+done:
+  SU_TEST_END(ctx);
+
+  if (fused_chain_init)
+    su_block_port_unplug(&fused_chain.port);
+
+  if (fused_block != NULL)
+    su_block_destroy(fused_block);
+
+  if (chain_init)
+    su_test_block_chain_finalize(&chain);
+
+  if (fused_chain_init)
+    su_test_block_chain_finalize(&fused_chain);
+
+  return ok;
+}
+
+#define SU_TEST_BLOCK_EXECUTOR_CHAINS  8
+#define SU_TEST_BLOCK_EXECUTOR_WORKERS 2
+
+SUBOOL
+su_test_block_executor(su_test_context_t *ctx)
+{
+  SUBOOL ok = SU_FALSE;
+  struct su_test_block_chain sync_chain;
+  struct su_test_block_chain chains[SU_TEST_BLOCK_EXECUTOR_CHAINS];
+  SUSCOUNT p[SU_TEST_BLOCK_EXECUTOR_CHAINS];
+  SUBOOL sync_chain_init = SU_FALSE;
+  unsigned int chain_count = 0;
+  su_executor_t *executor = NULL;
+  SUCOMPLEX *readbuf_1 = NULL;
+  SUCOMPLEX *readbuf_2 = NULL;
+  SUSCOUNT p_1 = 0;
+  SUSCOUNT remaining;
+  SUSDIFF got;
+  SUSCOUNT i;
+  unsigned int j;
+
+  SU_TEST_START(ctx);
+
+  SU_TEST_ASSERT(readbuf_1  = su_test_ctx_getc(ctx, "sync_buf"));
+  SU_TEST_ASSERT(readbuf_2  = su_test_ctx_getc(ctx, "async_buf"));
+
+  SU_TEST_ASSERT(sync_chain_init = su_test_block_chain_init(&sync_chain));
+
+  while (p_1 < ctx->params->buffer_size) {
+    got = su_block_port_read(
+        &sync_chain.port,
+        readbuf_1 + p_1,
+        SU_MIN(17, ctx->params->buffer_size - p_1));
+    SU_TEST_ASSERT(got > 0);
+    p_1 += got;
+  }
+
+  /* More block outputs than workers */
+  SU_TEST_ASSERT(
+      executor = su_executor_new(SU_TEST_BLOCK_EXECUTOR_WORKERS));
+
+  for (j = 0; j < SU_TEST_BLOCK_EXECUTOR_CHAINS; ++j) {
+    SU_TEST_ASSERT(su_test_block_chain_init(chains + j));
+    ++chain_count;
+    p[j] = 0;
+
+    SU_TEST_ASSERT(su_executor_add_block(executor, chains[j].siggen_block));
+    SU_TEST_ASSERT(su_executor_add_block(executor, chains[j].agc_block));
+    SU_TEST_ASSERT(su_executor_add_block(executor, chains[j].rrc_block));
+  }
+
+  SU_TEST_ASSERT(su_executor_start(executor));
+
+  /* Read all chains in parallel: results must not depend on scheduling */
+  do {
+    remaining = 0;
+
+    for (j = 0; j < SU_TEST_BLOCK_EXECUTOR_CHAINS; ++j) {
+      if (p[j] == ctx->params->buffer_size)
+        continue;
+
+      got = su_block_port_read(
+          &chains[j].port,
+          readbuf_2,
+          SU_MIN(17, ctx->params->buffer_size - p[j]));
+      SU_TEST_ASSERT(got > 0);
+
+      for (i = 0; i < got; ++i)
+        SU_TEST_ASSERT(
+            su_test_block_chain_same(readbuf_1[p[j] + i], readbuf_2[i]));
+
+      p[j] += got;
+      remaining += ctx->params->buffer_size - p[j];
+    }
+  } while (remaining > 0);
+
+  /* Stopping the executor must make readers return EOS */
+  su_executor_stop(executor);
+
+  for (j = 0; j < SU_TEST_BLOCK_EXECUTOR_CHAINS; ++j) {
+    do
+      got = su_block_port_read(&chains[j].port, readbuf_2, 17);
+    while (got > 0);
+
+    SU_TEST_ASSERT(got == SU_BLOCK_PORT_READ_END_OF_STREAM);
+  }
+
+  ok = SU_TRUE;
+
+done:
+  SU_TEST_END(ctx);
+
+  if (executor != NULL)
+    su_executor_destroy(executor);
+
+  for (j = 0; j < chain_count; ++j)
+    su_test_block_chain_finalize(chains + j);
+
+  if (sync_chain_init)
+    su_test_block_chain_finalize(&sync_chain);
+
+  return ok;
+}
+
+/*
+ * Source block whose acquire() keeps the calling thread busy until the gate
+ * is opened, and then returns EOS.
+ */
+struct su_test_block_gate {
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  SUBOOL entered;
+  SUBOOL open;
+};
+
+SUPRIVATE SUBOOL
+su_test_block_gate_ctor(struct sigutils_block *block, void **private, va_list ap)
+{
+  *private = va_arg(ap, struct su_test_block_gate *);
+
+  return SU_TRUE;
+}
+
+SUPRIVATE void
+su_test_block_gate_dtor(void *private)
+{
+}
+
+SUPRIVATE SUSDIFF
+su_test_block_gate_acquire(
+    void *priv,
+    su_stream_t *out,
+    unsigned int port_id,
+    su_block_port_t *in)
+{
+  struct su_test_block_gate *gate = (struct su_test_block_gate *) priv;
+
+  pthread_mutex_lock(&gate->lock);
+
+  gate->entered = SU_TRUE;
+  pthread_cond_broadcast(&gate->cond);
+
+  while (!gate->open)
+    pthread_cond_wait(&gate->cond, &gate->lock);
+
+  pthread_mutex_unlock(&gate->lock);
+
+  return 0;
+}
+
+SUPRIVATE struct sigutils_block_class su_test_block_class_GATE = {
+    "test_gate", /* name */
+    0,           /* in_size */
+    1,           /* out_size */
+    su_test_block_gate_ctor,    /* constructor */
+    su_test_block_gate_dtor,    /* destructor */
+    su_test_block_gate_acquire, /* acquire */
+    NULL                        /* process */
+};
+
+SUPRIVATE void
+su_test_block_gate_open(struct su_test_block_gate *gate)
+{
+  pthread_mutex_lock(&gate->lock);
+  gate->open = SU_TRUE;
+  pthread_cond_broadcast(&gate->cond);
+  pthread_mutex_unlock(&gate->lock);
+}
+
+SUBOOL
+su_test_block_executor_progress(su_test_context_t *ctx)
+{
+  SUBOOL ok = SU_FALSE;
+  struct su_test_block_gate gate = {
+      PTHREAD_MUTEX_INITIALIZER,
+      PTHREAD_COND_INITIALIZER,
+      SU_FALSE,
+      SU_FALSE};
+  struct su_test_block_chain chains[SU_TEST_BLOCK_EXECUTOR_CHAINS];
+  unsigned int chain_count = 0;
+  su_block_t *gate_block = NULL;
+  su_block_t *rrc_block = NULL;
+  su_executor_t *executor = NULL;
+  unsigned int full = 0;
+  unsigned int tries;
+  unsigned int j;
+
+  SU_TEST_START(ctx);
+
+  if (su_block_class_lookup(su_test_block_class_GATE.name) == NULL)
+    SU_TEST_ASSERT(su_block_class_register(&su_test_block_class_GATE));
+
+  SU_TEST_ASSERT(gate_block = su_block_new("test_gate", &gate));
+  SU_TEST_ASSERT(
+      rrc_block = su_block_new(
+          "rrc",
+          (unsigned int) 100,
+          (double) 10,
+          (double) 0.25));
+  SU_TEST_ASSERT(su_block_plug(gate_block, 0, 0, rrc_block));
+
+  /* One worker gets stuck in the gate, the other one must do all the work */
+  SU_TEST_ASSERT(
+      executor = su_executor_new(SU_TEST_BLOCK_EXECUTOR_WORKERS));
+  SU_TEST_ASSERT(su_executor_add_block(executor, gate_block));
+  SU_TEST_ASSERT(su_executor_start(executor));
+
+  pthread_mutex_lock(&gate.lock);
+  while (!gate.entered)
+    pthread_cond_wait(&gate.cond, &gate.lock);
+  pthread_mutex_unlock(&gate.lock);
+
+  /* The free worker picks the filter, whose source is busy elsewhere */
+  SU_TEST_ASSERT(su_executor_add_block(executor, rrc_block));
+  usleep(100000);
+
+  /* More graphs than workers, and nobody reading from them */
+  for (j = 0; j < SU_TEST_BLOCK_EXECUTOR_CHAINS; ++j) {
+    SU_TEST_ASSERT(su_test_block_chain_init(chains + j));
+    ++chain_count;
+
+    SU_TEST_ASSERT(su_executor_add_block(executor, chains[j].siggen_block));
+    SU_TEST_ASSERT(su_executor_add_block(executor, chains[j].agc_block));
+    SU_TEST_ASSERT(su_executor_add_block(executor, chains[j].rrc_block));
+  }
+
+  /* All of them must fill their outputs */
+  for (tries = 0; tries < 100; ++tries) {
+    for (full = 0, j = 0; j < SU_TEST_BLOCK_EXECUTOR_CHAINS; ++j)
+      if (su_block_get_room(chains[j].rrc_block, 0) == 0)
+        ++full;
+
+    if (full == SU_TEST_BLOCK_EXECUTOR_CHAINS)
+      break;
+
+    usleep(100000);
+  }
+
+  SU_TEST_ASSERT(full == SU_TEST_BLOCK_EXECUTOR_CHAINS);
+
+  ok = SU_TRUE;
+
+done:
+  SU_TEST_END(ctx);
+
+  /* Release the worker running the gate before joining it */
+  su_test_block_gate_open(&gate);
+
+  if (executor != NULL)
+    su_executor_destroy(executor);
+
+  for (j = 0; j < chain_count; ++j)
+    su_test_block_chain_finalize(chains + j);
+
+  if (rrc_block != NULL)
+    su_block_destroy(rrc_block);
+
+  if (gate_block != NULL)
+    su_block_destroy(gate_block);
+
+  return ok;
+}
+
 SUBOOL
 su_test_tuner(su_test_context_t *ctx)
 {
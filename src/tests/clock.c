@@ -238,3 +238,111 @@ su_test_clock_recovery_noisy(su_test_context_t *ctx)
 {
   return __su_test_clock_recovery(ctx, SU_TRUE);
 }
+
+SUBOOL
+su_test_farrow(su_test_context_t *ctx)
+{
+  SUBOOL ok = SU_FALSE;
+  SUCOMPLEX *x = NULL;
+  SUCOMPLEX *y = NULL;
+  SUCOMPLEX *z = NULL;
+  su_sampler_t bulk, single;
+  SUCOMPLEX sample;
+  SUSCOUNT p, got, n = 0;
+  SUFLOAT diff;
+  SUFLOAT err = 0;
+  SUFLOAT t;
+  const SUFLOAT fnor = .1; /* Cycles per sample */
+  const SUFLOAT bnor = 1 / 2.7;
+  const SUSCOUNT len = 4000;
+
+  SU_TEST_START(ctx);
+
+  SU_TEST_ASSERT(x = malloc(len * sizeof (SUCOMPLEX)));
+  SU_TEST_ASSERT(y = malloc(len * sizeof (SUCOMPLEX)));
+  SU_TEST_ASSERT(z = malloc(len * sizeof (SUCOMPLEX)));
+
+  SU_TEST_ASSERT(su_sampler_init(&bulk, bnor));
+  SU_TEST_ASSERT(su_sampler_init(&single, bnor));
+
+  for (p = 0; p < len; ++p)
+    x[p] = SU_C_EXP(2 * I * M_PI * fnor * p);
+
+  /* Bulk sampling, in uneven chunks */
+  got  = su_sampler_feed_bulk(&bulk, x, y, 2);
+  got += su_sampler_feed_bulk(&bulk, x + 2, y + got, 1001);
+  got += su_sampler_feed_bulk(&bulk, x + 1003, y + got, len - 1003);
+
+  /*
+   * The output taken after x[p] lies at p - 1 - phase (one sample of
+   * delay). Compare against the exact tone and the bulk outputs.
+   */
+  for (p = 0; p < len; ++p) {
+    sample = x[p];
+    if (su_sampler_feed(&single, &sample)) {
+      SU_TEST_ASSERT(n < got);
+
+      diff = SU_C_ABS(sample - y[n++]);
+      SU_TEST_ASSERT(diff < 1e-5);
+
+      if (p >= 3) {
+        t = p - 1 - single.phase;
+        diff = SU_C_ABS(sample - SU_C_EXP(2 * I * M_PI * fnor * t));
+        if (diff > err)
+          err = diff;
+      }
+    }
+  }
+
+  SU_TEST_ASSERT(n == got);
+
+  /* Linear interpolation would give up to 5e-2 here */
+  SU_INFO("Max interpolation error at %g cycles/sample: %g\n", fnor, err);
+  SU_TEST_ASSERT(err < 1e-2);
+
+  /*
+   * Cubic interpolation of a ramp is exact: outputs are the sampling
+   * instants themselves, which must be exactly one period apart.
+   */
+  SU_TEST_ASSERT(su_sampler_init(&bulk, bnor));
+
+  for (p = 0; p < 1000; ++p)
+    x[p] = p;
+
+  got = su_sampler_feed_bulk(&bulk, x, y, 1000);
+  SU_TEST_ASSERT(got > 3);
+
+  for (p = 3; p < got; ++p)
+    SU_TEST_ASSERT(SU_C_ABS(y[p] - y[p - 1] - 1 / bnor) < 1e-3);
+
+  /* In place, with almost one output per input */
+  SU_TEST_ASSERT(su_sampler_init(&bulk, 1 / 1.3));
+  SU_TEST_ASSERT(su_sampler_init(&single, 1 / 1.3));
+
+  memcpy(z, x, len * sizeof (SUCOMPLEX));
+  got = su_sampler_feed_bulk(&bulk, x, y, 1001);
+  got += su_sampler_feed_bulk(&bulk, x + 1001, y + got, len - 1001);
+
+  n  = su_sampler_feed_bulk(&single, z, z, 1001);
+  n += su_sampler_feed_bulk(&single, z + 1001, z + n, len - 1001);
+
+  SU_TEST_ASSERT(n == got);
+  for (p = 0; p < n; ++p)
+    SU_TEST_ASSERT(z[p] == y[p]);
+
+  ok = SU_TRUE;
+
+done:
+  SU_TEST_END(ctx);
+
+  if (x != NULL)
+    free(x);
+
+  if (y != NULL)
+    free(y);
+
+  if (z != NULL)
+    free(z);
+
+  return ok;
+}
@@ -24,6 +24,12 @@
 #include <sigutils/sampling.h>
 #include <sigutils/ncqo.h>
 #include <sigutils/iir.h>
+#include <sigutils/coef.h>
+#include <sigutils/decim.h>
+#include <sigutils/resampler.h>
+#include <sigutils/sos.h>
+#include <sigutils/tapcache.h>
+#include <sigutils/taps.h>
 #include <sigutils/agc.h>
 #include <sigutils/pll.h>
 
@@ -88,3 +94,589 @@ done:
 }
 
 
+
+SUBOOL
+su_test_fir_overlap_save(su_test_context_t *ctx)
+{
+  SUBOOL ok = SU_FALSE;
+  SUCOMPLEX *x = NULL;
+  SUCOMPLEX *y = NULL;
+  su_iir_filt_t direct = su_iir_filt_INITIALIZER;
+  su_iir_filt_t ols = su_iir_filt_INITIALIZER;
+  SUSCOUNT p, n;
+  SUFLOAT diff;
+  SUFLOAT err = 0;
+  const SUSCOUNT size = 16384;
+  const SUSCOUNT taps = 200;
+
+  SU_TEST_START(ctx);
+
+  SU_TEST_ASSERT(x = malloc(size * sizeof (SUCOMPLEX)));
+  SU_TEST_ASSERT(y = malloc(size * sizeof (SUCOMPLEX)));
+
+  SU_TEST_ASSERT(su_iir_rrc_init(&direct, taps, 8, .35));
+  SU_TEST_ASSERT(su_iir_rrc_init(&ols, taps, 8, .35));
+  SU_TEST_ASSERT(ols.ols != NULL);
+
+  for (p = 0; p < size; ++p)
+    x[p] = su_c_awgn();
+
+  /* Irregular chunks, both shorter and longer than an FFT block */
+  for (p = 0; p < size; p += n) {
+    n = SU_MIN(size - p, 1 + (p * 37) % (3 * ols.ols->block));
+    su_iir_filt_feed_bulk(&ols, x + p, y + p, n);
+  }
+
+  for (p = 0; p < size; ++p) {
+    diff = SU_C_ABS(y[p] - su_iir_filt_feed(&direct, x[p]));
+    err = SU_MAX(err, diff);
+  }
+
+  SU_INFO("Max error: %g\n", err);
+  SU_TEST_ASSERT(err < 1e-4);
+
+  ok = SU_TRUE;
+
+done:
+  SU_TEST_END(ctx);
+
+  su_iir_filt_finalize(&direct);
+  su_iir_filt_finalize(&ols);
+
+  if (x != NULL)
+    free(x);
+
+  if (y != NULL)
+    free(y);
+
+  return ok;
+}
+
+SUBOOL
+su_test_fir_decim(su_test_context_t *ctx)
+{
+  SUBOOL ok = SU_FALSE;
+  SUCOMPLEX *x = NULL;
+  SUCOMPLEX *y = NULL;
+  SUFLOAT h[48];
+  su_iir_filt_t full = su_iir_filt_INITIALIZER;
+  su_fir_decim_t decim = su_fir_decim_INITIALIZER;
+  SUSCOUNT p, n, got = 0;
+  SUCOMPLEX ref;
+  SUFLOAT diff;
+  SUFLOAT err = 0;
+  const unsigned int D = 6;
+  const SUSCOUNT size = 6000;
+
+  SU_TEST_START(ctx);
+
+  SU_TEST_ASSERT(x = malloc(size * sizeof (SUCOMPLEX)));
+  SU_TEST_ASSERT(y = malloc(size * sizeof (SUCOMPLEX)));
+
+  su_taps_brickwall_lp_init(h, 1. / D, 48);
+
+  SU_TEST_ASSERT(su_iir_filt_init(&full, 0, NULL, 48, h));
+  SU_TEST_ASSERT(su_fir_decim_init(&decim, D, h, 48));
+
+  for (p = 0; p < size; ++p)
+    x[p] = su_c_awgn();
+
+  for (p = 0; p < size; p += n) {
+    n = SU_MIN(size - p, 1 + (p * 13) % 37);
+    got += su_fir_decim_feed_bulk(&decim, x + p, n, y + got);
+  }
+
+  SU_TEST_ASSERT(got == size / D);
+
+  /* Outputs are those of the full rate filter, every D samples */
+  for (p = 0; p < size; ++p) {
+    ref = su_iir_filt_feed(&full, x[p]);
+    if (p % D == D - 1) {
+      diff = SU_C_ABS(ref - y[p / D]);
+      err = SU_MAX(err, diff);
+    }
+  }
+
+  SU_INFO("Max error: %g\n", err);
+  SU_TEST_ASSERT(err < 1e-5);
+
+  ok = SU_TRUE;
+
+done:
+  SU_TEST_END(ctx);
+
+  su_iir_filt_finalize(&full);
+  su_fir_decim_finalize(&decim);
+
+  if (x != NULL)
+    free(x);
+
+  if (y != NULL)
+    free(y);
+
+  return ok;
+}
+
+SUBOOL
+su_test_cic_halfband(su_test_context_t *ctx)
+{
+  SUBOOL ok = SU_FALSE;
+  SUCOMPLEX *x = NULL;
+  SUCOMPLEX *y = NULL;
+  SUCOMPLEX *ref = NULL;
+  SUFLOAT *h = NULL;
+  su_cic_decim_t cic = su_cic_decim_INITIALIZER;
+  su_halfband_decim_t hb = su_halfband_decim_INITIALIZER;
+  su_fir_decim_t fir = su_fir_decim_INITIALIZER;
+  SUSCOUNT p, n, got, ref_got;
+  unsigned int i, j, size;
+  SUFLOAT diff;
+  SUFLOAT err;
+  const unsigned int N = 3;
+  const unsigned int R = 5;
+  const SUSCOUNT len = 6000;
+
+  SU_TEST_START(ctx);
+
+  SU_TEST_ASSERT(x = malloc(len * sizeof (SUCOMPLEX)));
+  SU_TEST_ASSERT(y = malloc(len * sizeof (SUCOMPLEX)));
+  SU_TEST_ASSERT(ref = malloc(len * sizeof (SUCOMPLEX)));
+
+  for (p = 0; p < len; ++p)
+    x[p] = su_c_awgn();
+
+  /* A CIC decimator is a FIR decimator with N boxcars of R taps in a row */
+  size = N * (R - 1) + 1;
+  SU_TEST_ASSERT(h = calloc(size, sizeof (SUFLOAT)));
+
+  /* Convolve N times with a normalized boxcar */
+  h[0] = 1;
+  for (i = 0; i < N; ++i)
+    for (j = size - 1; j + 1 > 0; --j) {
+      diff = 0;
+      for (p = 0; p < R && p <= j; ++p)
+        diff += h[j - p];
+      h[j] = diff / R;
+    }
+
+  SU_TEST_ASSERT(su_cic_decim_init(&cic, N, R));
+  SU_TEST_ASSERT(su_fir_decim_init(&fir, R, h, size));
+
+  got = 0;
+  for (p = 0; p < len; p += n) {
+    n = SU_MIN(len - p, 1 + (p * 13) % 37);
+    got += su_cic_decim_feed_bulk(&cic, x + p, n, y + got);
+  }
+
+  ref_got = su_fir_decim_feed_bulk(&fir, x, len, ref);
+  SU_TEST_ASSERT(got == len / R && ref_got == got);
+
+  err = 0;
+  for (p = 0; p < got; ++p) {
+    diff = SU_C_ABS(ref[p] - y[p]);
+    err = SU_MAX(err, diff);
+  }
+
+  SU_INFO("CIC max error: %g\n", err);
+  SU_TEST_ASSERT(err < 1e-5);
+
+  su_fir_decim_finalize(&fir);
+  free(h);
+  h = NULL;
+
+  /* Half-band: same as the full filter, zeroes included */
+  SU_TEST_ASSERT(su_halfband_decim_init(&hb, 0));
+  size = 4 * hb.size - 1;
+  SU_TEST_ASSERT(h = calloc(size, sizeof (SUFLOAT)));
+
+  h[2 * hb.size - 1] = .5;
+  for (i = 0; i < hb.size; ++i) {
+    h[2 * hb.size - 1 - (2 * i + 1)] = hb.g[i];
+    h[2 * hb.size - 1 + (2 * i + 1)] = hb.g[i];
+  }
+
+  SU_TEST_ASSERT(su_fir_decim_init(&fir, 2, h, size));
+
+  got = 0;
+  for (p = 0; p < len; p += n) {
+    n = SU_MIN(len - p, 1 + (p * 13) % 37);
+    got += su_halfband_decim_feed_bulk(&hb, x + p, n, y + got);
+  }
+
+  ref_got = su_fir_decim_feed_bulk(&fir, x, len, ref);
+  SU_TEST_ASSERT(got == len / 2 && ref_got == got);
+
+  err = 0;
+  for (p = 0; p < got; ++p) {
+    diff = SU_C_ABS(ref[p] - y[p]);
+    err = SU_MAX(err, diff);
+  }
+
+  SU_INFO("Half-band max error: %g\n", err);
+  SU_TEST_ASSERT(err < 1e-5);
+
+  ok = SU_TRUE;
+
+done:
+  SU_TEST_END(ctx);
+
+  su_cic_decim_finalize(&cic);
+  su_halfband_decim_finalize(&hb);
+  su_fir_decim_finalize(&fir);
+
+  if (x != NULL)
+    free(x);
+
+  if (y != NULL)
+    free(y);
+
+  if (ref != NULL)
+    free(ref);
+
+  if (h != NULL)
+    free(h);
+
+  return ok;
+}
+
+SUBOOL
+su_test_resampler(su_test_context_t *ctx)
+{
+  SUBOOL ok = SU_FALSE;
+  SUCOMPLEX *x = NULL;
+  SUCOMPLEX *y = NULL;
+  SUFLOAT *h = NULL;
+  su_iir_filt_t full = su_iir_filt_INITIALIZER;
+  su_resampler_t resampler = su_resampler_INITIALIZER;
+  SUSCOUNT p, n, size, max, out, got = 0;
+  SUCOMPLEX ref;
+  SUFLOAT diff;
+  SUFLOAT err = 0;
+  const unsigned int L = 3;
+  const unsigned int M = 2;
+  const SUSCOUNT len = 4000;
+
+  SU_TEST_START(ctx);
+
+  SU_TEST_ASSERT(x = malloc(len * sizeof (SUCOMPLEX)));
+  SU_TEST_ASSERT(y = malloc(len * L * sizeof (SUCOMPLEX)));
+
+  /* 6 / 4 is reduced to 3 / 2 */
+  SU_TEST_ASSERT(su_resampler_init(&resampler, 2 * L, 2 * M, 0));
+  SU_TEST_ASSERT(resampler.interp == L && resampler.decim == M);
+
+  /* Same prototype filter, applied to the zero-stuffed input */
+  size = resampler.phase_size * L;
+  SU_TEST_ASSERT(h = malloc(size * sizeof (SUFLOAT)));
+  su_taps_brickwall_lp_init(h, 1. / L, size);
+  for (p = 0; p < size; ++p)
+    h[p] *= L;
+
+  SU_TEST_ASSERT(su_iir_filt_init(&full, 0, NULL, size, h));
+
+  for (p = 0; p < len; ++p)
+    x[p] = su_c_awgn();
+
+  for (p = 0; p < len; p += n) {
+    n = SU_MIN(len - p, 1 + (p * 13) % 37);
+    max = su_resampler_get_max_output(&resampler, n);
+    out = su_resampler_feed_bulk(&resampler, x + p, n, y + got);
+    SU_TEST_ASSERT(out <= max);
+    got += out;
+  }
+
+  SU_TEST_ASSERT(got == len * L / M);
+
+  /* Outputs are those of the upsampled signal, every M samples */
+  for (p = 0; p < len * L; ++p) {
+    ref = su_iir_filt_feed(&full, p % L == 0 ? x[p / L] : 0);
+    if (p % M == 0) {
+      diff = SU_C_ABS(ref - y[p / M]);
+      err = SU_MAX(err, diff);
+    }
+  }
+
+  SU_INFO("Max error: %g\n", err);
+  SU_TEST_ASSERT(err < 1e-5);
+
+  /* Just as many inputs as needed to fill the output */
+  su_resampler_reset(&resampler);
+  n = su_resampler_get_max_input(&resampler, 100);
+  SU_TEST_ASSERT(su_resampler_feed_bulk(&resampler, x, n, y) <= 100);
+  SU_TEST_ASSERT(su_resampler_feed_bulk(&resampler, x, 1, y) > 0);
+
+  ok = SU_TRUE;
+
+done:
+  SU_TEST_END(ctx);
+
+  su_iir_filt_finalize(&full);
+  su_resampler_finalize(&resampler);
+
+  if (x != NULL)
+    free(x);
+
+  if (y != NULL)
+    free(y);
+
+  if (h != NULL)
+    free(h);
+
+  return ok;
+}
+
+SUPRIVATE SUFLOAT
+su_test_sos_tone_gain(su_sos_filt_t *filt, SUFLOAT fnor)
+{
+  su_ncqo_t lo = su_ncqo_INITIALIZER;
+  SUFLOAT peak = 0;
+  SUFLOAT mag;
+  unsigned int i;
+
+  su_ncqo_init(&lo, fnor);
+  su_sos_filt_reset(filt);
+
+  for (i = 0; i < 8192; ++i) {
+    mag = SU_C_ABS(su_sos_filt_feed(filt, su_ncqo_read(&lo)));
+    if (i >= 4096)
+      peak = SU_MAX(peak, mag);
+  }
+
+  return peak;
+}
+
+SUBOOL
+su_test_sos(su_test_context_t *ctx)
+{
+  SUBOOL ok = SU_FALSE;
+  SUCOMPLEX *x = NULL;
+  SUCOMPLEX *y = NULL;
+  su_iir_filt_t df = su_iir_filt_INITIALIZER;
+  su_sos_filt_t sos = su_sos_filt_INITIALIZER;
+  su_sos_filt_t multi = su_sos_filt_INITIALIZER;
+  SUSCOUNT p;
+  unsigned int c;
+  SUCOMPLEX ref;
+  SUFLOAT diff;
+  SUFLOAT err = 0;
+  SUFLOAT gain;
+  const unsigned int channels = 3;
+  const SUSCOUNT len = 2048;
+
+  SU_TEST_START(ctx);
+
+  SU_TEST_ASSERT(x = malloc(channels * len * sizeof (SUCOMPLEX)));
+  SU_TEST_ASSERT(y = malloc(channels * len * sizeof (SUCOMPLEX)));
+
+  /* Same filter as the direct form one */
+  SU_TEST_ASSERT(su_iir_bwlpf_init(&df, 5, .25));
+  SU_TEST_ASSERT(su_sos_bwlpf_init(&sos, 5, .25));
+  SU_TEST_ASSERT(sos.sections == 3);
+
+  for (p = 0; p < len; ++p) {
+    x[p] = su_c_awgn();
+    ref = su_iir_filt_feed(&df, x[p]);
+    diff = SU_C_ABS(ref - su_sos_filt_feed(&sos, x[p]));
+    err = SU_MAX(err, diff);
+  }
+
+  SU_INFO("Max error against direct form: %g\n", err);
+  SU_TEST_ASSERT(err < 1e-3);
+
+  /* Interleaved channels are filtered independently */
+  SU_TEST_ASSERT(su_sos_bwlpf_init(&multi, 5, .25));
+  SU_TEST_ASSERT(su_sos_filt_set_channels(&multi, channels));
+
+  for (p = 0; p < channels * len; ++p)
+    x[p] = su_c_awgn();
+
+  /* Second half is filtered in place */
+  memcpy(
+      y + channels * (len / 2),
+      x + channels * (len / 2),
+      channels * (len - len / 2) * sizeof (SUCOMPLEX));
+
+  su_sos_filt_feed_bulk(&multi, x, y, len / 2);
+  su_sos_filt_feed_bulk(
+      &multi,
+      y + channels * (len / 2),
+      y + channels * (len / 2),
+      len - len / 2);
+
+  err = 0;
+  for (c = 0; c < channels; ++c) {
+    su_sos_filt_reset(&sos);
+    for (p = 0; p < len; ++p) {
+      ref = su_sos_filt_feed(&sos, x[p * channels + c]);
+      diff = SU_C_ABS(ref - y[p * channels + c]);
+      err = SU_MAX(err, diff);
+    }
+  }
+
+  SU_INFO("Max error across channels: %g\n", err);
+  SU_TEST_ASSERT(err < 1e-5);
+
+  su_sos_filt_finalize(&sos);
+
+  /* High order filters stay stable */
+  SU_TEST_ASSERT(su_sos_bwbpf_init(&sos, 10, .2, .3));
+  gain = su_test_sos_tone_gain(&sos, .25);
+  SU_INFO("Band pass gain: in band %g", gain);
+  SU_TEST_ASSERT(SU_ABS(gain - 1) < 1e-2);
+  gain = su_test_sos_tone_gain(&sos, .1);
+  SU_INFO(", stop band %g\n", gain);
+  SU_TEST_ASSERT(gain < 1e-3);
+
+  su_sos_filt_finalize(&sos);
+
+  SU_TEST_ASSERT(su_sos_bwhpf_init(&sos, 12, .5));
+  SU_TEST_ASSERT(SU_ABS(su_test_sos_tone_gain(&sos, .8) - 1) < 1e-2);
+  SU_TEST_ASSERT(su_test_sos_tone_gain(&sos, .3) < 1e-3);
+
+  ok = SU_TRUE;
+
+done:
+  SU_TEST_END(ctx);
+
+  su_iir_filt_finalize(&df);
+  su_sos_filt_finalize(&sos);
+  su_sos_filt_finalize(&multi);
+
+  if (x != NULL)
+    free(x);
+
+  if (y != NULL)
+    free(y);
+
+  return ok;
+}
+
+SUBOOL
+su_test_rfilt(su_test_context_t *ctx)
+{
+  SUBOOL ok = SU_FALSE;
+  SUFLOAT *x = NULL;
+  SUFLOAT *y = NULL;
+  SUFLOAT h[37];
+  su_iir_filt_t ref = su_iir_filt_INITIALIZER;
+  su_iir_rfilt_t filt = su_iir_rfilt_INITIALIZER;
+  SUSCOUNT p;
+  SUFLOAT diff;
+  SUFLOAT err = 0;
+  const SUSCOUNT len = 4096;
+
+  SU_TEST_START(ctx);
+
+  SU_TEST_ASSERT(x = malloc(len * sizeof (SUFLOAT)));
+  SU_TEST_ASSERT(y = malloc(len * sizeof (SUFLOAT)));
+
+  for (p = 0; p < len; ++p)
+    x[p] = SU_C_REAL(su_c_awgn());
+
+  /* FIR, fed in bulk, in place */
+  su_taps_brickwall_lp_init(h, .3, 37);
+  SU_TEST_ASSERT(su_iir_filt_init(&ref, 0, NULL, 37, h));
+  SU_TEST_ASSERT(su_iir_rfilt_init(&filt, 0, NULL, 37, h));
+
+  memcpy(y, x, len * sizeof (SUFLOAT));
+  su_iir_rfilt_feed_bulk(&filt, y, y, len);
+
+  for (p = 0; p < len; ++p) {
+    diff = SU_ABS(SU_C_REAL(su_iir_filt_feed(&ref, x[p])) - y[p]);
+    err = SU_MAX(err, diff);
+  }
+
+  su_iir_filt_finalize(&ref);
+  su_iir_rfilt_finalize(&filt);
+  memset(&ref, 0, sizeof (su_iir_filt_t));
+
+  /* IIR, one sample at a time */
+  SU_TEST_ASSERT(su_iir_bwlpf_init(&ref, 4, .2));
+  SU_TEST_ASSERT(
+      su_iir_rfilt_init(&filt, ref.y_size, ref.a, ref.x_size, ref.b));
+
+  for (p = 0; p < len; ++p) {
+    diff = SU_ABS(
+        SU_C_REAL(su_iir_filt_feed(&ref, x[p]))
+        - su_iir_rfilt_feed(&filt, x[p]));
+    err = SU_MAX(err, diff);
+  }
+
+  SU_INFO("Max error: %g\n", err);
+  SU_TEST_ASSERT(err < 1e-5);
+
+  ok = SU_TRUE;
+
+done:
+  SU_TEST_END(ctx);
+
+  su_iir_filt_finalize(&ref);
+  su_iir_rfilt_finalize(&filt);
+
+  if (x != NULL)
+    free(x);
+
+  if (y != NULL)
+    free(y);
+
+  return ok;
+}
+
+SUBOOL
+su_test_tapcache(su_test_context_t *ctx)
+{
+  SUBOOL ok = SU_FALSE;
+  const SUFLOAT *a = NULL;
+  const SUFLOAT *b = NULL;
+  const SUFLOAT *c = NULL;
+  SUFLOAT h[101];
+  su_iir_filt_t f1 = su_iir_filt_INITIALIZER;
+  su_iir_filt_t f2 = su_iir_filt_INITIALIZER;
+  SUFLOAT *ref = NULL;
+  unsigned int i;
+
+  SU_TEST_START(ctx);
+
+  /* Same parameters, same taps */
+  SU_TEST_ASSERT(a = su_tapcache_rrc(16, .35, 101));
+  SU_TEST_ASSERT(b = su_tapcache_rrc(16, .35, 101));
+  SU_TEST_ASSERT(c = su_tapcache_rrc(16, .25, 101));
+  SU_TEST_ASSERT(a == b);
+  SU_TEST_ASSERT(a != c);
+
+  su_taps_rrc_init(h, 16, .35, 101);
+  SU_TEST_ASSERT(memcmp(a, h, sizeof (h)) == 0);
+
+  /* Filters share their coefficients too */
+  SU_TEST_ASSERT(su_iir_rrc_init(&f1, 101, 16, .35));
+  SU_TEST_ASSERT(su_iir_rrc_init(&f2, 101, 16, .35));
+  SU_TEST_ASSERT(f1.b == a && f2.b == a);
+
+  su_iir_filt_finalize(&f1);
+  su_iir_filt_finalize(&f2);
+  memset(&f1, 0, sizeof (su_iir_filt_t));
+  memset(&f2, 0, sizeof (su_iir_filt_t));
+
+  /* Butterworth designs keep the coefficients of coef.c */
+  SU_TEST_ASSERT(su_iir_bwlpf_init(&f1, 5, .3));
+  SU_TEST_ASSERT(ref = su_dcof_bwlp(5, .3));
+  for (i = 0; i < 6; ++i)
+    SU_TEST_ASSERT(f1.a[i] == ref[i]);
+
+  ok = SU_TRUE;
+
+done:
+  SU_TEST_END(ctx);
+
+  su_tapcache_release(a);
+  su_tapcache_release(b);
+  su_tapcache_release(c);
+
+  su_iir_filt_finalize(&f1);
+  su_iir_filt_finalize(&f2);
+
+  if (ref != NULL)
+    free(ref);
+
+  return ok;
+}
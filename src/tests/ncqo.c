@@ -118,3 +118,244 @@ done:
   return ok;
 }
 
+
+SUBOOL
+su_test_ncqo_phasor(su_test_context_t *ctx)
+{
+  SUBOOL ok = SU_FALSE;
+  unsigned int p = 0;
+  SUFLOAT delta;
+  SUFLOAT diff;
+  SUFLOAT err = 0;
+  su_ncqo_t ref = su_ncqo_INITIALIZER;
+  su_ncqo_t ncqo = su_ncqo_INITIALIZER;
+
+  SU_TEST_START(ctx);
+
+  su_ncqo_init(&ref, .0123);
+  su_ncqo_init(&ncqo, .0123);
+  su_ncqo_set_phasor(&ncqo, SU_TRUE);
+
+  /* Free-running oscillator */
+  for (p = 0; p < SU_TEST_SIGNAL_BUFFER_SIZE; ++p) {
+    diff = SU_C_ABS(su_ncqo_read(&ref) - su_ncqo_read(&ncqo));
+    err = SU_MAX(err, diff);
+  }
+
+  SU_INFO("Free-running max error: %g\n", err);
+  SU_TEST_ASSERT(err < 1e-4);
+
+  /* Loop-like corrections on every sample. Output must follow the phase */
+  err = 0;
+  for (p = 0; p < SU_TEST_SIGNAL_BUFFER_SIZE; ++p) {
+    diff = SU_C_ABS(
+        SU_C_EXP(I * su_ncqo_get_phase(&ncqo)) - su_ncqo_read(&ncqo));
+    err = SU_MAX(err, diff);
+
+    delta = 1e-3 * SU_SIN(1e-2 * p);
+
+    su_ncqo_inc_angfreq(&ncqo, 1e-2 * delta);
+    su_ncqo_inc_phase(&ncqo, delta);
+  }
+
+  SU_INFO("Corrected max error: %g\n", err);
+  SU_TEST_ASSERT(err < 1e-3);
+
+  /* Large jumps */
+  su_ncqo_set_phase(&ncqo, PI / 3);
+  su_ncqo_set_freq(&ncqo, -.5);
+
+  SU_TEST_ASSERT(
+      SU_C_ABS(su_ncqo_read(&ncqo) - SU_C_EXP(I * PI / 3)) < 1e-4);
+  SU_TEST_ASSERT(
+      SU_C_ABS(su_ncqo_read(&ncqo) - SU_C_EXP(-I * PI / 6)) < 1e-4);
+
+  ok = SU_TRUE;
+
+done:
+  SU_TEST_END(ctx);
+
+  return ok;
+}
+
+SUBOOL
+su_test_ncqo_bulk(su_test_context_t *ctx)
+{
+  SUBOOL ok = SU_FALSE;
+  SUCOMPLEX *buffer = NULL;
+  unsigned int mode, p, n, i, j;
+  SUFLOAT delta;
+  SUFLOAT err = 0;
+  su_ncqo_t ref = su_ncqo_INITIALIZER;
+  su_ncqo_t ncqo = su_ncqo_INITIALIZER;
+  const SUSCOUNT size = 8192;
+
+  SU_TEST_START(ctx);
+
+  SU_TEST_ASSERT(buffer = malloc(size * sizeof (SUCOMPLEX)));
+
+  /* Regular, fixed and phasor NCQOs */
+  for (mode = 0; mode < 3; ++mode) {
+    if (mode == 1) {
+      su_ncqo_init_fixed(&ref, .0321);
+      su_ncqo_init_fixed(&ncqo, .0321);
+    } else {
+      su_ncqo_init(&ref, .0321);
+      su_ncqo_init(&ncqo, .0321);
+      su_ncqo_set_phasor(&ref, mode == 2);
+      su_ncqo_set_phasor(&ncqo, mode == 2);
+    }
+
+    /* Odd-sized calls, alternating between read and mix */
+    for (p = 0, i = 0; p < size; p += n, ++i) {
+      n = SU_MIN(size - p, 1 + (7 * p) % 251);
+
+      if (i & 1) {
+        su_ncqo_read_bulk(&ncqo, buffer + p, n);
+      } else {
+        for (j = 0; j < n; ++j)
+          buffer[p + j] = 1;
+        su_ncqo_mix_bulk(&ncqo, buffer + p, buffer + p, n);
+      }
+    }
+
+    err = 0;
+    for (p = 0; p < size; ++p) {
+      delta = SU_C_ABS(buffer[p] - su_ncqo_read(&ref));
+      err = SU_MAX(err, delta);
+    }
+
+    SU_INFO("Mode %d: max error %g\n", mode, err);
+    SU_TEST_ASSERT(err < 1e-3);
+  }
+
+  ok = SU_TRUE;
+
+done:
+  SU_TEST_END(ctx);
+
+  if (buffer != NULL)
+    free(buffer);
+
+  return ok;
+}
+
+SUBOOL
+su_test_ncqo_lut(su_test_context_t *ctx)
+{
+  SUBOOL ok = SU_FALSE;
+  SUCOMPLEX *buffer = NULL;
+  unsigned int p;
+  SUFLOAT diff;
+  SUFLOAT err = 0;
+  su_ncqo_t ref = su_ncqo_INITIALIZER;
+  su_lut_ncqo_t ncqo = su_lut_ncqo_INITIALIZER;
+  const SUSCOUNT size = 8192;
+
+  SU_TEST_START(ctx);
+
+  SU_TEST_ASSERT(buffer = malloc(size * sizeof (SUCOMPLEX)));
+
+  su_ncqo_init(&ref, -.0321);
+  su_lut_ncqo_init(&ncqo, -.0321);
+
+  SU_TEST_ASSERT(SU_ABS(su_lut_ncqo_get_freq(&ncqo) + .0321) < 1e-6);
+
+  for (p = 0; p < size / 2; ++p) {
+    diff = SU_C_ABS(su_lut_ncqo_read(&ncqo) - su_ncqo_read(&ref));
+    err = SU_MAX(err, diff);
+  }
+
+  for (p = 0; p < size / 2; ++p)
+    buffer[p] = 1;
+
+  su_lut_ncqo_mix_bulk(&ncqo, buffer, buffer, size / 2);
+
+  for (p = 0; p < size / 2; ++p) {
+    diff = SU_C_ABS(buffer[p] - su_ncqo_read(&ref));
+    err = SU_MAX(err, diff);
+  }
+
+  SU_INFO("Max error: %g\n", err);
+  SU_TEST_ASSERT(err < 1e-3);
+
+  ok = SU_TRUE;
+
+done:
+  SU_TEST_END(ctx);
+
+  if (buffer != NULL)
+    free(buffer);
+
+  return ok;
+}
+
+SUBOOL
+su_test_ncqo_fixed_point(su_test_context_t *ctx)
+{
+  SUBOOL ok = SU_FALSE;
+  unsigned int p;
+  SUFLOAT diff;
+  SUFLOAT err = 0;
+  su_ncqo_t ncqo = su_ncqo_INITIALIZER;
+  su_ncqo_t other = su_ncqo_INITIALIZER;
+
+  SU_TEST_START(ctx);
+
+  su_ncqo_init(&ncqo, .0123);
+  su_ncqo_set_fixed_point(&ncqo, SU_TRUE);
+
+  /* Output must follow the phase */
+  for (p = 0; p < SU_TEST_SIGNAL_BUFFER_SIZE; ++p) {
+    diff = SU_C_ABS(
+        SU_C_EXP(I * su_ncqo_get_phase(&ncqo)) - su_ncqo_read(&ncqo));
+    err = SU_MAX(err, diff);
+
+    if ((p & 0xff) == 0) {
+      su_ncqo_inc_angfreq(&ncqo, 1e-4);
+      su_ncqo_inc_phase(&ncqo, -1e-2);
+    }
+  }
+
+  SU_INFO("Max error: %g\n", err);
+  SU_TEST_ASSERT(err < 1e-4);
+
+  /* A full period must take us back to the same phase word exactly */
+  su_ncqo_init(&ncqo, 1. / 64);
+  su_ncqo_init(&other, 1. / 64);
+  su_ncqo_set_fixed_point(&ncqo, SU_TRUE);
+  su_ncqo_set_fixed_point(&other, SU_TRUE);
+  su_ncqo_set_phase(&other, PI / 5);
+
+  for (p = 0; p < 128 * 1000; ++p) {
+    su_ncqo_step(&ncqo);
+    su_ncqo_read(&other);
+  }
+
+  SU_TEST_ASSERT(ncqo.phase_word == 0);
+
+  diff = su_ncqo_get_phase(&other) - PI / 5;
+  SU_TEST_ASSERT(SU_ABS(diff) < 1e-6);
+
+  /* Frequency words that are not exact must not drift either */
+  su_ncqo_init(&ncqo, .0123);
+  su_ncqo_set_fixed_point(&ncqo, SU_TRUE);
+  SU_TEST_ASSERT(ncqo.phase_word == 0);
+
+  for (p = 0; p < SU_TEST_SIGNAL_BUFFER_SIZE; ++p)
+    if (p & 1)
+      su_ncqo_step(&ncqo);
+    else
+      su_ncqo_read(&ncqo);
+
+  SU_TEST_ASSERT(
+      ncqo.phase_word
+      == (uint32_t) (SU_TEST_SIGNAL_BUFFER_SIZE * ncqo.freq_word));
+
+  ok = SU_TRUE;
+
+done:
+  SU_TEST_END(ctx);
+
+  return ok;
+}
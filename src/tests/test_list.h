@@ -24,9 +24,20 @@
 
 /* NCQO tests */
 SUBOOL su_test_ncqo(su_test_context_t *ctx);
+SUBOOL su_test_ncqo_phasor(su_test_context_t *ctx);
+SUBOOL su_test_ncqo_bulk(su_test_context_t *ctx);
+SUBOOL su_test_ncqo_lut(su_test_context_t *ctx);
+SUBOOL su_test_ncqo_fixed_point(su_test_context_t *ctx);
 
 /* Filtering tests */
 SUBOOL su_test_butterworth_lpf(su_test_context_t *ctx);
+SUBOOL su_test_fir_overlap_save(su_test_context_t *ctx);
+SUBOOL su_test_fir_decim(su_test_context_t *ctx);
+SUBOOL su_test_cic_halfband(su_test_context_t *ctx);
+SUBOOL su_test_resampler(su_test_context_t *ctx);
+SUBOOL su_test_sos(su_test_context_t *ctx);
+SUBOOL su_test_rfilt(su_test_context_t *ctx);
+SUBOOL su_test_tapcache(su_test_context_t *ctx);
 
 /* AGC tests */
 SUBOOL su_test_agc_transient(su_test_context_t *ctx);
@@ -40,6 +51,17 @@ SUBOOL su_test_pll(su_test_context_t *ctx);
 SUBOOL su_test_block(su_test_context_t *ctx);
 SUBOOL su_test_block_plugging(su_test_context_t *ctx);
 SUBOOL su_test_block_flow_control(su_test_context_t *ctx);
+SUBOOL su_test_block_flow_control_spsc(su_test_context_t *ctx);
+SUBOOL su_test_block_flow_control_broadcast(su_test_context_t *ctx);
+SUBOOL su_test_block_shared_peek(su_test_context_t *ctx);
+SUBOOL su_test_block_mirrored_stream(su_test_context_t *ctx);
+SUBOOL su_test_block_pipeline(su_test_context_t *ctx);
+SUBOOL su_test_block_executor(su_test_context_t *ctx);
+SUBOOL su_test_block_executor_progress(su_test_context_t *ctx);
+SUBOOL su_test_block_fusion(su_test_context_t *ctx);
+SUBOOL su_test_block_stats(su_test_context_t *ctx);
+SUBOOL su_test_block_stream_resize(su_test_context_t *ctx);
+SUBOOL su_test_block_push(su_test_context_t *ctx);
 SUBOOL su_test_tuner(su_test_context_t *ctx);
 SUBOOL su_test_costas_block(su_test_context_t *ctx);
 SUBOOL su_test_rrc_block(su_test_context_t *ctx);
@@ -55,6 +77,7 @@ SUBOOL su_test_costas_qpsk_noisy(su_test_context_t *ctx);
 /* Clock recovery related tests */
 SUBOOL su_test_clock_recovery(su_test_context_t *ctx);
 SUBOOL su_test_clock_recovery_noisy(su_test_context_t *ctx);
+SUBOOL su_test_farrow(su_test_context_t *ctx);
 
 /* Channel detection tests */
 SUBOOL su_test_channel_detector_qpsk(su_test_context_t *ctx);